@@ -0,0 +1,114 @@
+/**
+ * @file bench_vector.c
+ *
+ * Measures the cost of resize policies on a workload which keeps adding and
+ * removing elements around the default shrink threshold. With the default
+ * policy every burst of removals shrinks the vector and the next burst of
+ * insertions grows it again.
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "vector.h"
+
+#define ELEMENT_SIZE 64
+#define LOW 200000
+#define HIGH 400000
+#define ROUNDS 50
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int _run(const char *name, const struct vector_policy *policy)
+{
+    static char el[ELEMENT_SIZE];
+
+    struct vector *v = vector_create(0, ELEMENT_SIZE);
+    if (v == NULL)
+        return -1;
+    if (vector_set_policy(v, policy) != 0)
+        goto destroy_;
+
+    // warm up so that the vector oscillates between the bounds
+    for (size_t i = 0; i < HIGH; ++i)
+        if (vector_insert(v, vector_size(v), el) != 0)
+            goto destroy_;
+
+    double start = _now();
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        while (vector_size(v) > LOW)
+            if (vector_remove(v, vector_size(v) - 1) != 0)
+                goto destroy_;
+        while (vector_size(v) < HIGH)
+            if (vector_insert(v, vector_size(v), el) != 0)
+                goto destroy_;
+    }
+
+    double elapsed = _now() - start;
+
+    struct vector_stats stats;
+    if (vector_get_stats(v, &stats) == 0)
+        printf("%-12s %10.2f ms %10" PRIu64 " grows %10" PRIu64 " shrinks "
+               "%14" PRIu64 " bytes reallocated\n", name, elapsed * 1e3,
+               stats.grows, stats.shrinks, stats.bytes_reallocated);
+    else
+        printf("%-12s %10.2f ms\n", name, elapsed * 1e3);
+
+    vector_destroy(v);
+    return 0;
+
+destroy_:
+    vector_destroy(v);
+    return -1;
+}
+
+int main(void)
+{
+    struct vector_policy never_shrink = VECTOR_POLICY_DEFAULT;
+    never_shrink.never_shrink = true;
+
+    printf("%d rounds of %d removals and insertions, %d byte elements\n",
+           ROUNDS, HIGH - LOW, ELEMENT_SIZE);
+
+    if (_run("default", &VECTOR_POLICY_DEFAULT) != 0 ||
+            _run("hysteresis", &VECTOR_POLICY_HYSTERESIS) != 0 ||
+            _run("never-shrink", &never_shrink) != 0) {
+        fprintf(stderr, "benchmark failed\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -26,7 +26,9 @@
  */
 
 #define _POSIX_SOURCE
+#include <errno.h>
 #include <limits.h>
+#include <stdbool.h>
 #include "binary_search.h"
 
 #include <stdio.h>
@@ -47,8 +49,10 @@ ssize_t binary_search(void *array, size_t ar_size, size_t el_size,
 
         if (cmp > 0)
             left = mid + 1;
-        else if (cmp < 0)
+        else if (cmp < 0 && mid > 0)
             right = mid - 1;
+        else if (cmp < 0)
+            break;
         else
             return mid;
     }
@@ -56,19 +60,14 @@ ssize_t binary_search(void *array, size_t ar_size, size_t el_size,
     return -1;
 }
 
-ssize_t binary_search_leftmost(void *array, size_t ar_size, size_t el_size,
-                               compare_fn_t compare, void *search)
-{
-    if (array == NULL || compare == NULL || search == NULL)
-        return -1;
-    if (array != NULL && (ar_size == 0 || ar_size > SSIZE_MAX || el_size == 0))
-        return -1;
-
-    size_t left = 0, right = ar_size;
+// both bounds below search the range [left, right) of the array
 
+static size_t _lower_bound(char *array, size_t el_size, compare_fn_t compare,
+                           void *search, size_t left, size_t right)
+{
     while (left < right) {
         size_t mid = left + (right - left) / 2;
-        ssize_t cmp = compare(search, (char *) array + (mid * el_size));
+        ssize_t cmp = compare(search, array + (mid * el_size));
 
         if (cmp > 0)
             left = mid + 1;
@@ -76,6 +75,35 @@ ssize_t binary_search_leftmost(void *array, size_t ar_size, size_t el_size,
             right = mid;
     }
 
+    return left;
+}
+
+static size_t _upper_bound(char *array, size_t el_size, compare_fn_t compare,
+                           void *search, size_t left, size_t right)
+{
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        ssize_t cmp = compare(search, array + (mid * el_size));
+
+        if (cmp < 0)
+            right = mid;
+        else
+            left = mid + 1;
+    }
+
+    return left;
+}
+
+ssize_t binary_search_leftmost(void *array, size_t ar_size, size_t el_size,
+                               compare_fn_t compare, void *search)
+{
+    if (array == NULL || compare == NULL || search == NULL)
+        return -1;
+    if (array != NULL && (ar_size == 0 || ar_size > SSIZE_MAX || el_size == 0))
+        return -1;
+
+    size_t left = _lower_bound(array, el_size, compare, search, 0, ar_size);
+
     void *leftmost = (char *) array + (left * el_size);
     if (left < ar_size && compare(search, leftmost) == 0)
         return left;
@@ -90,20 +118,419 @@ ssize_t binary_search_rightmost(void *array, size_t ar_size, size_t el_size,
     if (array != NULL && (ar_size == 0 || ar_size > SSIZE_MAX || el_size == 0))
         return -1;
 
+    size_t right = _upper_bound(array, el_size, compare, search, 0, ar_size);
+
+    void *rightmost = (char *) array + ((right - 1) * el_size);
+    if (right > 0 && compare(search, rightmost) == 0)
+        return right - 1;
+    return -1;
+}
+
+ssize_t binary_search_lower_bound(void *array, size_t ar_size, size_t el_size,
+                                  compare_fn_t compare, void *search)
+{
+    if (array == NULL || compare == NULL || search == NULL)
+        return -1;
+    if (ar_size > SSIZE_MAX || el_size == 0)
+        return -1;
+
+    return _lower_bound(array, el_size, compare, search, 0, ar_size);
+}
+
+ssize_t binary_search_upper_bound(void *array, size_t ar_size, size_t el_size,
+                                  compare_fn_t compare, void *search)
+{
+    if (array == NULL || compare == NULL || search == NULL)
+        return -1;
+    if (ar_size > SSIZE_MAX || el_size == 0)
+        return -1;
+
+    return _upper_bound(array, el_size, compare, search, 0, ar_size);
+}
+
+int binary_search_equal_range(void *array, size_t ar_size, size_t el_size,
+                              compare_fn_t compare, void *search,
+                              size_t *first, size_t *last)
+{
+    if (array == NULL || compare == NULL || search == NULL ||
+            first == NULL || last == NULL)
+        return -EINVAL;
+    if (ar_size > SSIZE_MAX || el_size == 0)
+        return -EINVAL;
+
     size_t left = 0, right = ar_size;
 
+    // both bounds take the same path until the first equal element, then the
+    // lower one is left of it and the upper one right of it
     while (left < right) {
         size_t mid = left + (right - left) / 2;
         ssize_t cmp = compare(search, (char *) array + (mid * el_size));
 
-        if (cmp < 0)
+        if (cmp > 0) {
+            left = mid + 1;
+        } else if (cmp < 0) {
             right = mid;
-        else
+        } else {
+            *first = _lower_bound(array, el_size, compare, search, left, mid);
+            *last = _upper_bound(array, el_size, compare, search, mid + 1,
+                                 right);
+            return 0;
+        }
+    }
+
+    *first = *last = left;
+
+    return 0;
+}
+
+// offset from the base of the element the step over a window of len elements
+// compares, the final check after the last step looks at the base itself
+static inline size_t _next_probe(size_t len)
+{
+    size_t half = len / 2;
+    return half > 0 ? half - 1 : 0;
+}
+
+// Branchless searches over arrays of plain numbers.
+//
+// The window [base, base + len) always contains the sought bound and is
+// halved with every step; the comparison result selects the upper half by
+// arithmetic which the compiler turns into a conditional move. The two
+// elements the next step may probe are prefetched before the current one
+// is compared.
+#define BRANCHLESS_SEARCH(suffix, type)                                     \
+static inline size_t _lower_bound_##suffix(const type *array, size_t size,  \
+                                           type search)                     \
+{                                                                           \
+    const type *base = array;                                               \
+    size_t len = size;                                                      \
+                                                                            \
+    while (len > 1) {                                                       \
+        size_t half = len / 2;                                              \
+        size_t next = _next_probe(len - half);                              \
+        __builtin_prefetch(&base[next]);                                    \
+        __builtin_prefetch(&base[half + next]);                             \
+        base += (base[half - 1] < search) * half;                           \
+        len -= half;                                                        \
+    }                                                                       \
+                                                                            \
+    return (base - array) + (*base < search);                               \
+}                                                                           \
+                                                                            \
+static inline size_t _upper_bound_##suffix(const type *array, size_t size,  \
+                                           type search)                     \
+{                                                                           \
+    const type *base = array;                                               \
+    size_t len = size;                                                      \
+                                                                            \
+    while (len > 1) {                                                       \
+        size_t half = len / 2;                                              \
+        size_t next = _next_probe(len - half);                              \
+        __builtin_prefetch(&base[next]);                                    \
+        __builtin_prefetch(&base[half + next]);                             \
+        base += !(search < base[half - 1]) * half;                          \
+        len -= half;                                                        \
+    }                                                                       \
+                                                                            \
+    return (base - array) + !(search < *base);                              \
+}                                                                           \
+                                                                            \
+ssize_t binary_search_leftmost_##suffix(const type *array, size_t ar_size,  \
+                                        type search)                        \
+{                                                                           \
+    if (array == NULL || ar_size == 0 || ar_size > SSIZE_MAX)               \
+        return -1;                                                          \
+                                                                            \
+    size_t left = _lower_bound_##suffix(array, ar_size, search);            \
+    if (left < ar_size && array[left] == search)                            \
+        return left;                                                        \
+    return -1;                                                              \
+}                                                                           \
+                                                                            \
+ssize_t binary_search_rightmost_##suffix(const type *array, size_t ar_size, \
+                                         type search)                       \
+{                                                                           \
+    if (array == NULL || ar_size == 0 || ar_size > SSIZE_MAX)               \
+        return -1;                                                          \
+                                                                            \
+    size_t right = _upper_bound_##suffix(array, ar_size, search);           \
+    if (right > 0 && array[right - 1] == search)                            \
+        return right - 1;                                                   \
+    return -1;                                                              \
+}
+
+BRANCHLESS_SEARCH(i32, int32_t)
+BRANCHLESS_SEARCH(i64, int64_t)
+BRANCHLESS_SEARCH(u64, uint64_t)
+BRANCHLESS_SEARCH(f64, double)
+
+// Number of searches advanced in lockstep by the batched functions, enough
+// to keep all the line fill buffers of a core busy.
+#define BATCH_GROUP 16
+
+// All the searches over the same array take the same number of steps with
+// the same window lengths, only their bases differ. Every step first makes
+// the comparison whose element was prefetched by the previous step for the
+// whole group, then prefetches the element the next step will compare.
+
+int binary_search_batch(void *array, size_t ar_size, size_t el_size,
+                        compare_fn_t compare, const void *keys, size_t count,
+                        ssize_t *out)
+{
+    if (array == NULL || compare == NULL || (count > 0 &&
+            (keys == NULL || out == NULL)))
+        return -EINVAL;
+    if (ar_size > SSIZE_MAX || el_size == 0)
+        return -EINVAL;
+
+    const char *elements = array;
+    const char *search = keys;
+
+    for (size_t group = 0; group < count; group += BATCH_GROUP) {
+        size_t base[BATCH_GROUP] = {0};
+        size_t n = count - group;
+        size_t len = ar_size;
+
+        if (n > BATCH_GROUP)
+            n = BATCH_GROUP;
+
+        if (ar_size == 0) {
+            for (size_t i = 0; i < n; ++i)
+                out[group + i] = -1;
+            continue;
+        }
+
+        while (len > 1) {
+            size_t half = len / 2;
+            size_t next = _next_probe(len - half);
+
+            for (size_t i = 0; i < n; ++i) {
+                const void *key = search + (group + i) * el_size;
+                const void *el = elements + (base[i] + half - 1) * el_size;
+                base[i] += (compare(key, el) > 0) * half;
+                __builtin_prefetch(elements + (base[i] + next) * el_size);
+            }
+
+            len -= half;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const void *key = search + (group + i) * el_size;
+            size_t left = base[i] + (compare(key, elements +
+                                             base[i] * el_size) > 0);
+            bool found = left < ar_size &&
+                compare(key, elements + left * el_size) == 0;
+            out[group + i] = found ? (ssize_t) left : -1;
+        }
+    }
+
+    return 0;
+}
+
+#define BATCH_SEARCH(suffix, type)                                          \
+int binary_search_batch_##suffix(const type *array, size_t ar_size,         \
+                                 const type *keys, size_t count,            \
+                                 ssize_t *out)                              \
+{                                                                           \
+    if (array == NULL || (count > 0 && (keys == NULL || out == NULL)))      \
+        return -EINVAL;                                                     \
+    if (ar_size > SSIZE_MAX)                                                \
+        return -EINVAL;                                                     \
+                                                                            \
+    for (size_t group = 0; group < count; group += BATCH_GROUP) {           \
+        size_t base[BATCH_GROUP] = {0};                                     \
+        size_t n = count - group;                                           \
+        const type *key = keys + group;                                     \
+        size_t len = ar_size;                                               \
+                                                                            \
+        if (n > BATCH_GROUP)                                                \
+            n = BATCH_GROUP;                                                \
+                                                                            \
+        if (ar_size == 0) {                                                 \
+            for (size_t i = 0; i < n; ++i)                                  \
+                out[group + i] = -1;                                        \
+            continue;                                                       \
+        }                                                                   \
+                                                                            \
+        while (len > 1) {                                                   \
+            size_t half = len / 2;                                          \
+            size_t next = _next_probe(len - half);                          \
+                                                                            \
+            for (size_t i = 0; i < n; ++i) {                                \
+                base[i] += (array[base[i] + half - 1] < key[i]) * half;     \
+                __builtin_prefetch(&array[base[i] + next]);                 \
+            }                                                               \
+                                                                            \
+            len -= half;                                                    \
+        }                                                                   \
+                                                                            \
+        for (size_t i = 0; i < n; ++i) {                                    \
+            size_t left = base[i] + (array[base[i]] < key[i]);              \
+            out[group + i] = left < ar_size && array[left] == key[i] ?      \
+                (ssize_t) left : -1;                                        \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    return 0;                                                               \
+}
+
+BATCH_SEARCH(i32, int32_t)
+BATCH_SEARCH(i64, int64_t)
+BATCH_SEARCH(u64, uint64_t)
+BATCH_SEARCH(f64, double)
+
+static inline bool _before(ssize_t cmp, bool upper)
+{
+    return upper ? cmp >= 0 : cmp > 0;
+}
+
+// Returns the index of the first element which is greater than or equal to
+// (upper == false), or greater than (upper == true) the search element.
+static size_t _gallop(char *array, size_t ar_size, size_t el_size,
+                      compare_fn_t compare, void *search, size_t hint,
+                      bool upper)
+{
+#define BEFORE(idx) _before(compare(search, array + (idx) * el_size), upper)
+
+    size_t left, right;
+
+    if (hint >= ar_size)
+        hint = ar_size - 1;
+
+    if (BEFORE(hint)) {
+        // the bound is right of the hint
+        size_t step = 1;
+        left = hint + 1;
+        while (step < ar_size - hint && BEFORE(hint + step)) {
+            left = hint + step + 1;
+            step *= 2;
+        }
+        right = step < ar_size - hint ? hint + step : ar_size;
+    } else {
+        // the bound is the hint or left of it
+        size_t step = 1;
+        right = hint;
+        while (step <= hint && !BEFORE(hint - step)) {
+            right = hint - step;
+            step *= 2;
+        }
+        left = step <= hint ? hint - step + 1 : 0;
+    }
+
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+
+        if (BEFORE(mid))
             left = mid + 1;
+        else
+            right = mid;
     }
 
+    return left;
+
+#undef BEFORE
+}
+
+ssize_t binary_search_gallop_leftmost(void *array, size_t ar_size,
+                                      size_t el_size, compare_fn_t compare,
+                                      void *search, size_t hint)
+{
+    if (array == NULL || compare == NULL || search == NULL)
+        return -1;
+    if (ar_size == 0 || ar_size > SSIZE_MAX || el_size == 0)
+        return -1;
+
+    size_t left = _gallop(array, ar_size, el_size, compare, search, hint,
+                          false);
+
+    void *leftmost = (char *) array + (left * el_size);
+    if (left < ar_size && compare(search, leftmost) == 0)
+        return left;
+    return -1;
+}
+
+ssize_t binary_search_gallop_rightmost(void *array, size_t ar_size,
+                                       size_t el_size, compare_fn_t compare,
+                                       void *search, size_t hint)
+{
+    if (array == NULL || compare == NULL || search == NULL)
+        return -1;
+    if (ar_size == 0 || ar_size > SSIZE_MAX || el_size == 0)
+        return -1;
+
+    size_t right = _gallop(array, ar_size, el_size, compare, search, hint,
+                           true);
+
     void *rightmost = (char *) array + ((right - 1) * el_size);
-    if (left > 0 && compare(search, rightmost) == 0)
+    if (right > 0 && compare(search, rightmost) == 0)
         return right - 1;
     return -1;
 }
+
+// The range [left, right) always contains the bound. The ratio is checked
+// rather than the values so that overflows, infinities and NaNs all end up
+// bisecting.
+#define INTERPOLATION_SEARCH(suffix, type)                                  \
+static size_t _interpolate_##suffix(const type *array, size_t ar_size,      \
+                                    type search, bool upper)                \
+{                                                                           \
+    size_t left = 0, right = ar_size;                                       \
+    bool bisect = false;                                                    \
+                                                                            \
+    while (left < right) {                                                  \
+        size_t len = right - left, pos = left + len / 2;                    \
+                                                                            \
+        if (!bisect) {                                                      \
+            type first = array[left], last = array[right - 1];              \
+            if (upper ? search < first : search <= first)                   \
+                return left;                                                \
+            if (upper ? search >= last : search > last)                     \
+                return right;                                               \
+                                                                            \
+            double ratio = ((double) search - (double) first) /             \
+                           ((double) last - (double) first);                \
+            if (ratio >= 0.0 && ratio <= 1.0)                               \
+                pos = left + (size_t) (ratio * (len - 1));                  \
+        }                                                                   \
+                                                                            \
+        if (upper ? array[pos] <= search : array[pos] < search)             \
+            left = pos + 1;                                                 \
+        else                                                                \
+            right = pos;                                                    \
+                                                                            \
+        bisect = right - left > len / 2;                                    \
+    }                                                                       \
+                                                                            \
+    return left;                                                            \
+}                                                                           \
+                                                                            \
+ssize_t binary_search_interpolation_leftmost_##suffix(const type *array,    \
+                                                      size_t ar_size,       \
+                                                      type search)          \
+{                                                                           \
+    if (array == NULL || ar_size == 0 || ar_size > SSIZE_MAX)               \
+        return -1;                                                          \
+                                                                            \
+    size_t left = _interpolate_##suffix(array, ar_size, search, false);     \
+    if (left < ar_size && array[left] == search)                            \
+        return left;                                                        \
+    return -1;                                                              \
+}                                                                           \
+                                                                            \
+ssize_t binary_search_interpolation_rightmost_##suffix(const type *array,   \
+                                                       size_t ar_size,      \
+                                                       type search)         \
+{                                                                           \
+    if (array == NULL || ar_size == 0 || ar_size > SSIZE_MAX)               \
+        return -1;                                                          \
+                                                                            \
+    size_t right = _interpolate_##suffix(array, ar_size, search, true);     \
+    if (right > 0 && array[right - 1] == search)                            \
+        return right - 1;                                                   \
+    return -1;                                                              \
+}
+
+INTERPOLATION_SEARCH(i32, int32_t)
+INTERPOLATION_SEARCH(i64, int64_t)
+INTERPOLATION_SEARCH(u64, uint64_t)
+INTERPOLATION_SEARCH(f64, double)
@@ -29,6 +29,7 @@
 #define __BINARY_SEARCH_H__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #ifdef __cplusplus
@@ -46,8 +47,345 @@ ssize_t binary_search_leftmost(void *array, size_t asize, size_t esize,
 ssize_t binary_search_rightmost(void *array, size_t asize, size_t esize,
                                 compare_fn_t compare, void *search);
 
+// Insertion points: the index of the first element not less than (lower) or
+// greater than (upper) the search element, asize if there is none. Return -1
+// on invalid arguments only.
+
+ssize_t binary_search_lower_bound(void *array, size_t asize, size_t esize,
+                                  compare_fn_t compare, void *search);
+
+ssize_t binary_search_upper_bound(void *array, size_t asize, size_t esize,
+                                  compare_fn_t compare, void *search);
+
+// Stores the range [first, last) of elements equal to the search element,
+// first == last is the insertion point if there is none. Both bounds share
+// the part of the descent before the first equal element is met. Returns 0
+// upon success and -EINVAL on invalid arguments.
+
+int binary_search_equal_range(void *array, size_t asize, size_t esize,
+                              compare_fn_t compare, void *search,
+                              size_t *first, size_t *last);
+
+// Typed variants of binary_search_leftmost() and binary_search_rightmost().
+// The keys are compared inline and the loop has no data dependent branches,
+// both possible next probes are prefetched so the memory latency of large
+// arrays overlaps with the current probe. NaN is never found.
+
+ssize_t binary_search_leftmost_i32(const int32_t *array, size_t asize,
+                                   int32_t search);
+ssize_t binary_search_rightmost_i32(const int32_t *array, size_t asize,
+                                    int32_t search);
+
+ssize_t binary_search_leftmost_i64(const int64_t *array, size_t asize,
+                                   int64_t search);
+ssize_t binary_search_rightmost_i64(const int64_t *array, size_t asize,
+                                    int64_t search);
+
+ssize_t binary_search_leftmost_u64(const uint64_t *array, size_t asize,
+                                   uint64_t search);
+ssize_t binary_search_rightmost_u64(const uint64_t *array, size_t asize,
+                                    uint64_t search);
+
+ssize_t binary_search_leftmost_f64(const double *array, size_t asize,
+                                   double search);
+ssize_t binary_search_rightmost_f64(const double *array, size_t asize,
+                                    double search);
+
+// Same as binary_search_leftmost() and binary_search_rightmost() but the
+// search starts at the hint and gallops away from it in exponentially growing
+// steps before it bisects, so it takes O(log d) comparisons where d is the
+// distance of the result from the hint. A hint past the end is clamped.
+
+ssize_t binary_search_gallop_leftmost(void *array, size_t asize, size_t esize,
+                                      compare_fn_t compare, void *search,
+                                      size_t hint);
+
+ssize_t binary_search_gallop_rightmost(void *array, size_t asize,
+                                       size_t esize, compare_fn_t compare,
+                                       void *search, size_t hint);
+
+// Interpolation search, the probe is placed where the key would be if the
+// values were spread uniformly between the ends of the current range. That
+// takes O(log log n) probes on uniform data. Whenever a probe fails to halve
+// the range the next one bisects, so the worst case stays O(log n).
+
+ssize_t binary_search_interpolation_leftmost_i32(const int32_t *array,
+                                                 size_t asize, int32_t search);
+ssize_t binary_search_interpolation_rightmost_i32(const int32_t *array,
+                                                  size_t asize,
+                                                  int32_t search);
+
+ssize_t binary_search_interpolation_leftmost_i64(const int64_t *array,
+                                                 size_t asize, int64_t search);
+ssize_t binary_search_interpolation_rightmost_i64(const int64_t *array,
+                                                  size_t asize,
+                                                  int64_t search);
+
+ssize_t binary_search_interpolation_leftmost_u64(const uint64_t *array,
+                                                 size_t asize,
+                                                 uint64_t search);
+ssize_t binary_search_interpolation_rightmost_u64(const uint64_t *array,
+                                                  size_t asize,
+                                                  uint64_t search);
+
+ssize_t binary_search_interpolation_leftmost_f64(const double *array,
+                                                 size_t asize, double search);
+ssize_t binary_search_interpolation_rightmost_f64(const double *array,
+                                                  size_t asize, double search);
+
+// Batched variants of binary_search_leftmost(), out[i] receives the result
+// for keys[i]. Groups of searches advance in lockstep and each one prefetches
+// its next probe before the group moves on, so the cache misses of the whole
+// group overlap instead of stalling one after another. Return 0 upon success
+// and -EINVAL on invalid arguments.
+
+int binary_search_batch(void *array, size_t asize, size_t esize,
+                        compare_fn_t compare, const void *keys, size_t count,
+                        ssize_t *out);
+
+int binary_search_batch_i32(const int32_t *array, size_t asize,
+                            const int32_t *keys, size_t count, ssize_t *out);
+int binary_search_batch_i64(const int64_t *array, size_t asize,
+                            const int64_t *keys, size_t count, ssize_t *out);
+int binary_search_batch_u64(const uint64_t *array, size_t asize,
+                            const uint64_t *keys, size_t count, ssize_t *out);
+int binary_search_batch_f64(const double *array, size_t asize,
+                            const double *keys, size_t count, ssize_t *out);
+
+// Generates binary searches specialised for one element type:
+//
+//   ssize_t name(const T *array, size_t asize, const T *search);
+//   ssize_t name##_leftmost(const T *array, size_t asize, const T *search);
+//   ssize_t name##_rightmost(const T *array, size_t asize, const T *search);
+//   ssize_t name##_lower_bound(const T *array, size_t asize, const T *search);
+//   ssize_t name##_upper_bound(const T *array, size_t asize, const T *search);
+//
+// cmp is a function or a macro called as cmp(search, element) with pointers
+// to T, returning a negative, zero or positive value like compare_fn_t. The
+// functions are static inline so the comparison gets inlined and the element
+// size is a constant. Results are the same as of the generic functions.
+#define BINARY_SEARCH_DEFINE(name, T, cmp)                                  \
+static inline size_t name##_lower_bound_(const T *array, size_t right,      \
+                                         const T *search)                   \
+{                                                                           \
+    size_t left = 0;                                                        \
+    while (left < right) {                                                  \
+        size_t mid = left + (right - left) / 2;                             \
+        if (cmp(search, &array[mid]) > 0)                                   \
+            left = mid + 1;                                                 \
+        else                                                                \
+            right = mid;                                                    \
+    }                                                                       \
+    return left;                                                            \
+}                                                                           \
+                                                                            \
+static inline size_t name##_upper_bound_(const T *array, size_t right,      \
+                                         const T *search)                   \
+{                                                                           \
+    size_t left = 0;                                                        \
+    while (left < right) {                                                  \
+        size_t mid = left + (right - left) / 2;                             \
+        if (cmp(search, &array[mid]) < 0)                                   \
+            right = mid;                                                    \
+        else                                                                \
+            left = mid + 1;                                                 \
+    }                                                                       \
+    return left;                                                            \
+}                                                                           \
+                                                                            \
+static inline ssize_t name(const T *array, size_t asize, const T *search)   \
+{                                                                           \
+    if (array == NULL || search == NULL || asize == 0 ||                    \
+            asize > SIZE_MAX / 2)                                           \
+        return -1;                                                          \
+                                                                            \
+    size_t left = 0, right = asize - 1;                                     \
+    while (left <= right) {                                                 \
+        size_t mid = left + (right - left) / 2;                             \
+        ssize_t cmp_ = cmp(search, &array[mid]);                            \
+        if (cmp_ > 0)                                                       \
+            left = mid + 1;                                                 \
+        else if (cmp_ < 0 && mid > 0)                                       \
+            right = mid - 1;                                                \
+        else if (cmp_ < 0)                                                  \
+            break;                                                          \
+        else                                                                \
+            return mid;                                                     \
+    }                                                                       \
+    return -1;                                                              \
+}                                                                           \
+                                                                            \
+static inline ssize_t name##_leftmost(const T *array, size_t asize,         \
+                                      const T *search)                      \
+{                                                                           \
+    if (array == NULL || search == NULL || asize == 0 ||                    \
+            asize > SIZE_MAX / 2)                                           \
+        return -1;                                                          \
+                                                                            \
+    size_t left = name##_lower_bound_(array, asize, search);                \
+    if (left < asize && cmp(search, &array[left]) == 0)                     \
+        return left;                                                        \
+    return -1;                                                              \
+}                                                                           \
+                                                                            \
+static inline ssize_t name##_rightmost(const T *array, size_t asize,        \
+                                       const T *search)                     \
+{                                                                           \
+    if (array == NULL || search == NULL || asize == 0 ||                    \
+            asize > SIZE_MAX / 2)                                           \
+        return -1;                                                          \
+                                                                            \
+    size_t right = name##_upper_bound_(array, asize, search);               \
+    if (right > 0 && cmp(search, &array[right - 1]) == 0)                   \
+        return right - 1;                                                   \
+    return -1;                                                              \
+}                                                                           \
+                                                                            \
+static inline ssize_t name##_lower_bound(const T *array, size_t asize,      \
+                                         const T *search)                   \
+{                                                                           \
+    if (array == NULL || search == NULL || asize > SIZE_MAX / 2)            \
+        return -1;                                                          \
+    return name##_lower_bound_(array, asize, search);                       \
+}                                                                           \
+                                                                            \
+static inline ssize_t name##_upper_bound(const T *array, size_t asize,      \
+                                         const T *search)                   \
+{                                                                           \
+    if (array == NULL || search == NULL || asize > SIZE_MAX / 2)            \
+        return -1;                                                          \
+    return name##_upper_bound_(array, asize, search);                       \
+}
+
 #ifdef __cplusplus
 }
+
+// C++ overloads of the searches for any element type. The comparator is
+// called as compare(search, element) and returns a negative, zero or positive
+// value; without one the elements are compared with operator<. Being
+// templates the comparison gets inlined, results are the same as of the
+// generic functions.
+
+namespace binary_search_detail {
+
+struct three_way {
+    template <typename T>
+    int operator()(const T &a, const T &b) const
+    {
+        return (b < a) - (a < b);
+    }
+};
+
+template <typename T, typename Compare>
+inline size_t lower_bound(const T *array, size_t right, const T &search,
+                          Compare &compare)
+{
+    size_t left = 0;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        if (compare(search, array[mid]) > 0)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+    return left;
+}
+
+template <typename T, typename Compare>
+inline size_t upper_bound(const T *array, size_t right, const T &search,
+                          Compare &compare)
+{
+    size_t left = 0;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        if (compare(search, array[mid]) < 0)
+            right = mid;
+        else
+            left = mid + 1;
+    }
+    return left;
+}
+
+inline bool invalid(const void *array, size_t asize)
+{
+    return array == nullptr || asize == 0 || asize > SIZE_MAX / 2;
+}
+
+} // namespace binary_search_detail
+
+template <typename T, typename Compare = binary_search_detail::three_way>
+inline ssize_t binary_search(const T *array, size_t asize, const T &search,
+                             Compare compare = Compare())
+{
+    if (binary_search_detail::invalid(array, asize))
+        return -1;
+
+    size_t left = 0, right = asize - 1;
+    while (left <= right) {
+        size_t mid = left + (right - left) / 2;
+        auto cmp = compare(search, array[mid]);
+        if (cmp > 0)
+            left = mid + 1;
+        else if (cmp < 0 && mid > 0)
+            right = mid - 1;
+        else if (cmp < 0)
+            break;
+        else
+            return mid;
+    }
+    return -1;
+}
+
+template <typename T, typename Compare = binary_search_detail::three_way>
+inline ssize_t binary_search_leftmost(const T *array, size_t asize,
+                                      const T &search,
+                                      Compare compare = Compare())
+{
+    if (binary_search_detail::invalid(array, asize))
+        return -1;
+
+    size_t left = binary_search_detail::lower_bound(array, asize, search,
+                                                    compare);
+    if (left < asize && compare(search, array[left]) == 0)
+        return left;
+    return -1;
+}
+
+template <typename T, typename Compare = binary_search_detail::three_way>
+inline ssize_t binary_search_rightmost(const T *array, size_t asize,
+                                       const T &search,
+                                       Compare compare = Compare())
+{
+    if (binary_search_detail::invalid(array, asize))
+        return -1;
+
+    size_t right = binary_search_detail::upper_bound(array, asize, search,
+                                                     compare);
+    if (right > 0 && compare(search, array[right - 1]) == 0)
+        return right - 1;
+    return -1;
+}
+
+template <typename T, typename Compare = binary_search_detail::three_way>
+inline ssize_t binary_search_lower_bound(const T *array, size_t asize,
+                                         const T &search,
+                                         Compare compare = Compare())
+{
+    if (array == nullptr || asize > SIZE_MAX / 2)
+        return -1;
+    return binary_search_detail::lower_bound(array, asize, search, compare);
+}
+
+template <typename T, typename Compare = binary_search_detail::three_way>
+inline ssize_t binary_search_upper_bound(const T *array, size_t asize,
+                                         const T &search,
+                                         Compare compare = Compare())
+{
+    if (array == nullptr || asize > SIZE_MAX / 2)
+        return -1;
+    return binary_search_detail::upper_bound(array, asize, search, compare);
+}
+
 #endif // __cplusplus
 
 #endif // __BINARY_SEARCH_H__
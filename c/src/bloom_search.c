@@ -0,0 +1,223 @@
+/**
+ * @file bloom_search.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "bloom_search.h"
+
+#define BLOCK_BYTES 64
+#define BLOCK_BITS (BLOCK_BYTES * CHAR_BIT)
+#define BLOCK_WORDS (BLOCK_BYTES / sizeof(uint64_t))
+
+#define DEFAULT_BITS_PER_KEY 10
+#define MAX_HASHES 16
+
+struct bloom_search {
+    const char *array;
+    size_t el_count;
+    size_t el_size;
+    hash_fn_t hash;
+
+    uint64_t *blocks;
+    size_t block_count;
+    unsigned int hashes;
+};
+
+// murmur3 finalizer, spreads the entropy of the user hash over all the bits
+static inline uint64_t _mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// the upper half picks the block, the lower half the bits within it
+static inline uint64_t *_block(struct bloom_search *bs, uint64_t h)
+{
+    size_t block = (size_t) (((h >> 32) * bs->block_count) >> 32);
+    return bs->blocks + (block * BLOCK_WORDS);
+}
+
+static inline unsigned int _bit(uint64_t h, unsigned int i)
+{
+    uint32_t h1 = (uint32_t) h, h2 = (uint32_t) (h >> 17) | 1;
+    return (h1 + i * h2) % BLOCK_BITS;
+}
+
+// optimal number of hashes is ln 2 times the bits per key
+static unsigned int _hashes(size_t bits, size_t keys)
+{
+    double hashes = 0.693 * (double) bits / (double) keys + 0.5;
+
+    if (hashes < 1)
+        return 1;
+    if (hashes > MAX_HASHES)
+        return MAX_HASHES;
+    return (unsigned int) hashes;
+}
+
+struct bloom_search *bloom_search_create(const void *array, size_t asize,
+                                         size_t esize, hash_fn_t hash,
+                                         size_t budget)
+{
+    if (array == NULL || asize == 0 || asize > SSIZE_MAX || esize == 0 ||
+            hash == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t block_count = budget / BLOCK_BYTES;
+    if (budget == 0) {
+        if (asize > SIZE_MAX / DEFAULT_BITS_PER_KEY)
+            block_count = SIZE_MAX / BLOCK_BITS;
+        else
+            block_count = (asize * DEFAULT_BITS_PER_KEY + BLOCK_BITS - 1) /
+                          BLOCK_BITS;
+    }
+    // blocks are picked with the upper 32 bits of the hash
+    if (block_count == 0)
+        block_count = 1;
+    if (block_count > UINT32_MAX)
+        block_count = UINT32_MAX;
+
+    struct bloom_search *bs = malloc(sizeof(*bs));
+    if (bs == NULL)
+        goto return_enomem_;
+
+    bs->blocks = aligned_alloc(BLOCK_BYTES, block_count * BLOCK_BYTES);
+    if (bs->blocks == NULL)
+        goto free_bs_;
+
+    bs->array = array;
+    bs->el_count = asize;
+    bs->el_size = esize;
+    bs->hash = hash;
+    bs->block_count = block_count;
+    bs->hashes = _hashes(block_count * BLOCK_BITS, asize);
+
+    for (size_t i = 0; i < block_count * BLOCK_WORDS; ++i)
+        bs->blocks[i] = 0;
+
+    for (size_t i = 0; i < asize; ++i) {
+        uint64_t h = _mix(hash(bs->array + i * esize));
+        uint64_t *block = _block(bs, h);
+
+        for (unsigned int k = 0; k < bs->hashes; ++k) {
+            unsigned int bit = _bit(h, k);
+            block[bit / 64] |= (uint64_t) 1 << (bit % 64);
+        }
+    }
+
+    return bs;
+
+free_bs_:
+    free(bs);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+}
+
+void bloom_search_destroy(struct bloom_search *bs)
+{
+    if (bs == NULL)
+        return;
+
+    free(bs->blocks);
+    free(bs);
+}
+
+int bloom_search_stats(struct bloom_search *bs,
+                       struct bloom_search_stats *stats)
+{
+    if (bs == NULL || stats == NULL)
+        return -EINVAL;
+
+    // a missing key passes when all of its bits are set in its block
+    double fpr = 0;
+    for (size_t b = 0; b < bs->block_count; ++b) {
+        unsigned int set = 0;
+        for (size_t w = 0; w < BLOCK_WORDS; ++w)
+            set += __builtin_popcountll(bs->blocks[b * BLOCK_WORDS + w]);
+
+        double fill = (double) set / BLOCK_BITS, pass = 1;
+        for (unsigned int k = 0; k < bs->hashes; ++k)
+            pass *= fill;
+        fpr += pass;
+    }
+
+    stats->bytes = bs->block_count * BLOCK_BYTES;
+    stats->hashes = bs->hashes;
+    stats->bits_per_key = (double) (bs->block_count * BLOCK_BITS) /
+                          (double) bs->el_count;
+    stats->fpr = fpr / (double) bs->block_count;
+
+    return 0;
+}
+
+bool bloom_search_may_contain(struct bloom_search *bs, const void *search)
+{
+    if (bs == NULL || search == NULL)
+        return false;
+
+    uint64_t h = _mix(bs->hash(search));
+    const uint64_t *block = _block(bs, h);
+
+    for (unsigned int k = 0; k < bs->hashes; ++k) {
+        unsigned int bit = _bit(h, k);
+        if ((block[bit / 64] & ((uint64_t) 1 << (bit % 64))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+ssize_t bloom_search_leftmost(struct bloom_search *bs, compare_fn_t compare,
+                              const void *search)
+{
+    if (!bloom_search_may_contain(bs, search))
+        return -1;
+
+    return binary_search_leftmost((void *) bs->array, bs->el_count,
+                                  bs->el_size, compare, (void *) search);
+}
+
+ssize_t bloom_search_rightmost(struct bloom_search *bs, compare_fn_t compare,
+                               const void *search)
+{
+    if (!bloom_search_may_contain(bs, search))
+        return -1;
+
+    return binary_search_rightmost((void *) bs->array, bs->el_count,
+                                   bs->el_size, compare, (void *) search);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file bloom_search.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BLOOM_SEARCH_H__
+#define __BLOOM_SEARCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Returns a hash of an element, equal elements must hash the same. */
+typedef uint64_t (*hash_fn_t)(const void *element);
+
+/** Size and accuracy of a filter. */
+struct bloom_search_stats {
+    size_t bytes;           //!< memory taken by the filter bits
+    unsigned int hashes;    //!< bits set per key
+    double bits_per_key;    //!< filter bits per element of the array
+    double fpr;             //!< probability that a missing key passes
+};
+
+struct bloom_search;
+
+/** Builds a blocked Bloom filter over the elements of a sorted array.
+ *
+ * Every key sets a few bits within one 64 byte block picked by its hash, so
+ * checking the filter costs a single cache miss. Searches for keys rejected
+ * by the filter return without touching the array, only the keys passing
+ * it are looked up with a binary search.
+ *
+ * The hash is mixed again before use, so a weak one (e.g. the value of an
+ * integer key) is fine. The filter refers to the array which has to outlive
+ * it and stay unchanged.
+ *
+ * @param[in] array the array sorted in ascending order
+ * @param[in] asize number of elements in the array
+ * @param[in] esize size of a single element
+ * @param[in] hash function returning a hash of an element
+ * @param[in] budget size of the filter in bytes, rounded down to whole
+ *            blocks; if 0 then 10 bits per element are used, giving a false
+ *            positive rate of about 1%
+ *
+ * @return pointer to the filter or NULL on error, @c errno is set to
+ *         indicate the error
+ */
+struct bloom_search *bloom_search_create(const void *array, size_t asize,
+                                         size_t esize, hash_fn_t hash,
+                                         size_t budget);
+
+/** Destroys the filter.
+ *
+ * @param[in] bs pointer to the filter
+ */
+void bloom_search_destroy(struct bloom_search *bs);
+
+/** Reports the size of the filter and its false positive rate.
+ *
+ * The rate is the expected share of missing keys passing the filter, taken
+ * from the bits actually set.
+ *
+ * @param[in] bs pointer to the filter
+ * @param[out] stats the statistics
+ *
+ * @return 0 on success, -EINVAL on invalid arguments
+ */
+int bloom_search_stats(struct bloom_search *bs,
+                       struct bloom_search_stats *stats);
+
+/** Checks the filter only.
+ *
+ * @param[in] bs pointer to the filter
+ * @param[in] search the element to look for
+ *
+ * @return false if the element is certainly not in the array
+ */
+bool bloom_search_may_contain(struct bloom_search *bs, const void *search);
+
+/** Same as binary_search_leftmost() on the filtered array.
+ *
+ * @param[in] bs pointer to the filter
+ * @param[in] compare comparison function
+ * @param[in] search the element to look for
+ *
+ * @return position of the first equal element or -1 if there is none
+ */
+ssize_t bloom_search_leftmost(struct bloom_search *bs, compare_fn_t compare,
+                              const void *search);
+
+/** Same as binary_search_rightmost() on the filtered array.
+ *
+ * @param[in] bs pointer to the filter
+ * @param[in] compare comparison function
+ * @param[in] search the element to look for
+ *
+ * @return position of the last equal element or -1 if there is none
+ */
+ssize_t bloom_search_rightmost(struct bloom_search *bs, compare_fn_t compare,
+                               const void *search);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __BLOOM_SEARCH_H__
@@ -0,0 +1,263 @@
+/**
+ * @file cascade.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cascade.h"
+
+// followed by a copy of the element so that walking down the levels touches
+// a single cache line per array; aligned like malloc() memory so that the
+// copies are aligned for any element type
+struct cascade_entry {
+    _Alignas(max_align_t)
+    size_t own;     // elements of the level's own array before the entry
+    size_t bridge;  // twice the elements taken from the level below before it
+};
+
+struct cascade {
+    const char **arrays;
+    size_t *sizes;
+    size_t count;
+    size_t el_size;
+    size_t stride;
+    compare_fn_t compare;
+
+    // every level ends with a sentinel entry, levels[i] has lengths[i]
+    // entries plus the sentinel
+    char **levels;
+    size_t *lengths;
+    char *entries;
+};
+
+static inline struct cascade_entry *_entry(struct cascade *cascade,
+                                           char *level, size_t k)
+{
+    return (struct cascade_entry *) (level + k * cascade->stride);
+}
+
+static inline void *_element(struct cascade *cascade, char *level, size_t k)
+{
+    return level + k * cascade->stride + sizeof(struct cascade_entry);
+}
+
+// every second entry of the level below, starting with the second one so
+// that the entry taken as the c-th is preceded by exactly 2c + 1 others
+static inline size_t _promoted(size_t below)
+{
+    return below / 2;
+}
+
+static void _build_level(struct cascade *cascade, size_t i)
+{
+    size_t esize = cascade->el_size;
+    const char *own = cascade->arrays[i];
+    size_t own_size = cascade->sizes[i];
+    char *below = i + 1 < cascade->count ? cascade->levels[i + 1] : NULL;
+    size_t promoted = i + 1 < cascade->count ?
+                      _promoted(cascade->lengths[i + 1]) : 0;
+    char *level = cascade->levels[i];
+
+    size_t a = 0, c = 0, k = 0;
+    for (; a < own_size || c < promoted; ++k) {
+        struct cascade_entry *entry = _entry(cascade, level, k);
+        entry->own = a;
+        entry->bridge = 2 * c;
+
+        const void *element;
+        if (c == promoted || (a < own_size &&
+                cascade->compare(own + a * esize,
+                                 _element(cascade, below, 2 * c + 1)) <= 0))
+            element = own + a++ * esize;
+        else
+            element = _element(cascade, below, 2 * c++ + 1);
+        memcpy(_element(cascade, level, k), element, esize);
+    }
+
+    struct cascade_entry *sentinel = _entry(cascade, level, k);
+    sentinel->own = own_size;
+    sentinel->bridge = 2 * c;
+}
+
+struct cascade *cascade_create(const void * const *arrays, const size_t *sizes,
+                               size_t count, size_t esize,
+                               compare_fn_t compare)
+{
+    if (arrays == NULL || sizes == NULL || count == 0 || esize == 0 ||
+            compare == NULL || count > SIZE_MAX / sizeof(void *))
+        goto return_einval_;
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (sizes[i] > 0 && arrays[i] == NULL)
+            goto return_einval_;
+        if (sizes[i] > SSIZE_MAX / esize || sizes[i] > SSIZE_MAX - total)
+            goto return_einval_;
+        total += sizes[i];
+    }
+
+    // no level is longer than all the arrays together, the stride is
+    // rounded up so that every entry and element copy stays aligned
+    size_t align = _Alignof(struct cascade_entry);
+    if (esize > SIZE_MAX - sizeof(struct cascade_entry) - align)
+        goto return_einval_;
+    size_t stride = (sizeof(struct cascade_entry) + esize + align - 1) /
+                    align * align;
+    if (total + 1 > SIZE_MAX / stride / count)
+        goto return_einval_;
+
+    struct cascade *cascade = calloc(1, sizeof(*cascade));
+    if (cascade == NULL)
+        goto return_enomem_;
+
+    cascade->count = count;
+    cascade->el_size = esize;
+    cascade->stride = stride;
+    cascade->compare = compare;
+    cascade->arrays = malloc(count * sizeof(*cascade->arrays));
+    cascade->sizes = malloc(count * sizeof(*cascade->sizes));
+    cascade->levels = malloc(count * sizeof(*cascade->levels));
+    cascade->lengths = malloc(count * sizeof(*cascade->lengths));
+    if (cascade->arrays == NULL || cascade->sizes == NULL ||
+            cascade->levels == NULL || cascade->lengths == NULL)
+        goto destroy_cascade_;
+
+    size_t entries = 0;
+    for (size_t i = count; i-- > 0;) {
+        cascade->arrays[i] = arrays[i];
+        cascade->sizes[i] = sizes[i];
+        cascade->lengths[i] = sizes[i] + (i + 1 < count ?
+                              _promoted(cascade->lengths[i + 1]) : 0);
+        entries += cascade->lengths[i] + 1;
+    }
+
+    cascade->entries = malloc(entries * stride);
+    if (cascade->entries == NULL)
+        goto destroy_cascade_;
+
+    entries = 0;
+    for (size_t i = 0; i < count; ++i) {
+        cascade->levels[i] = cascade->entries + entries * stride;
+        entries += cascade->lengths[i] + 1;
+    }
+
+    for (size_t i = count; i-- > 0;)
+        _build_level(cascade, i);
+
+    return cascade;
+
+destroy_cascade_:
+    cascade_destroy(cascade);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+return_einval_:
+    errno = EINVAL;
+    return NULL;
+}
+
+void cascade_destroy(struct cascade *cascade)
+{
+    if (cascade == NULL)
+        return;
+
+    free(cascade->entries);
+    free(cascade->lengths);
+    free(cascade->levels);
+    free(cascade->sizes);
+    free(cascade->arrays);
+    free(cascade);
+}
+
+size_t cascade_count(struct cascade *cascade)
+{
+    return cascade == NULL ? 0 : cascade->count;
+}
+
+int cascade_lower_bound(struct cascade *cascade, const void *search,
+                        size_t *positions)
+{
+    if (cascade == NULL || search == NULL || positions == NULL)
+        return -EINVAL;
+
+    compare_fn_t compare = cascade->compare;
+    char *level = cascade->levels[0];
+
+    size_t left = 0, right = cascade->lengths[0];
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+
+        if (compare(search, _element(cascade, level, mid)) > 0)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+
+    for (size_t i = 0;; ++i) {
+        struct cascade_entry *entry = _entry(cascade, level, left);
+        positions[i] = entry->own;
+        if (i + 1 == cascade->count)
+            break;
+
+        // all entries of the level below up to the bridge are less than
+        // search and the one after the next isn't
+        size_t next = entry->bridge;
+        level = cascade->levels[i + 1];
+        if (next < cascade->lengths[i + 1] &&
+                compare(search, _element(cascade, level, next)) > 0)
+            ++next;
+        left = next;
+    }
+
+    return 0;
+}
+
+int cascade_search_leftmost(struct cascade *cascade, const void *search,
+                            ssize_t *positions)
+{
+    // the insertion points are overwritten in place
+    int ret = cascade_lower_bound(cascade, search, (size_t *) positions);
+    if (ret < 0)
+        return ret;
+
+    for (size_t i = 0; i < cascade->count; ++i) {
+        size_t position = (size_t) positions[i];
+
+        if (position == cascade->sizes[i] ||
+                cascade->compare(search, cascade->arrays[i] +
+                                 position * cascade->el_size) != 0)
+            positions[i] = -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file cascade.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CASCADE_H__
+#define __CASCADE_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct cascade;
+
+/** Builds a fractional cascading catalog over a list of sorted arrays.
+ *
+ * Every level holds the elements of its array merged with every second
+ * element of the level below, each entry remembering how many elements of
+ * its own array and of the level below precede it. A search bisects the
+ * first level only and then walks down the levels with at most one extra
+ * comparison per array.
+ *
+ * The levels hold copies of the elements, the catalog still refers to the
+ * arrays which have to outlive it and stay unchanged. The elements are
+ * compared with compare(x, y), the same function is used for the searches.
+ *
+ * @param[in] arrays the arrays sorted in ascending order
+ * @param[in] sizes number of elements in each of the arrays, arrays can be
+ *            empty (their pointer may be NULL then)
+ * @param[in] count number of arrays
+ * @param[in] esize size of a single element
+ * @param[in] compare comparison function
+ *
+ * @return pointer to the catalog or NULL on error, @c errno is set to
+ *         indicate the error
+ */
+struct cascade *cascade_create(const void * const *arrays, const size_t *sizes,
+                               size_t count, size_t esize,
+                               compare_fn_t compare);
+
+/** Destroys the catalog.
+ *
+ * @param[in] cascade pointer to the catalog
+ */
+void cascade_destroy(struct cascade *cascade);
+
+/** Returns the number of arrays in the catalog.
+ *
+ * @param[in] cascade pointer to the catalog
+ *
+ * @return number of arrays
+ */
+size_t cascade_count(struct cascade *cascade);
+
+/** Finds the insertion point of an element in every array.
+ *
+ * Stores in positions[i] the same value binary_search_lower_bound() would
+ * return for the i-th array.
+ *
+ * @param[in] cascade pointer to the catalog
+ * @param[in] search the element to look for
+ * @param[out] positions array of cascade_count() positions
+ *
+ * @return 0 on success, -EINVAL on invalid arguments
+ */
+int cascade_lower_bound(struct cascade *cascade, const void *search,
+                        size_t *positions);
+
+/** Finds the first element equal to the searched one in every array.
+ *
+ * Stores in positions[i] the same value binary_search_leftmost() would
+ * return for the i-th array, -1 where the element isn't present.
+ *
+ * @param[in] cascade pointer to the catalog
+ * @param[in] search the element to look for
+ * @param[out] positions array of cascade_count() positions
+ *
+ * @return 0 on success, -EINVAL on invalid arguments
+ */
+int cascade_search_leftmost(struct cascade *cascade, const void *search,
+                            ssize_t *positions);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __CASCADE_H__
@@ -0,0 +1,188 @@
+/**
+ * @file concurrent_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "concurrent_vector.h"
+
+#define SEGMENT_COUNT (sizeof(size_t) * CHAR_BIT)
+
+// Segment k holds first_segment << k elements followed by a flag per element
+// which is set once the element is completely written.
+
+struct concurrent_vector {
+    size_t el_size;
+    size_t first_segment;
+    atomic_size_t count;
+    _Atomic(char *) segments[SEGMENT_COUNT];
+};
+
+static inline size_t _ceil_pow2(size_t x)
+{
+    return x <= 1 ? 1 :
+           (size_t) 1 << (sizeof(x) * CHAR_BIT - __builtin_clzl(x - 1));
+}
+
+static inline size_t _segment_size(struct concurrent_vector *vec, size_t seg)
+{
+    return vec->first_segment << seg;
+}
+
+// maps an index onto a segment and an offset within it
+static inline size_t _locate(struct concurrent_vector *vec, size_t idx,
+                             size_t *offset)
+{
+    size_t seg = sizeof(size_t) * CHAR_BIT - 1 -
+                 __builtin_clzl(idx / vec->first_segment + 1);
+
+    *offset = idx - vec->first_segment * (((size_t) 1 << seg) - 1);
+
+    return seg;
+}
+
+static inline atomic_uchar *_flags(struct concurrent_vector *vec, char *segment,
+                                   size_t seg)
+{
+    return (atomic_uchar *) (segment + (_segment_size(vec, seg) *
+                                        vec->el_size));
+}
+
+static char *_segment(struct concurrent_vector *vec, size_t seg)
+{
+    char *segment = atomic_load_explicit(&vec->segments[seg],
+                                         memory_order_acquire);
+    if (segment != NULL)
+        return segment;
+
+    size_t limit = SIZE_MAX / (vec->el_size + sizeof(atomic_uchar));
+    if (vec->first_segment > limit >> seg)
+        return NULL;
+
+    char *new_segment = calloc(_segment_size(vec, seg),
+                               vec->el_size + sizeof(atomic_uchar));
+    if (new_segment == NULL)
+        return NULL;
+
+    // somebody may have been faster, use theirs then
+    if (!atomic_compare_exchange_strong_explicit(&vec->segments[seg],
+                                                 &segment, new_segment,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        free(new_segment);
+        return segment;
+    }
+
+    return new_segment;
+}
+
+struct concurrent_vector *concurrent_vector_create(size_t first_segment,
+                                                   size_t el_size)
+{
+    if (el_size == 0)
+        return NULL;
+
+    struct concurrent_vector *vec = malloc(sizeof(*vec));
+    if (vec == NULL)
+        return NULL;
+
+    vec->el_size = el_size;
+    vec->first_segment = _ceil_pow2(first_segment == 0 ? 32 : first_segment);
+    atomic_init(&vec->count, 0);
+    for (size_t i = 0; i < SEGMENT_COUNT; i++)
+        atomic_init(&vec->segments[i], NULL);
+
+    return vec;
+}
+
+void concurrent_vector_destroy(struct concurrent_vector *vec)
+{
+    if (vec == NULL)
+        return;
+
+    for (size_t i = 0; i < SEGMENT_COUNT; i++)
+        free(atomic_load_explicit(&vec->segments[i], memory_order_relaxed));
+    free(vec);
+}
+
+size_t concurrent_vector_size(struct concurrent_vector *vec)
+{
+    return atomic_load_explicit(&vec->count, memory_order_acquire);
+}
+
+ssize_t concurrent_vector_push_back(struct concurrent_vector *vec,
+                                    const void *el)
+{
+    if (vec == NULL || el == NULL)
+        return -EINVAL;
+
+    size_t idx = atomic_fetch_add_explicit(&vec->count, 1,
+                                           memory_order_relaxed);
+    if (idx > SSIZE_MAX)
+        return -ENOMEM;
+
+    size_t offset, seg = _locate(vec, idx, &offset);
+
+    // if this fails the slot stays claimed but is never published
+    char *segment = _segment(vec, seg);
+    if (segment == NULL)
+        return -ENOMEM;
+
+    memcpy(segment + (offset * vec->el_size), el, vec->el_size);
+    atomic_store_explicit(&_flags(vec, segment, seg)[offset], 1,
+                          memory_order_release);
+
+    return idx;
+}
+
+void *concurrent_vector_get(struct concurrent_vector *vec, size_t idx)
+{
+    if (vec == NULL ||
+            idx >= atomic_load_explicit(&vec->count, memory_order_relaxed)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t offset, seg = _locate(vec, idx, &offset);
+
+    char *segment = atomic_load_explicit(&vec->segments[seg],
+                                         memory_order_acquire);
+    if (segment == NULL ||
+            !atomic_load_explicit(&_flags(vec, segment, seg)[offset],
+                                  memory_order_acquire)) {
+        errno = EAGAIN;
+        return NULL;
+    }
+
+    return segment + (offset * vec->el_size);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file concurrent_vector.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CONCURRENT_VECTOR_H__
+#define __CONCURRENT_VECTOR_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct concurrent_vector;
+
+/** Creates an append-only vector safe for concurrent use.
+ *
+ * The elements are stored in a table of segments where every segment is
+ * twice as large as the previous one. Segments are never reallocated so the
+ * elements never move and pointers returned by concurrent_vector_get() stay
+ * valid until the vector is destroyed.
+ *
+ * @param[in] first_segment number of elements in the first segment, rounded
+ *            up to a power of 2, if 0 then a default is used
+ * @param[in] el_size size of the vector's element
+ *
+ * @return pointer to the vector object or NULL on error
+ */
+struct concurrent_vector *concurrent_vector_create(size_t first_segment,
+                                                   size_t el_size);
+
+/** Destroys the vector.
+ *
+ * No other thread may use the vector during and after this call.
+ *
+ * @param[in] vector pointer to the vector object
+ */
+void concurrent_vector_destroy(struct concurrent_vector *vector);
+
+/** Returns number of slots claimed in the vector.
+ *
+ * Slots are claimed by concurrent_vector_push_back() before the element is
+ * copied into them, so some of the last elements may not be readable yet.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return number of claimed slots
+ */
+size_t concurrent_vector_size(struct concurrent_vector *vector);
+
+/** Appends an element at the end of the vector.
+ *
+ * The slot is claimed with a single atomic increment. A segment is allocated
+ * by whichever thread needs it first, the other threads never wait for it.
+ * Can be called concurrently with all the other functions except
+ * concurrent_vector_destroy().
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] element the element to copy into the vector
+ *
+ * @return index of the element upon success and negative error code
+ *         otherwise
+ */
+ssize_t concurrent_vector_push_back(struct concurrent_vector *vector,
+                                    const void *element);
+
+/** Gets an element from the vector.
+ *
+ * Lock-free, can be called concurrently with concurrent_vector_push_back().
+ * If the slot under given index is claimed but the element is not fully
+ * written yet @c NULL is returned and @c errno is set to @c EAGAIN.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position of the element to retrieve
+ *
+ * @return pointer to the element in the vector or NULL if the element
+ *         doesn't exist or isn't published yet
+ */
+void *concurrent_vector_get(struct concurrent_vector *vector, size_t index);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __CONCURRENT_VECTOR_H__
@@ -0,0 +1,221 @@
+/**
+ * @file eytzinger.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eytzinger.h"
+
+#define CACHE_LINE_SIZE 64
+
+struct eytzinger {
+    char *nodes;        //!< the tree, 1-based, node k has children 2k, 2k + 1
+    size_t el_count;
+    unsigned levels;    //!< levels of the perfect tree holding all the nodes
+    size_t last;        //!< nodes on the last level, which may be partial
+    size_t el_size;
+    size_t prefetch;    //!< node k prefetches node k * prefetch
+};
+
+static inline void *_node(struct eytzinger *index, size_t k)
+{
+    return index->nodes + k * index->el_size;
+}
+
+// the descendants of the last levels lie past the end of the tree, prefetch
+// doesn't fault but the address is computed without pointer arithmetic
+static inline void _prefetch(struct eytzinger *index, size_t k)
+{
+    uintptr_t addr = (uintptr_t) index->nodes +
+        k * index->prefetch * index->el_size;
+    __builtin_prefetch((const void *) addr);
+}
+
+// The in-order rank of node k in the perfect tree of the same height follows
+// from its depth and its index within the level. The last level is filled
+// from the left, so only the slots of that level after the first `last` ones
+// are missing and every second rank up to them belongs to the last level.
+
+static inline size_t _rank(struct eytzinger *index, size_t k)
+{
+    unsigned depth = sizeof(k) * CHAR_BIT - 1 - __builtin_clzl(k);
+    size_t column = k - ((size_t) 1 << depth);
+    size_t rank = ((2 * column + 1) << (index->levels - 1 - depth)) - 1;
+
+    // slots of the last level in front of the node in the perfect tree
+    size_t slots = (rank + 1) / 2;
+    return slots > index->last ? rank - (slots - index->last) : rank;
+}
+
+static inline size_t _node_at(struct eytzinger *index, size_t rank)
+{
+    if (rank >= 2 * index->last)
+        rank = 2 * rank - 2 * index->last + 1;
+
+    // rank + 1 is an odd column times a power of two telling the height
+    unsigned height = __builtin_ctzl(rank + 1);
+    unsigned depth = index->levels - 1 - height;
+    return ((size_t) 1 << depth) + ((rank + 1) >> (height + 1));
+}
+
+// fills the subtree rooted at node k with the in-order elements of the array
+// starting at rank, returns the rank following the subtree
+static size_t _fill(struct eytzinger *index, const char *array, size_t k,
+                    size_t rank)
+{
+    if (k > index->el_count)
+        return rank;
+
+    rank = _fill(index, array, 2 * k, rank);
+
+    memcpy(_node(index, k), array + rank * index->el_size, index->el_size);
+
+    return _fill(index, array, 2 * k + 1, rank + 1);
+}
+
+struct eytzinger *eytzinger_create(const void *array, size_t asize,
+                                   size_t esize)
+{
+    if (array == NULL || asize == 0 || asize > SSIZE_MAX || esize == 0)
+        goto return_einval_;
+
+    if (asize + 1 > (SIZE_MAX - CACHE_LINE_SIZE) / esize)
+        goto return_enomem_;
+
+    struct eytzinger *index = malloc(sizeof(*index));
+    if (index == NULL)
+        goto return_enomem_;
+
+    // prefetching node k * prefetch brings in a whole cache line of
+    // descendants which the search reaches log2(prefetch) steps later
+    size_t per_line = esize < CACHE_LINE_SIZE ? CACHE_LINE_SIZE / esize : 1;
+    index->prefetch = 2;
+    while (index->prefetch * 2 <= per_line)
+        index->prefetch *= 2;
+
+    size_t bytes = (asize + 1) * esize;
+    bytes = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    index->nodes = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (index->nodes == NULL)
+        goto free_index_;
+
+    // the full levels and one more for the nodes left over, if any
+    unsigned full = sizeof(size_t) * CHAR_BIT - 1 - __builtin_clzl(asize + 1);
+    index->el_count = asize;
+    index->el_size = esize;
+    index->levels = full + 1;
+    index->last = asize - (((size_t) 1 << full) - 1);
+
+    _fill(index, array, 1, 0);
+
+    return index;
+
+free_index_:
+    free(index);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+return_einval_:
+    errno = EINVAL;
+    return NULL;
+}
+
+void eytzinger_destroy(struct eytzinger *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->nodes);
+    free(index);
+}
+
+size_t eytzinger_size(struct eytzinger *index)
+{
+    return index->el_count;
+}
+
+void *eytzinger_get(struct eytzinger *index, size_t idx)
+{
+    if (index == NULL || idx >= index->el_count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return _node(index, _node_at(index, idx));
+}
+
+// Descends from the root appending 1 to the path when going right. The
+// resulting k is past the leaves; the node the search would have returned is
+// where the path last turned the other way.
+
+ssize_t eytzinger_search_leftmost(struct eytzinger *index,
+                                  compare_fn_t compare, const void *search)
+{
+    if (index == NULL || compare == NULL || search == NULL)
+        return -1;
+
+    size_t k = 1;
+
+    while (k <= index->el_count) {
+        _prefetch(index, k);
+        k = 2 * k + (compare(search, _node(index, k)) > 0);
+    }
+
+    // the last left turn, the first element not less than search
+    k >>= __builtin_ctzl(~k) + 1;
+
+    if (k == 0 || compare(search, _node(index, k)) != 0)
+        return -1;
+    return _rank(index, k);
+}
+
+ssize_t eytzinger_search_rightmost(struct eytzinger *index,
+                                   compare_fn_t compare, const void *search)
+{
+    if (index == NULL || compare == NULL || search == NULL)
+        return -1;
+
+    size_t k = 1;
+
+    while (k <= index->el_count) {
+        _prefetch(index, k);
+        k = 2 * k + (compare(search, _node(index, k)) >= 0);
+    }
+
+    // the last right turn, the last element not greater than search
+    k >>= __builtin_ctzl(k) + 1;
+
+    if (k == 0 || compare(search, _node(index, k)) != 0)
+        return -1;
+    return _rank(index, k);
+}
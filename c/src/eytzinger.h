@@ -0,0 +1,114 @@
+/**
+ * @file eytzinger.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EYTZINGER_H__
+#define __EYTZINGER_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct eytzinger;
+
+/** Builds an Eytzinger ordered copy of a sorted array.
+ *
+ * The elements are stored in the breadth first order of the implicit binary
+ * search tree over the array: the root first, then both its children, then
+ * the four grandchildren and so on. The first levels of the tree share a
+ * few cache lines and all the descendants of a node a few levels down are
+ * adjacent, so they can be prefetched together while the search is still
+ * a few steps above them.
+ *
+ * The copy is independent of the source array which may be freed.
+ *
+ * @param[in] array the array sorted in ascending order
+ * @param[in] asize number of elements in the array
+ * @param[in] esize size of a single element
+ *
+ * @return pointer to the index or NULL on error
+ */
+struct eytzinger *eytzinger_create(const void *array, size_t asize,
+                                   size_t esize);
+
+/** Destroys the index.
+ *
+ * @param[in] index pointer to the index
+ */
+void eytzinger_destroy(struct eytzinger *index);
+
+/** Returns number of elements in the index.
+ *
+ * @param[in] index pointer to the index
+ *
+ * @return number of elements
+ */
+size_t eytzinger_size(struct eytzinger *index);
+
+/** Returns the element at a given position of the sorted source array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] idx position in the sorted array
+ *
+ * @return pointer to the element or NULL if out of range, @c errno is set to
+ *         indicate the error
+ */
+void *eytzinger_get(struct eytzinger *index, size_t idx);
+
+/** Same as binary_search_leftmost() on the source array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] compare comparison function, called as compare(search, element)
+ * @param[in] search the element to look for
+ *
+ * @return position of the first equal element in the sorted source array
+ *         or -1 if there is none
+ */
+ssize_t eytzinger_search_leftmost(struct eytzinger *index,
+                                  compare_fn_t compare, const void *search);
+
+/** Same as binary_search_rightmost() on the source array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] compare comparison function, called as compare(search, element)
+ * @param[in] search the element to look for
+ *
+ * @return position of the last equal element in the sorted source array or
+ *         -1 if there is none
+ */
+ssize_t eytzinger_search_rightmost(struct eytzinger *index,
+                                   compare_fn_t compare, const void *search);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __EYTZINGER_H__
@@ -0,0 +1,252 @@
+/**
+ * @file file_search.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file_search.h"
+
+struct file_search {
+    void *map;
+    size_t map_size;
+    const char *records;    //!< first record within the mapping
+    size_t record_size;
+    size_t el_count;
+    uintptr_t page_mask;
+
+    char *sample;           //!< copies of every sample_step-th record
+    size_t sample_step;
+    size_t sample_count;
+};
+
+static inline const char *_record(struct file_search *fs, size_t idx)
+{
+    return fs->records + idx * fs->record_size;
+}
+
+// asks the kernel to start reading the page of a record unless it's the page
+// the search is already on
+static inline void _will_need(struct file_search *fs, size_t idx,
+                              uintptr_t current)
+{
+    uintptr_t page = (uintptr_t) _record(fs, idx) & fs->page_mask;
+    if (page != current)
+        madvise((void *) page, fs->page_mask + 1, MADV_WILLNEED);
+}
+
+// Returns the first index in [left, right] at which the record is not less
+// than (upper == false) or greater than (upper == true) the key. As long as
+// the range spans multiple pages the two records the next step may probe are
+// advised before the current one is compared, so the I/O for the next level
+// overlaps with the page fault of this one. Once the range fits a page it's
+// advised as a whole and searched without further system calls.
+static size_t _bound(struct file_search *fs, compare_fn_t compare, void *key,
+                     bool upper, size_t left, size_t right)
+{
+    bool advised = false;
+
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        uintptr_t first = (uintptr_t) _record(fs, left) & fs->page_mask;
+        uintptr_t last = ((uintptr_t) _record(fs, right) - 1) & fs->page_mask;
+
+        if (first == last) {
+            if (!advised)
+                madvise((void *) first, fs->page_mask + 1, MADV_WILLNEED);
+            advised = true;
+        } else {
+            uintptr_t current = (uintptr_t) _record(fs, mid) & fs->page_mask;
+            if (mid > left)
+                _will_need(fs, left + (mid - left) / 2, current);
+            if (right > mid + 1)
+                _will_need(fs, mid + 1 + (right - mid - 1) / 2, current);
+        }
+
+        ssize_t cmp = compare(key, _record(fs, mid));
+        if (upper ? cmp >= 0 : cmp > 0)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+
+    return left;
+}
+
+// Narrows the range of the bound using the sample: if sample i is the first
+// one past the bound, the bound lies in (step * (i - 1), step * i].
+static size_t _search(struct file_search *fs, compare_fn_t compare, void *key,
+                      bool upper)
+{
+    size_t left = 0, right = fs->el_count;
+
+    if (fs->sample != NULL) {
+        ssize_t i = upper ?
+            binary_search_upper_bound(fs->sample, fs->sample_count,
+                                      fs->record_size, compare, key) :
+            binary_search_lower_bound(fs->sample, fs->sample_count,
+                                      fs->record_size, compare, key);
+
+        left = i > 0 ? (i - 1) * fs->sample_step + 1 : 0;
+        right = (size_t) i * fs->sample_step < fs->el_count ?
+                (size_t) i * fs->sample_step : fs->el_count;
+    }
+
+    return _bound(fs, compare, key, upper, left, right);
+}
+
+struct file_search *file_search_open(const char *path, size_t offset,
+                                     size_t record_size, size_t sample_step)
+{
+    struct file_search *fs = NULL;
+    struct stat st;
+    int err;
+
+    if (path == NULL || record_size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) < 0)
+        goto close_file_;
+
+    errno = EINVAL;
+    if ((size_t) st.st_size <= offset ||
+            ((size_t) st.st_size - offset) % record_size != 0 ||
+            ((size_t) st.st_size - offset) / record_size > SSIZE_MAX)
+        goto close_file_;
+
+    fs = malloc(sizeof(*fs));
+    if (fs == NULL)
+        goto close_file_;
+
+    fs->map_size = st.st_size;
+    fs->map = mmap(NULL, fs->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (fs->map == MAP_FAILED)
+        goto free_search_;
+
+    // binary search jumps all over the file, reading around the probes would
+    // only evict useful pages
+    madvise(fs->map, fs->map_size, MADV_RANDOM);
+
+    fs->records = (const char *) fs->map + offset;
+    fs->record_size = record_size;
+    fs->el_count = (fs->map_size - offset) / record_size;
+    fs->page_mask = ~((uintptr_t) sysconf(_SC_PAGESIZE) - 1);
+
+    fs->sample = NULL;
+    fs->sample_step = sample_step;
+    fs->sample_count = 0;
+
+    if (sample_step > 0) {
+        fs->sample_count = (fs->el_count + sample_step - 1) / sample_step;
+        fs->sample = malloc(fs->sample_count * record_size);
+        if (fs->sample == NULL)
+            goto unmap_file_;
+
+        for (size_t i = 0; i < fs->sample_count; ++i)
+            memcpy(fs->sample + i * record_size,
+                   _record(fs, i * sample_step), record_size);
+    }
+
+    close(fd);
+
+    return fs;
+
+unmap_file_:
+    munmap(fs->map, fs->map_size);
+free_search_:
+    free(fs);
+close_file_:
+    err = errno;
+    close(fd);
+    errno = err;
+    return NULL;
+}
+
+void file_search_close(struct file_search *search)
+{
+    if (search == NULL)
+        return;
+
+    free(search->sample);
+    munmap(search->map, search->map_size);
+    free(search);
+}
+
+size_t file_search_size(struct file_search *search)
+{
+    return search->el_count;
+}
+
+const void *file_search_get(struct file_search *search, size_t idx)
+{
+    if (search == NULL || idx >= search->el_count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return _record(search, idx);
+}
+
+ssize_t file_search_leftmost(struct file_search *search, compare_fn_t compare,
+                             void *key)
+{
+    if (search == NULL || compare == NULL || key == NULL)
+        return -1;
+
+    size_t left = _search(search, compare, key, false);
+    if (left < search->el_count &&
+            compare(key, _record(search, left)) == 0)
+        return left;
+    return -1;
+}
+
+ssize_t file_search_rightmost(struct file_search *search,
+                              compare_fn_t compare, void *key)
+{
+    if (search == NULL || compare == NULL || key == NULL)
+        return -1;
+
+    size_t right = _search(search, compare, key, true);
+    if (right > 0 && compare(key, _record(search, right - 1)) == 0)
+        return right - 1;
+    return -1;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file file_search.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FILE_SEARCH_H__
+#define __FILE_SEARCH_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct file_search;
+
+/** Opens a file of sorted fixed size records for searching.
+ *
+ * The file is memory mapped, nothing is read up front except for the
+ * sample. The searches ask the kernel to read ahead the pages of the
+ * next probes (@c MADV_WILLNEED) while the current one is compared, the
+ * rest of the mapping is advised as randomly accessed so no pages around
+ * the probes are read in needlessly.
+ *
+ * With @c sample_step greater than 0 every @c sample_step -th record is
+ * copied to memory when the file is opened. A search bisects the sample
+ * first and only the last log2(sample_step) probes touch the file.
+ *
+ * @param[in] path path of the file
+ * @param[in] offset size of a header preceding the records
+ * @param[in] record_size size of a single record
+ * @param[in] sample_step distance of the sampled records, 0 for no sample
+ *
+ * @return pointer to the search object or NULL on error, @c errno is set to
+ *         indicate the error
+ */
+struct file_search *file_search_open(const char *path, size_t offset,
+                                     size_t record_size, size_t sample_step);
+
+/** Unmaps the file and frees the sample.
+ *
+ * @param[in] search pointer to the search object
+ */
+void file_search_close(struct file_search *search);
+
+/** Returns number of records in the file.
+ *
+ * @param[in] search pointer to the search object
+ *
+ * @return number of records
+ */
+size_t file_search_size(struct file_search *search);
+
+/** Returns a record of the file.
+ *
+ * @param[in] search pointer to the search object
+ * @param[in] idx index of the record
+ *
+ * @return pointer to the mapped record or NULL if out of range, @c errno is
+ *         set to indicate the error
+ */
+const void *file_search_get(struct file_search *search, size_t idx);
+
+/** Same as binary_search_leftmost() on the records of the file.
+ *
+ * @param[in] search pointer to the search object
+ * @param[in] compare comparison function, called as compare(key, record)
+ * @param[in] key the record to look for
+ *
+ * @return index of the first equal record or -1 if there is none
+ */
+ssize_t file_search_leftmost(struct file_search *search, compare_fn_t compare,
+                             void *key);
+
+/** Same as binary_search_rightmost() on the records of the file.
+ *
+ * @param[in] search pointer to the search object
+ * @param[in] compare comparison function, called as compare(key, record)
+ * @param[in] key the record to look for
+ *
+ * @return index of the last equal record or -1 if there is none
+ */
+ssize_t file_search_rightmost(struct file_search *search,
+                              compare_fn_t compare, void *key);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __FILE_SEARCH_H__
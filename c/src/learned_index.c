@@ -0,0 +1,258 @@
+/**
+ * @file learned_index.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_search.h"
+#include "learned_index.h"
+
+struct learned_index {
+    const uint64_t *keys;
+    size_t el_count;
+    size_t max_error;   //!< measured on the built model, not the requested
+
+    // the segments as separate arrays so the search over the first keys
+    // doesn't drag the rest of the segment through the cache
+    uint64_t *first_keys;
+    size_t *first_positions;
+    double *slopes;
+    size_t seg_count;
+    size_t seg_capacity;
+};
+
+static inline int _compare_u64(const uint64_t *x1, const uint64_t *x2)
+{
+    return (*x1 > *x2) - (*x1 < *x2);
+}
+
+BINARY_SEARCH_DEFINE(_segment_search, uint64_t, _compare_u64)
+
+static bool _add_segment(struct learned_index *index, uint64_t key,
+                         size_t position, double slope)
+{
+    if (index->seg_count == index->seg_capacity) {
+        size_t capacity = index->seg_capacity * 3 / 2;
+
+        uint64_t *keys = realloc(index->first_keys, capacity * sizeof(*keys));
+        if (keys == NULL)
+            return false;
+        index->first_keys = keys;
+
+        size_t *positions = realloc(index->first_positions,
+                                    capacity * sizeof(*positions));
+        if (positions == NULL)
+            return false;
+        index->first_positions = positions;
+
+        double *slopes = realloc(index->slopes, capacity * sizeof(*slopes));
+        if (slopes == NULL)
+            return false;
+        index->slopes = slopes;
+
+        index->seg_capacity = capacity;
+    }
+
+    index->first_keys[index->seg_count] = key;
+    index->first_positions[index->seg_count] = position;
+    index->slopes[index->seg_count] = slope;
+    index->seg_count += 1;
+
+    return true;
+}
+
+// the position the model predicts for a key of the segment, clamped to the
+// array
+static inline size_t _predict(struct learned_index *index, size_t seg,
+                              uint64_t key)
+{
+    double offset = index->slopes[seg] *
+                    (double) (key - index->first_keys[seg]);
+    size_t predicted = index->first_positions[seg] + (size_t) offset;
+    if (offset >= (double) index->el_count || predicted >= index->el_count)
+        predicted = index->el_count - 1;
+    return predicted;
+}
+
+// the largest distance of a prediction from the first occurrence of its key;
+// the cone bounds it by the requested error, plus one as the prediction is
+// truncated
+static void _measure(struct learned_index *index)
+{
+    const uint64_t *keys = index->keys;
+    size_t seg = 0, max_error = 0;
+
+    for (size_t i = 0; i < index->el_count; ++i) {
+        if (i > 0 && keys[i] == keys[i - 1])
+            continue;
+        while (seg + 1 < index->seg_count &&
+                index->first_keys[seg + 1] <= keys[i])
+            ++seg;
+
+        size_t predicted = _predict(index, seg, keys[i]);
+        size_t error = predicted > i ? predicted - i : i - predicted;
+        if (error > max_error)
+            max_error = error;
+    }
+
+    index->max_error = max_error;
+}
+
+// Shrinking cone: every point (key, position) of a segment allows the slopes
+// of the lines through the first point which pass within max_error of it.
+// The segment is extended as long as the intersection of those ranges is not
+// empty, any slope in the intersection then fits all the points. Only the
+// first occurrence of every key is a point, duplicates are found by the final
+// leftmost search.
+static bool _build(struct learned_index *index)
+{
+    const uint64_t *keys = index->keys;
+    double error = index->max_error;
+    uint64_t first_key = keys[0];
+    size_t first_position = 0;
+    double low = 0.0, high = INFINITY;
+
+    for (size_t i = 1; i < index->el_count; ++i) {
+        if (keys[i] == keys[i - 1])
+            continue;
+
+        double dx = (double) (keys[i] - first_key);
+        double dy = (double) (i - first_position);
+        double point_low = (dy - error) / dx;
+        double point_high = (dy + error) / dx;
+
+        if (point_low <= high && point_high >= low) {
+            low = point_low > low ? point_low : low;
+            high = point_high < high ? point_high : high;
+            continue;
+        }
+
+        double slope = isinf(high) ? 0.0 : (low + high) / 2;
+        if (!_add_segment(index, first_key, first_position, slope))
+            return false;
+
+        first_key = keys[i];
+        first_position = i;
+        low = 0.0;
+        high = INFINITY;
+    }
+
+    double slope = isinf(high) ? 0.0 : (low + high) / 2;
+    return _add_segment(index, first_key, first_position, slope);
+}
+
+struct learned_index *learned_index_create(const uint64_t *keys, size_t count,
+                                           size_t max_error)
+{
+    if (keys == NULL || count == 0 || count > SSIZE_MAX ||
+            max_error > SSIZE_MAX / 4)
+        goto return_einval_;
+
+    struct learned_index *index = malloc(sizeof(*index));
+    if (index == NULL)
+        goto return_enomem_;
+
+    const size_t min_capacity = 32;
+
+    index->keys = keys;
+    index->el_count = count;
+    index->max_error = max_error;
+    index->seg_count = 0;
+    index->seg_capacity = min_capacity;
+    index->first_keys = malloc(min_capacity * sizeof(uint64_t));
+    index->first_positions = malloc(min_capacity * sizeof(size_t));
+    index->slopes = malloc(min_capacity * sizeof(double));
+
+    if (index->first_keys == NULL || index->first_positions == NULL ||
+            index->slopes == NULL || !_build(index))
+        goto free_index_;
+
+    _measure(index);
+
+    return index;
+
+free_index_:
+    learned_index_destroy(index);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+return_einval_:
+    errno = EINVAL;
+    return NULL;
+}
+
+void learned_index_destroy(struct learned_index *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->slopes);
+    free(index->first_positions);
+    free(index->first_keys);
+    free(index);
+}
+
+ssize_t learned_index_search(struct learned_index *index, uint64_t key)
+{
+    if (index == NULL || key < index->first_keys[0])
+        return -1;
+
+    // the last segment starting at or before the key
+    size_t seg = _segment_search_upper_bound(index->first_keys,
+                                             index->seg_count, &key) - 1;
+
+    size_t predicted = _predict(index, seg, key);
+
+    size_t margin = index->max_error;
+    size_t left = predicted > margin ? predicted - margin : 0;
+    size_t right = index->el_count - predicted > margin + 1 ?
+                   predicted + margin + 1 : index->el_count;
+
+    ssize_t found = binary_search_leftmost_u64(index->keys + left,
+                                               right - left, key);
+    return found < 0 ? -1 : (ssize_t) left + found;
+}
+
+int learned_index_stats(struct learned_index *index,
+                        struct learned_index_stats *stats)
+{
+    if (index == NULL || stats == NULL)
+        return -EINVAL;
+
+    stats->segments = index->seg_count;
+    stats->bytes = sizeof(*index) + index->seg_capacity *
+        (sizeof(uint64_t) + sizeof(size_t) + sizeof(double));
+    stats->max_error = index->max_error;
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file learned_index.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LEARNED_INDEX_H__
+#define __LEARNED_INDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Size and accuracy of a learned index. */
+struct learned_index_stats {
+    size_t segments;    //!< number of linear segments of the model
+    size_t bytes;       //!< memory taken by the model
+    size_t max_error;   //!< largest distance of a prediction from its key
+};
+
+struct learned_index;
+
+/** Builds a piecewise linear model of the positions of keys in an array.
+ *
+ * The array is scanned once and split greedily into segments; each segment
+ * is a line which predicts the position of the first occurrence of each of
+ * its keys within @c max_error, plus one as the prediction is truncated to a
+ * position. A second scan measures the actual largest error of the model,
+ * which learned_index_stats() reports and the lookups use. A lookup picks
+ * the segment, evaluates the line and finishes with a binary search of the
+ * few elements around the prediction, so instead of log2(n) probes spread
+ * over the whole array it takes a search over the (much smaller) list of
+ * segments and a few probes close to each other.
+ *
+ * The index refers to the array which has to outlive it.
+ *
+ * @param[in] keys the keys sorted in ascending order
+ * @param[in] count number of keys
+ * @param[in] max_error maximum error of a segment, smaller values give more
+ *            segments and shorter final searches
+ *
+ * @return pointer to the index or NULL on error, @c errno is set to indicate
+ *         the error
+ */
+struct learned_index *learned_index_create(const uint64_t *keys, size_t count,
+                                           size_t max_error);
+
+/** Destroys the index.
+ *
+ * @param[in] index pointer to the index
+ */
+void learned_index_destroy(struct learned_index *index);
+
+/** Same as binary_search_leftmost_u64() on the indexed array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] key the key to look for
+ *
+ * @return position of the first equal key or -1 if there is none
+ */
+ssize_t learned_index_search(struct learned_index *index, uint64_t key);
+
+/** Reports the size and accuracy of the model.
+ *
+ * @param[in] index pointer to the index
+ * @param[out] stats the statistics
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int learned_index_stats(struct learned_index *index,
+                        struct learned_index_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __LEARNED_INDEX_H__
@@ -0,0 +1,232 @@
+/**
+ * @file merge.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "merge.h"
+
+// with many runs there are more streams than the hardware prefetcher
+// follows, so every run prefetches this far ahead of its head itself
+#define PREFETCH_AHEAD 256
+
+// the vector output is collected here and appended in batches
+#define SINK_BYTES 4096
+
+// The tree has count - 1 inner nodes 1 .. count - 1, each remembering the
+// run which lost the match played there, and count leaves count ..
+// 2 * count - 1 standing for the runs. losers[0] holds the overall winner.
+struct _tree {
+    const char **heads;
+    const char **ends;
+    size_t *losers;
+    size_t count;
+    size_t el_size;
+    compare_fn_t compare;
+};
+
+struct _sink {
+    struct vector *out;
+    size_t el_size;
+    size_t count;
+    size_t capacity;
+    char buffer[SINK_BYTES];
+};
+
+// exhausted runs lose every match, ties go to the lower numbered run so that
+// the merge is stable
+static inline bool _beats(struct _tree *tree, size_t a, size_t b)
+{
+    if (tree->heads[a] == tree->ends[a])
+        return false;
+    if (tree->heads[b] == tree->ends[b])
+        return true;
+
+    ssize_t result = tree->compare(tree->heads[a], tree->heads[b]);
+    return result < 0 || (result == 0 && a < b);
+}
+
+static size_t _build(struct _tree *tree, size_t node)
+{
+    if (node >= tree->count)
+        return node - tree->count;
+
+    size_t a = _build(tree, 2 * node);
+    size_t b = _build(tree, 2 * node + 1);
+    if (_beats(tree, a, b)) {
+        tree->losers[node] = b;
+        return a;
+    }
+    tree->losers[node] = a;
+    return b;
+}
+
+// moves the head of the winning run and plays its matches again on the way
+// to the root
+static inline void _advance(struct _tree *tree, size_t run)
+{
+    const char *head = tree->heads[run] += tree->el_size;
+    if ((size_t) (tree->ends[run] - head) > PREFETCH_AHEAD)
+        __builtin_prefetch(head + PREFETCH_AHEAD);
+
+    size_t winner = run;
+    for (size_t node = (tree->count + run) / 2; node > 0; node /= 2) {
+        size_t loser = tree->losers[node];
+        if (_beats(tree, loser, winner)) {
+            tree->losers[node] = winner;
+            winner = loser;
+        }
+    }
+    tree->losers[0] = winner;
+}
+
+int merge_runs(const struct merge_run *runs, size_t count, size_t esize,
+               compare_fn_t compare, enum merge_dedup dedup,
+               merge_emit_fn_t emit, void *arg)
+{
+    if ((runs == NULL && count > 0) || esize == 0 || compare == NULL ||
+            emit == NULL || (dedup != MERGE_ALL && dedup != MERGE_LEFTMOST &&
+                             dedup != MERGE_RIGHTMOST))
+        return -EINVAL;
+    if (count == 0)
+        return 0;
+    if (count > SIZE_MAX / (sizeof(size_t) + 2 * sizeof(char *)))
+        return -EINVAL;
+    for (size_t i = 0; i < count; ++i) {
+        if ((runs[i].size > 0 && runs[i].array == NULL) ||
+                runs[i].size > SIZE_MAX / esize)
+            return -EINVAL;
+    }
+
+    struct _tree tree = {
+        .count = count,
+        .el_size = esize,
+        .compare = compare,
+    };
+    tree.losers = malloc(count * (sizeof(size_t) + 2 * sizeof(char *)));
+    if (tree.losers == NULL)
+        return -ENOMEM;
+    tree.heads = (const char **) (tree.losers + count);
+    tree.ends = tree.heads + count;
+
+    for (size_t i = 0; i < count; ++i) {
+        tree.heads[i] = runs[i].array;
+        tree.ends[i] = runs[i].size > 0 ?
+                       tree.heads[i] + runs[i].size * esize : tree.heads[i];
+    }
+    tree.losers[0] = _build(&tree, 1);
+
+    // the first element of the current group of equal ones for
+    // MERGE_LEFTMOST, the last one seen for MERGE_RIGHTMOST
+    const char *pending = NULL;
+    size_t pending_run = 0;
+    int result = 0;
+
+    while (result == 0) {
+        size_t run = tree.losers[0];
+        const char *element = tree.heads[run];
+        if (element == tree.ends[run])
+            break;
+        _advance(&tree, run);
+
+        switch (dedup) {
+        case MERGE_ALL:
+            result = emit(element, run, arg);
+            break;
+        case MERGE_LEFTMOST:
+            if (pending == NULL || compare(pending, element) != 0) {
+                result = emit(element, run, arg);
+                pending = element;
+            }
+            break;
+        case MERGE_RIGHTMOST:
+            if (pending != NULL && compare(pending, element) != 0)
+                result = emit(pending, pending_run, arg);
+            pending = element;
+            pending_run = run;
+            break;
+        }
+    }
+    if (result == 0 && dedup == MERGE_RIGHTMOST && pending != NULL)
+        result = emit(pending, pending_run, arg);
+
+    free(tree.losers);
+
+    return result;
+}
+
+static int _flush(struct _sink *sink)
+{
+    int result = vector_append(sink->out, sink->buffer, sink->count);
+    sink->count = 0;
+
+    return result;
+}
+
+static int _emit_vector(const void *element, size_t run, void *arg)
+{
+    struct _sink *sink = arg;
+    (void) run;
+
+    if (sink->capacity == 0)
+        return vector_append(sink->out, element, 1);
+    if (sink->count == sink->capacity) {
+        int result = _flush(sink);
+        if (result != 0)
+            return result;
+    }
+    memcpy(sink->buffer + sink->count++ * sink->el_size, element,
+           sink->el_size);
+
+    return 0;
+}
+
+int merge_runs_vector(struct vector *vector, const struct merge_run *runs,
+                      size_t count, compare_fn_t compare,
+                      enum merge_dedup dedup)
+{
+    if (vector == NULL)
+        return -EINVAL;
+
+    struct _sink sink = {
+        .out = vector,
+        .el_size = vector_element_size(vector),
+    };
+    sink.capacity = SINK_BYTES / sink.el_size;
+
+    int result = merge_runs(runs, count, sink.el_size, compare, dedup,
+                            _emit_vector, &sink);
+    if (result == 0 && sink.count > 0)
+        result = _flush(&sink);
+
+    return result;
+}
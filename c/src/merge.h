@@ -0,0 +1,113 @@
+/**
+ * @file merge.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MERGE_H__
+#define __MERGE_H__
+
+#include <stddef.h>
+
+#include "binary_search.h"
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** A sorted run taking part in a merge. */
+struct merge_run {
+    const void *array;  //!< elements sorted in ascending order
+    size_t size;        //!< number of elements, the array may be NULL if 0
+};
+
+/** Which of the equal elements a merge outputs. */
+enum merge_dedup {
+    MERGE_ALL,          //!< all of them, in the order of the runs
+    MERGE_LEFTMOST,     //!< the first one, from the lowest numbered run
+    MERGE_RIGHTMOST,    //!< the last one, from the highest numbered run
+};
+
+/** Receives the merged elements one by one.
+ *
+ * @param[in] element the element, it points into its run
+ * @param[in] run index of the run the element comes from
+ * @param[in] arg the argument passed to merge_runs()
+ *
+ * @return 0 to go on with the merge, any other value stops it
+ */
+typedef int (*merge_emit_fn_t)(const void *element, size_t run, void *arg);
+
+/** Merges a number of sorted runs into a single sorted sequence.
+ *
+ * The runs are merged with a loser tree, which takes one comparison per
+ * level of the tree, so about log2(count) comparisons per element, half of
+ * what a binary heap needs. The merge is stable: equal elements come out in
+ * the order of the runs and, within a run, in their original order. With
+ * deduplication only the first or the last element of every group of equal
+ * ones is output.
+ *
+ * All the runs hold elements of the same size compared with the same
+ * function.
+ *
+ * @param[in] runs the runs to merge
+ * @param[in] count number of runs
+ * @param[in] esize size of a single element
+ * @param[in] compare comparison function
+ * @param[in] dedup which of the equal elements to output
+ * @param[in] emit function receiving the merged elements
+ * @param[in] arg argument passed to @c emit
+ *
+ * @return 0 upon success, the value returned by @c emit if it stopped the
+ *         merge, -EINVAL on invalid arguments and -ENOMEM if the tree can't
+ *         be allocated
+ */
+int merge_runs(const struct merge_run *runs, size_t count, size_t esize,
+               compare_fn_t compare, enum merge_dedup dedup,
+               merge_emit_fn_t emit, void *arg);
+
+/** Merges a number of sorted runs at the end of a vector.
+ *
+ * Works like merge_runs() and appends the merged elements to the vector in
+ * batches. The element size is taken from the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] runs the runs to merge
+ * @param[in] count number of runs
+ * @param[in] compare comparison function
+ * @param[in] dedup which of the equal elements to output
+ *
+ * @return 0 upon success and negative error code otherwise, the elements
+ *         merged before an error stay in the vector
+ */
+int merge_runs_vector(struct vector *vector, const struct merge_run *runs,
+                      size_t count, compare_fn_t compare,
+                      enum merge_dedup dedup);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __MERGE_H__
@@ -0,0 +1,156 @@
+/**
+ * @file prefix_index.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "prefix_index.h"
+
+struct prefix_index {
+    uint64_t *prefixes;
+    const char *array;
+    size_t el_count;
+    size_t el_size;
+    key_fn_t key;
+};
+
+static inline int _compare_prefix(const uint64_t *x1, const uint64_t *x2)
+{
+    return (*x1 > *x2) - (*x1 < *x2);
+}
+
+BINARY_SEARCH_DEFINE(_prefix_search, uint64_t, _compare_prefix)
+
+// big endian so that the integers order the same way as the bytes
+static uint64_t _prefix(key_fn_t key, const void *element)
+{
+    size_t size = 0;
+    const unsigned char *bytes = key(element, &size);
+    uint64_t prefix = 0;
+
+    for (size_t i = 0; i < sizeof(prefix); ++i)
+        prefix = prefix << 8 | (i < size ? bytes[i] : 0);
+
+    return prefix;
+}
+
+struct prefix_index *prefix_index_create(const void *array, size_t asize,
+                                         size_t esize, key_fn_t key)
+{
+    if (array == NULL || asize == 0 || asize > SSIZE_MAX || esize == 0 ||
+            key == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    struct prefix_index *index = malloc(sizeof(*index));
+    if (index == NULL)
+        goto return_enomem_;
+
+    index->prefixes = malloc(asize * sizeof(uint64_t));
+    if (index->prefixes == NULL)
+        goto free_index_;
+
+    index->array = array;
+    index->el_count = asize;
+    index->el_size = esize;
+    index->key = key;
+
+    for (size_t i = 0; i < asize; ++i)
+        index->prefixes[i] = _prefix(key, index->array + i * esize);
+
+    return index;
+
+free_index_:
+    free(index);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+}
+
+void prefix_index_destroy(struct prefix_index *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->prefixes);
+    free(index);
+}
+
+// narrows the search to the elements with the same prefix as search
+static void _prefix_range(struct prefix_index *index, const void *search,
+                          size_t *first, size_t *last)
+{
+    uint64_t prefix = _prefix(index->key, search);
+
+    *first = (size_t) _prefix_search_lower_bound(index->prefixes,
+                                                 index->el_count, &prefix);
+    *last = *first +
+            (size_t) _prefix_search_upper_bound(index->prefixes + *first,
+                                                index->el_count - *first,
+                                                &prefix);
+}
+
+ssize_t prefix_index_leftmost(struct prefix_index *index, compare_fn_t compare,
+                              const void *search)
+{
+    if (index == NULL || compare == NULL || search == NULL)
+        return -1;
+
+    size_t first, last;
+    _prefix_range(index, search, &first, &last);
+    if (first == last)
+        return -1;
+
+    ssize_t found = binary_search_leftmost((char *) index->array +
+                                           first * index->el_size,
+                                           last - first, index->el_size,
+                                           compare, (void *) search);
+    return found < 0 ? -1 : (ssize_t) first + found;
+}
+
+ssize_t prefix_index_rightmost(struct prefix_index *index,
+                               compare_fn_t compare, const void *search)
+{
+    if (index == NULL || compare == NULL || search == NULL)
+        return -1;
+
+    size_t first, last;
+    _prefix_range(index, search, &first, &last);
+    if (first == last)
+        return -1;
+
+    ssize_t found = binary_search_rightmost((char *) index->array +
+                                            first * index->el_size,
+                                            last - first, index->el_size,
+                                            compare, (void *) search);
+    return found < 0 ? -1 : (ssize_t) first + found;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file prefix_index.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __PREFIX_INDEX_H__
+#define __PREFIX_INDEX_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Returns the key bytes of an element and stores their number in size. */
+typedef const void *(*key_fn_t)(const void *element, size_t *size);
+
+struct prefix_index;
+
+/** Builds a column of key prefixes for a sorted array.
+ *
+ * The first 8 bytes of the key of every element, zero padded, are stored as
+ * a big endian integer in a compact side array. Searches bisect the prefixes
+ * first and call the comparator, which usually follows a pointer to another
+ * cache line, only for the elements whose prefix equals the one of the
+ * searched key.
+ *
+ * The keys have to be ordered as byte strings (memcmp() with the shorter
+ * key first on a tie) consistently with the comparator used for searching:
+ * whenever the key of a is less than the key of b, a must compare less
+ * than b. To index e.g. integers the key function has to return them in
+ * big endian byte order.
+ *
+ * The index refers to the array which has to outlive it and stay unchanged.
+ *
+ * @param[in] array the array sorted in ascending order
+ * @param[in] asize number of elements in the array
+ * @param[in] esize size of a single element
+ * @param[in] key function returning the key of an element
+ *
+ * @return pointer to the index or NULL on error, @c errno is set to indicate
+ *         the error
+ */
+struct prefix_index *prefix_index_create(const void *array, size_t asize,
+                                         size_t esize, key_fn_t key);
+
+/** Destroys the index.
+ *
+ * @param[in] index pointer to the index
+ */
+void prefix_index_destroy(struct prefix_index *index);
+
+/** Same as binary_search_leftmost() on the indexed array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] compare comparison function, called as compare(search, element)
+ * @param[in] search the element to look for, its key is taken with the key
+ *            function of the index
+ *
+ * @return position of the first equal element or -1 if there is none
+ */
+ssize_t prefix_index_leftmost(struct prefix_index *index, compare_fn_t compare,
+                              const void *search);
+
+/** Same as binary_search_rightmost() on the indexed array.
+ *
+ * @param[in] index pointer to the index
+ * @param[in] compare comparison function, called as compare(search, element)
+ * @param[in] search the element to look for, its key is taken with the key
+ *            function of the index
+ *
+ * @return position of the last equal element or -1 if there is none
+ */
+ssize_t prefix_index_rightmost(struct prefix_index *index,
+                               compare_fn_t compare, const void *search);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __PREFIX_INDEX_H__
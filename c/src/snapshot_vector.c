@@ -0,0 +1,492 @@
+/**
+ * @file snapshot_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot_vector.h"
+
+#define DEFAULT_CHUNK_SIZE 256
+
+// Reclamation follows the classic epoch based scheme: a reader announces the
+// global epoch before it loads the current version, a retired version is
+// tagged with the epoch of its retirement and the global epoch only moves
+// forward once every pinned reader has announced it. A version retired in
+// epoch E can't be pinned by anybody once the global epoch reaches E + 2.
+//
+// Chunk reference counts and the list of retired versions are only touched
+// by writers which are serialised with a mutex.
+
+struct _chunk {
+    size_t refs;
+    alignas(max_align_t) char data[];
+};
+
+struct snapshot {
+    size_t el_size;
+    size_t chunk_size;
+    size_t count;
+    size_t chunk_count;
+    struct _chunk **chunks;
+
+    struct snapshot *next_retired;
+    uint64_t retired_epoch;
+};
+
+struct snapshot_reader {
+    struct snapshot_reader *next;
+    struct snapshot_vector *vector;
+    atomic_bool in_use;
+    atomic_uint_fast64_t epoch;     //!< announced epoch, 0 if nothing pinned
+};
+
+struct snapshot_txn {
+    struct snapshot_vector *vector;
+    struct snapshot *draft;
+};
+
+struct snapshot_vector {
+    size_t el_size;
+    size_t chunk_size;
+
+    _Atomic(struct snapshot *) current;
+    atomic_uint_fast64_t epoch;
+    _Atomic(struct snapshot_reader *) readers;
+
+    pthread_mutex_t writer;
+    struct snapshot *retired;
+};
+
+// ----- chunks and versions ---------------------------------------------------
+
+static struct _chunk *_chunk_create(struct snapshot *snap)
+{
+    struct _chunk *chunk = malloc(sizeof(*chunk) +
+                                  snap->chunk_size * snap->el_size);
+    if (chunk != NULL)
+        chunk->refs = 1;
+    return chunk;
+}
+
+static void _chunk_put(struct _chunk *chunk)
+{
+    if (--chunk->refs == 0)
+        free(chunk);
+}
+
+static struct snapshot *_snapshot_create(size_t el_size, size_t chunk_size)
+{
+    struct snapshot *snap = calloc(1, sizeof(*snap));
+    if (snap != NULL) {
+        snap->el_size = el_size;
+        snap->chunk_size = chunk_size;
+    }
+    return snap;
+}
+
+static void _snapshot_destroy(struct snapshot *snap)
+{
+    for (size_t i = 0; i < snap->chunk_count; i++)
+        _chunk_put(snap->chunks[i]);
+    free(snap->chunks);
+    free(snap);
+}
+
+static struct snapshot *_snapshot_clone(struct snapshot *base)
+{
+    struct snapshot *snap = _snapshot_create(base->el_size, base->chunk_size);
+    if (snap == NULL)
+        return NULL;
+
+    if (base->chunk_count > 0) {
+        snap->chunks = malloc(base->chunk_count * sizeof(*snap->chunks));
+        if (snap->chunks == NULL) {
+            free(snap);
+            return NULL;
+        }
+    }
+
+    for (size_t i = 0; i < base->chunk_count; i++) {
+        snap->chunks[i] = base->chunks[i];
+        snap->chunks[i]->refs += 1;
+    }
+
+    snap->count = base->count;
+    snap->chunk_count = base->chunk_count;
+
+    return snap;
+}
+
+static inline char *_element(const struct snapshot *snap, size_t idx)
+{
+    return snap->chunks[idx / snap->chunk_size]->data +
+           ((idx % snap->chunk_size) * snap->el_size);
+}
+
+// makes sure the chunk isn't shared with any other version
+static bool _own_chunk(struct snapshot *snap, size_t chunk_idx)
+{
+    struct _chunk *chunk = snap->chunks[chunk_idx];
+    if (chunk->refs == 1)
+        return true;
+
+    struct _chunk *copy = _chunk_create(snap);
+    if (copy == NULL)
+        return false;
+
+    memcpy(copy->data, chunk->data, snap->chunk_size * snap->el_size);
+    _chunk_put(chunk);
+    snap->chunks[chunk_idx] = copy;
+
+    return true;
+}
+
+// ----- reclamation -----------------------------------------------------------
+
+static bool _try_advance(struct snapshot_vector *sv)
+{
+    uint64_t epoch = atomic_load(&sv->epoch);
+
+    for (struct snapshot_reader *r = atomic_load(&sv->readers); r != NULL;
+            r = r->next) {
+        uint64_t announced = atomic_load(&r->epoch);
+        if (announced != 0 && announced != epoch)
+            return false;
+    }
+
+    atomic_store(&sv->epoch, epoch + 1);
+
+    return true;
+}
+
+static void _reclaim(struct snapshot_vector *sv)
+{
+    // two steps are enough to free everything if no reader is pinned, if
+    // some are then whatever is left gets freed by one of the next commits
+    if (_try_advance(sv))
+        _try_advance(sv);
+
+    uint64_t epoch = atomic_load(&sv->epoch);
+
+    struct snapshot **link = &sv->retired;
+    while (*link != NULL) {
+        struct snapshot *snap = *link;
+
+        if (snap->retired_epoch + 2 <= epoch) {
+            *link = snap->next_retired;
+            _snapshot_destroy(snap);
+        } else {
+            link = &snap->next_retired;
+        }
+    }
+}
+
+// ----- vector ----------------------------------------------------------------
+
+struct snapshot_vector *snapshot_vector_create(size_t chunk_size,
+                                               size_t el_size)
+{
+    if (el_size == 0)
+        goto return_null_;
+
+    if (chunk_size == 0)
+        chunk_size = DEFAULT_CHUNK_SIZE;
+
+    struct snapshot_vector *sv = malloc(sizeof(*sv));
+    if (sv == NULL)
+        goto return_null_;
+
+    struct snapshot *snap = _snapshot_create(el_size, chunk_size);
+    if (snap == NULL)
+        goto free_vector_;
+
+    sv->el_size = el_size;
+    sv->chunk_size = chunk_size;
+    sv->retired = NULL;
+    atomic_init(&sv->current, snap);
+    atomic_init(&sv->epoch, 1);
+    atomic_init(&sv->readers, NULL);
+
+    if (pthread_mutex_init(&sv->writer, NULL) != 0)
+        goto free_snapshot_;
+
+    return sv;
+
+free_snapshot_:
+    _snapshot_destroy(snap);
+free_vector_:
+    free(sv);
+return_null_:
+    return NULL;
+}
+
+struct snapshot_vector *snapshot_vector_create_from(size_t chunk_size,
+                                                    struct vector *vector)
+{
+    if (vector == NULL)
+        return NULL;
+
+    struct snapshot_vector *sv = snapshot_vector_create(
+            chunk_size, vector_element_size(vector));
+    if (sv == NULL)
+        return NULL;
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    if (txn == NULL)
+        goto destroy_vector_;
+
+    for (size_t i = 0; i < vector_size(vector); i++) {
+        if (snapshot_txn_push_back(txn, vector_get(vector, i)) != 0) {
+            snapshot_txn_abort(txn);
+            goto destroy_vector_;
+        }
+    }
+
+    snapshot_txn_commit(txn);
+
+    return sv;
+
+destroy_vector_:
+    snapshot_vector_destroy(sv);
+    return NULL;
+}
+
+void snapshot_vector_destroy(struct snapshot_vector *sv)
+{
+    if (sv == NULL)
+        return;
+
+    while (sv->retired != NULL) {
+        struct snapshot *snap = sv->retired;
+        sv->retired = snap->next_retired;
+        _snapshot_destroy(snap);
+    }
+
+    _snapshot_destroy(atomic_load(&sv->current));
+
+    struct snapshot_reader *r = atomic_load(&sv->readers);
+    while (r != NULL) {
+        struct snapshot_reader *next = r->next;
+        free(r);
+        r = next;
+    }
+
+    pthread_mutex_destroy(&sv->writer);
+    free(sv);
+}
+
+// ----- readers ---------------------------------------------------------------
+
+struct snapshot_reader *snapshot_vector_reader(struct snapshot_vector *sv)
+{
+    if (sv == NULL)
+        return NULL;
+
+    for (struct snapshot_reader *r = atomic_load(&sv->readers); r != NULL;
+            r = r->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&r->in_use, &expected, true))
+            return r;
+    }
+
+    struct snapshot_reader *r = malloc(sizeof(*r));
+    if (r == NULL)
+        return NULL;
+
+    r->vector = sv;
+    atomic_init(&r->in_use, true);
+    atomic_init(&r->epoch, 0);
+
+    r->next = atomic_load(&sv->readers);
+    while (!atomic_compare_exchange_weak(&sv->readers, &r->next, r))
+        ;
+
+    return r;
+}
+
+void snapshot_reader_release(struct snapshot_reader *r)
+{
+    if (r == NULL)
+        return;
+
+    atomic_store(&r->epoch, 0);
+    atomic_store(&r->in_use, false);
+}
+
+const struct snapshot *snapshot_pin(struct snapshot_reader *r)
+{
+    atomic_store(&r->epoch, atomic_load(&r->vector->epoch));
+    return atomic_load(&r->vector->current);
+}
+
+void snapshot_unpin(struct snapshot_reader *r)
+{
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+}
+
+size_t snapshot_size(const struct snapshot *snap)
+{
+    return snap->count;
+}
+
+const void *snapshot_get(const struct snapshot *snap, size_t idx)
+{
+    if (snap == NULL || idx >= snap->count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return _element(snap, idx);
+}
+
+// ----- writers ---------------------------------------------------------------
+
+struct snapshot_txn *snapshot_vector_begin(struct snapshot_vector *sv)
+{
+    if (sv == NULL)
+        return NULL;
+
+    struct snapshot_txn *txn = malloc(sizeof(*txn));
+    if (txn == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&sv->writer);
+
+    txn->vector = sv;
+    txn->draft = _snapshot_clone(atomic_load(&sv->current));
+    if (txn->draft == NULL) {
+        pthread_mutex_unlock(&sv->writer);
+        free(txn);
+        return NULL;
+    }
+
+    return txn;
+}
+
+void snapshot_txn_commit(struct snapshot_txn *txn)
+{
+    struct snapshot_vector *sv = txn->vector;
+
+    struct snapshot *old = atomic_exchange(&sv->current, txn->draft);
+
+    old->retired_epoch = atomic_load(&sv->epoch);
+    old->next_retired = sv->retired;
+    sv->retired = old;
+
+    _reclaim(sv);
+
+    pthread_mutex_unlock(&sv->writer);
+    free(txn);
+}
+
+void snapshot_txn_abort(struct snapshot_txn *txn)
+{
+    struct snapshot_vector *sv = txn->vector;
+
+    _snapshot_destroy(txn->draft);
+
+    pthread_mutex_unlock(&sv->writer);
+    free(txn);
+}
+
+size_t snapshot_txn_size(struct snapshot_txn *txn)
+{
+    return txn->draft->count;
+}
+
+const void *snapshot_txn_get(struct snapshot_txn *txn, size_t idx)
+{
+    return snapshot_get(txn->draft, idx);
+}
+
+int snapshot_txn_set(struct snapshot_txn *txn, size_t idx, const void *el)
+{
+    struct snapshot *snap = txn->draft;
+
+    if (el == NULL || idx >= snap->count)
+        return -EINVAL;
+
+    if (!_own_chunk(snap, idx / snap->chunk_size))
+        return -ENOMEM;
+
+    memcpy(_element(snap, idx), el, snap->el_size);
+
+    return 0;
+}
+
+int snapshot_txn_push_back(struct snapshot_txn *txn, const void *el)
+{
+    struct snapshot *snap = txn->draft;
+
+    if (el == NULL)
+        return -EINVAL;
+
+    if (snap->count == snap->chunk_count * snap->chunk_size) {
+        struct _chunk **chunks = realloc(snap->chunks,
+                                         (snap->chunk_count + 1) *
+                                         sizeof(*chunks));
+        if (chunks == NULL)
+            return -ENOMEM;
+        snap->chunks = chunks;
+
+        chunks[snap->chunk_count] = _chunk_create(snap);
+        if (chunks[snap->chunk_count] == NULL)
+            return -ENOMEM;
+        snap->chunk_count += 1;
+    } else if (!_own_chunk(snap, snap->count / snap->chunk_size)) {
+        return -ENOMEM;
+    }
+
+    memcpy(_element(snap, snap->count), el, snap->el_size);
+    snap->count += 1;
+
+    return 0;
+}
+
+int snapshot_txn_pop_back(struct snapshot_txn *txn)
+{
+    struct snapshot *snap = txn->draft;
+
+    if (snap->count == 0)
+        return -EINVAL;
+
+    snap->count -= 1;
+
+    // the slot left behind doesn't need to be copied, it's never read
+    if (snap->count == (snap->chunk_count - 1) * snap->chunk_size) {
+        snap->chunk_count -= 1;
+        _chunk_put(snap->chunks[snap->chunk_count]);
+    }
+
+    return 0;
+}
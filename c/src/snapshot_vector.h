@@ -0,0 +1,214 @@
+/**
+ * @file snapshot_vector.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SNAPSHOT_VECTOR_H__
+#define __SNAPSHOT_VECTOR_H__
+
+#include <stddef.h>
+
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct snapshot_vector;
+struct snapshot_reader;
+struct snapshot_txn;
+struct snapshot;
+
+/** Creates a vector with copy-on-write snapshots.
+ *
+ * The vector is meant for data that is read very often and updated rarely.
+ * Readers never lock: they pin the current version (a snapshot) and can use
+ * it for as long as they want while writers prepare and publish new
+ * versions. The elements are stored in chunks which are shared between the
+ * versions as long as they're not modified. Versions no longer used by any
+ * reader are reclaimed with epoch based reclamation.
+ *
+ * @param[in] chunk_size number of elements in a chunk, if 0 then a default
+ *            is used
+ * @param[in] el_size size of the vector's element
+ *
+ * @return pointer to the vector object or NULL on error
+ */
+struct snapshot_vector *snapshot_vector_create(size_t chunk_size,
+                                               size_t el_size);
+
+/** Creates a vector with copy-on-write snapshots holding a copy of a vector.
+ *
+ * @param[in] chunk_size number of elements in a chunk, if 0 then a default
+ *            is used
+ * @param[in] vector the vector to copy the elements from
+ *
+ * @return pointer to the vector object or NULL on error
+ */
+struct snapshot_vector *snapshot_vector_create_from(size_t chunk_size,
+                                                    struct vector *vector);
+
+/** Destroys the vector.
+ *
+ * No snapshot may be pinned and no transaction may be open during this call.
+ * All the readers are released.
+ *
+ * @param[in] vector pointer to the vector object
+ */
+void snapshot_vector_destroy(struct snapshot_vector *vector);
+
+/** Registers a reader.
+ *
+ * Every thread reading the vector needs its own reader. Readers released
+ * with snapshot_reader_release() are reused.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return pointer to the reader or NULL on error
+ */
+struct snapshot_reader *snapshot_vector_reader(struct snapshot_vector *vector);
+
+/** Releases a reader.
+ *
+ * @param[in] reader pointer to the reader, must not have a snapshot pinned
+ */
+void snapshot_reader_release(struct snapshot_reader *reader);
+
+/** Pins the current version of the vector.
+ *
+ * Wait-free. The snapshot stays valid and unchanged until
+ * snapshot_unpin() is called. A reader can pin only one snapshot at a time.
+ *
+ * @param[in] reader pointer to the reader
+ *
+ * @return pointer to the snapshot
+ */
+const struct snapshot *snapshot_pin(struct snapshot_reader *reader);
+
+/** Unpins the snapshot pinned by the reader.
+ *
+ * @param[in] reader pointer to the reader
+ */
+void snapshot_unpin(struct snapshot_reader *reader);
+
+/** Returns number of elements in the snapshot.
+ *
+ * @param[in] snapshot pointer to the snapshot
+ *
+ * @return number of elements
+ */
+size_t snapshot_size(const struct snapshot *snapshot);
+
+/** Gets an element from the snapshot.
+ *
+ * @param[in] snapshot pointer to the snapshot
+ * @param[in] index position of the element to retrieve
+ *
+ * @return pointer to the element or NULL if there is no such element
+ */
+const void *snapshot_get(const struct snapshot *snapshot, size_t index);
+
+/** Starts a new version of the vector.
+ *
+ * Writers are serialised, this call blocks until the previous transaction is
+ * committed or aborted. The new version starts as a copy of the current one
+ * sharing all its chunks.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return pointer to the transaction or NULL on error
+ */
+struct snapshot_txn *snapshot_vector_begin(struct snapshot_vector *vector);
+
+/** Publishes the new version.
+ *
+ * The new version atomically replaces the current one. The previous version
+ * is reclaimed right away if no reader has anything pinned, otherwise by one
+ * of the following commits once no reader can still be using it. The
+ * transaction object is freed.
+ *
+ * @param[in] txn pointer to the transaction
+ */
+void snapshot_txn_commit(struct snapshot_txn *txn);
+
+/** Drops the new version and frees the transaction.
+ *
+ * @param[in] txn pointer to the transaction
+ */
+void snapshot_txn_abort(struct snapshot_txn *txn);
+
+/** Returns number of elements in the new version.
+ *
+ * @param[in] txn pointer to the transaction
+ *
+ * @return number of elements
+ */
+size_t snapshot_txn_size(struct snapshot_txn *txn);
+
+/** Gets an element from the new version.
+ *
+ * @param[in] txn pointer to the transaction
+ * @param[in] index position of the element to retrieve
+ *
+ * @return pointer to the element or NULL if there is no such element
+ */
+const void *snapshot_txn_get(struct snapshot_txn *txn, size_t index);
+
+/** Sets an element in the new version.
+ *
+ * The chunk holding the element is copied first if it's shared with other
+ * versions.
+ *
+ * @param[in] txn pointer to the transaction
+ * @param[in] index position of the element to set
+ * @param[in] element data of the element that will be copied to the vector
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int snapshot_txn_set(struct snapshot_txn *txn, size_t index,
+                     const void *element);
+
+/** Appends an element to the new version.
+ *
+ * @param[in] txn pointer to the transaction
+ * @param[in] element data of the element that will be copied to the vector
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int snapshot_txn_push_back(struct snapshot_txn *txn, const void *element);
+
+/** Removes the last element from the new version.
+ *
+ * @param[in] txn pointer to the transaction
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int snapshot_txn_pop_back(struct snapshot_txn *txn);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SNAPSHOT_VECTOR_H__
@@ -0,0 +1,279 @@
+/**
+ * @file soa_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "soa_vector.h"
+
+#define CACHE_LINE_SIZE 64
+
+struct soa_vector {
+    char *storage;              //!< all the columns in one allocation
+    size_t *columns;            //!< offsets of the columns in the storage
+    struct soa_field *fields;
+    size_t field_count;
+    size_t record_size;
+    size_t min_capacity;
+    size_t capacity;
+    size_t el_count;
+};
+
+static inline size_t _ceil_pow2(size_t x)
+{
+    return (size_t) 1 << (sizeof(x) * __CHAR_BIT__ - __builtin_clzl(x - 1));
+}
+
+static inline size_t _init_capacity(size_t size)
+{
+    const size_t min_capacity = 32;
+    return size < min_capacity ? min_capacity : _ceil_pow2(size);
+}
+
+static inline size_t _align(size_t size)
+{
+    return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+static inline char *_cell(struct soa_vector *vec, size_t field, size_t idx)
+{
+    return vec->storage + vec->columns[field] + (idx * vec->fields[field].size);
+}
+
+// allocates storage for new_capacity records and lays out the columns in it,
+// the new offsets are written to columns
+static char *_allocate(struct soa_vector *vec, size_t new_capacity,
+                       size_t *columns)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        if (new_capacity > SIZE_MAX / 2 / vec->fields[i].size)
+            return NULL;
+        columns[i] = total;
+        total += _align(new_capacity * vec->fields[i].size);
+    }
+
+    return aligned_alloc(CACHE_LINE_SIZE, total);
+}
+
+static bool _resize(struct soa_vector *vec, size_t new_capacity)
+{
+    size_t *columns = malloc(vec->field_count * sizeof(*columns));
+    if (columns == NULL) {
+        errno = ENOMEM;
+        return false;
+    }
+
+    char *storage = _allocate(vec, new_capacity, columns);
+    if (storage == NULL) {
+        free(columns);
+        errno = ENOMEM;
+        return false;
+    }
+
+    size_t count = vec->el_count < new_capacity ? vec->el_count : new_capacity;
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        memcpy(storage + columns[i], vec->storage + vec->columns[i],
+               count * vec->fields[i].size);
+    }
+
+    free(vec->storage);
+    free(vec->columns);
+
+    vec->storage = storage;
+    vec->columns = columns;
+    vec->capacity = new_capacity;
+
+    return true;
+}
+
+struct soa_vector *soa_vector_create(size_t capacity, size_t record_size,
+                                     const struct soa_field *fields,
+                                     size_t field_count)
+{
+    if (record_size == 0 || fields == NULL || field_count == 0)
+        goto return_null_;
+
+    for (size_t i = 0; i < field_count; i++) {
+        if (fields[i].size == 0 || fields[i].offset > record_size ||
+                fields[i].size > record_size - fields[i].offset)
+            goto return_null_;
+    }
+
+    struct soa_vector *vec = calloc(1, sizeof(*vec));
+    if (vec == NULL)
+        goto return_null_;
+
+    vec->fields = malloc(field_count * sizeof(*vec->fields));
+    vec->columns = malloc(field_count * sizeof(*vec->columns));
+    if (vec->fields == NULL || vec->columns == NULL)
+        goto free_vector_;
+
+    memcpy(vec->fields, fields, field_count * sizeof(*fields));
+    vec->field_count = field_count;
+    vec->record_size = record_size;
+
+    size_t new_capacity = _init_capacity(capacity);
+
+    vec->storage = _allocate(vec, new_capacity, vec->columns);
+    if (vec->storage == NULL)
+        goto free_vector_;
+
+    for (size_t i = 0; i < field_count; i++)
+        memset(_cell(vec, i, 0), 0, capacity * fields[i].size);
+
+    vec->min_capacity = new_capacity;
+    vec->capacity = new_capacity;
+    vec->el_count = capacity;
+
+    return vec;
+
+free_vector_:
+    free(vec->columns);
+    free(vec->fields);
+    free(vec);
+return_null_:
+    return NULL;
+}
+
+void soa_vector_destroy(struct soa_vector *vector)
+{
+    if (vector == NULL)
+        return;
+
+    free(vector->storage);
+    free(vector->columns);
+    free(vector->fields);
+    free(vector);
+}
+
+size_t soa_vector_size(struct soa_vector *vector)
+{
+    return vector->el_count;
+}
+
+size_t soa_vector_capacity(struct soa_vector *vector)
+{
+    return vector->capacity;
+}
+
+int soa_vector_insert(struct soa_vector *vec, size_t idx, const void *record)
+{
+    if (vec == NULL || record == NULL || idx > vec->el_count)
+        return -EINVAL;
+
+    if (vec->el_count == vec->capacity) {
+        if (!_resize(vec, (size_t) (vec->capacity * 3 / 2)))
+            return -ENOMEM;
+    }
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        size_t size = vec->fields[i].size;
+
+        memmove(_cell(vec, i, idx + 1), _cell(vec, i, idx),
+                (vec->el_count - idx) * size);
+        memcpy(_cell(vec, i, idx),
+               (const char *) record + vec->fields[i].offset, size);
+    }
+
+    vec->el_count += 1;
+
+    return 0;
+}
+
+int soa_vector_remove(struct soa_vector *vec, size_t idx)
+{
+    if (vec == NULL || idx >= vec->el_count)
+        return -EINVAL;
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        memmove(_cell(vec, i, idx), _cell(vec, i, idx + 1),
+                (vec->el_count - idx - 1) * vec->fields[i].size);
+    }
+
+    vec->el_count -= 1;
+
+    if (vec->el_count < vec->capacity / 2 &&
+            vec->capacity > vec->min_capacity) {
+        // the same as for struct vector, failing to shrink is not an error
+        (void) _resize(vec, (size_t) (vec->capacity * 2 / 3));
+    }
+
+    return 0;
+}
+
+void soa_vector_set(struct soa_vector *vec, size_t idx, const void *record)
+{
+    if (vec == NULL || record == NULL || idx >= vec->el_count) {
+        errno = EINVAL;
+        return;
+    }
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        memcpy(_cell(vec, i, idx),
+               (const char *) record + vec->fields[i].offset,
+               vec->fields[i].size);
+    }
+}
+
+int soa_vector_get(struct soa_vector *vec, size_t idx, void *record)
+{
+    if (vec == NULL || record == NULL || idx >= vec->el_count)
+        return -EINVAL;
+
+    for (size_t i = 0; i < vec->field_count; i++) {
+        memcpy((char *) record + vec->fields[i].offset, _cell(vec, i, idx),
+               vec->fields[i].size);
+    }
+
+    return 0;
+}
+
+void *soa_vector_field(struct soa_vector *vec, size_t idx, size_t field)
+{
+    if (vec == NULL || idx >= vec->el_count || field >= vec->field_count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return _cell(vec, field, idx);
+}
+
+void *soa_vector_column(struct soa_vector *vec, size_t field)
+{
+    if (vec == NULL || field >= vec->field_count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return _cell(vec, field, 0);
+}
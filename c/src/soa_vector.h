@@ -0,0 +1,175 @@
+/**
+ * @file soa_vector.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SOA_VECTOR_H__
+#define __SOA_VECTOR_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Describes a single field of a record. */
+struct soa_field {
+    size_t offset;      //!< offset of the field within the record
+    size_t size;        //!< size of the field
+};
+
+/** Static initializer of a field description.
+ *
+ * @param[in] type type of the record
+ * @param[in] member name of the field in the record
+ */
+#define SOA_FIELD(type, member) \
+    {offsetof(type, member), sizeof(((type *) 0)->member)}
+
+struct soa_vector;
+
+/** Creates a structure-of-arrays vector.
+ *
+ * Records put into the vector are split into fields and every field is stored
+ * in its own contiguous, cache line aligned column. This way loops that only
+ * touch one field don't pull the other fields into the cache.
+ *
+ * Capacity handling is the same as for @c vector_create(), i.e. if
+ * @c capacity is greater than 0 the vector will hold @c capacity records
+ * initialised to 0.
+ *
+ * @param[in] capacity minimum capacity of the vector
+ * @param[in] record_size size of the record
+ * @param[in] fields array of field descriptions, see SOA_FIELD()
+ * @param[in] field_count number of fields
+ *
+ * @return pointer to the vector object or NULL on error
+ */
+struct soa_vector *soa_vector_create(size_t capacity, size_t record_size,
+                                     const struct soa_field *fields,
+                                     size_t field_count);
+
+/** Destroys the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ */
+void soa_vector_destroy(struct soa_vector *vector);
+
+/** Returns number of records currently residing in the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return number of records in the vector
+ */
+size_t soa_vector_size(struct soa_vector *vector);
+
+/** Returns vectors capacity.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return vector's capacity
+ */
+size_t soa_vector_capacity(struct soa_vector *vector);
+
+/** Inserts a record at a given position in the vector.
+ *
+ * This call may trigger a resize operation if the vector runs out of space.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position to place the new record at
+ * @param[in] record the record to split into the columns
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int soa_vector_insert(struct soa_vector *vector, size_t index,
+                      const void *record);
+
+/** Removes a record at a given position from the vector.
+ *
+ * This call may trigger a vector resize operation if the number of records
+ * falls under predefined threshold.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position of the record to remove
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int soa_vector_remove(struct soa_vector *vector, size_t index);
+
+/** Sets a record in the vector.
+ *
+ * If the size of the vector is less than @c index then this is a NOP and
+ * @c errno code is set to indicate the error.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position of the record to set
+ * @param[in] record the record to split into the columns
+ */
+void soa_vector_set(struct soa_vector *vector, size_t index,
+                    const void *record);
+
+/** Gets a record from the vector.
+ *
+ * The fields are gathered from the columns into @c record. Bytes of the
+ * record not covered by any field are left untouched.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position of the record to retrieve
+ * @param[out] record the record to fill
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int soa_vector_get(struct soa_vector *vector, size_t index, void *record);
+
+/** Gets a single field of a record.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] index position of the record
+ * @param[in] field index of the field in the array passed to
+ *            soa_vector_create()
+ *
+ * @return pointer to the field or NULL if there is no such record or field
+ */
+void *soa_vector_field(struct soa_vector *vector, size_t index, size_t field);
+
+/** Returns a raw pointer to a column.
+ *
+ * The column holds @c soa_vector_size() values of the field stored one after
+ * another and is aligned to the cache line size. The pointer is only valid
+ * until the next operation that may resize the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] field index of the field in the array passed to
+ *            soa_vector_create()
+ *
+ * @return pointer to the column or NULL if there is no such field
+ */
+void *soa_vector_column(struct soa_vector *vector, size_t field);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SOA_VECTOR_H__
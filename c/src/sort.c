@@ -0,0 +1,444 @@
+/**
+ * @file sort.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sort.h"
+
+#define SWAP_CHUNK 64
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+static inline char *_at(char *array, size_t idx, size_t el_size)
+{
+    return array + (idx * el_size);
+}
+
+// the common element sizes get copies of constant size the compiler turns
+// into single loads and stores
+
+static inline void _copy(char *dst, const char *src, size_t el_size)
+{
+    if (el_size == sizeof(uint64_t))
+        memcpy(dst, src, sizeof(uint64_t));
+    else if (el_size == sizeof(uint32_t))
+        memcpy(dst, src, sizeof(uint32_t));
+    else
+        memcpy(dst, src, el_size);
+}
+
+static inline void _swap(char *x1, char *x2, size_t el_size)
+{
+    if (el_size == sizeof(uint64_t)) {
+        uint64_t tmp;
+        memcpy(&tmp, x1, sizeof(tmp));
+        memcpy(x1, x2, sizeof(tmp));
+        memcpy(x2, &tmp, sizeof(tmp));
+        return;
+    }
+    if (el_size == sizeof(uint32_t)) {
+        uint32_t tmp;
+        memcpy(&tmp, x1, sizeof(tmp));
+        memcpy(x1, x2, sizeof(tmp));
+        memcpy(x2, &tmp, sizeof(tmp));
+        return;
+    }
+
+    char tmp[SWAP_CHUNK];
+
+    while (el_size > 0) {
+        size_t n = el_size < SWAP_CHUNK ? el_size : SWAP_CHUNK;
+
+        memcpy(tmp, x1, n);
+        memcpy(x1, x2, n);
+        memcpy(x2, tmp, n);
+
+        x1 += n;
+        x2 += n;
+        el_size -= n;
+    }
+}
+
+static bool _check(void *array, size_t asize, size_t el_size)
+{
+    return (array != NULL || asize == 0) && el_size > 0 &&
+           asize <= SSIZE_MAX / el_size;
+}
+
+// ----- introsort -------------------------------------------------------------
+
+// swaps instead of shifting through a temporary element, so elements of any
+// size are sorted without allocating
+static void _insertion(char *array, size_t asize, size_t el_size,
+                       compare_fn_t compare)
+{
+    for (size_t i = 1; i < asize; i++) {
+        for (size_t j = i; j > 0; j--) {
+            char *prev = _at(array, j - 1, el_size);
+            char *cur = _at(array, j, el_size);
+
+            if (compare(cur, prev) >= 0)
+                break;
+            _swap(cur, prev, el_size);
+        }
+    }
+}
+
+static void _sift(char *array, size_t root, size_t asize, size_t el_size,
+                  compare_fn_t compare)
+{
+    for (size_t child; (child = 2 * root + 1) < asize; root = child) {
+        if (child + 1 < asize && compare(_at(array, child, el_size),
+                                         _at(array, child + 1, el_size)) < 0)
+            child++;
+        if (compare(_at(array, root, el_size),
+                    _at(array, child, el_size)) >= 0)
+            return;
+        _swap(_at(array, root, el_size), _at(array, child, el_size), el_size);
+    }
+}
+
+static void _heapsort(char *array, size_t asize, size_t el_size,
+                      compare_fn_t compare)
+{
+    for (size_t i = asize / 2; i-- > 0;)
+        _sift(array, i, asize, el_size, compare);
+
+    for (size_t i = asize; i-- > 1;) {
+        _swap(array, _at(array, i, el_size), el_size);
+        _sift(array, 0, i, el_size, compare);
+    }
+}
+
+// moves the median of the first, middle and last element to the front
+static void _pivot(char *array, size_t asize, size_t el_size,
+                   compare_fn_t compare)
+{
+    char *mid = _at(array, asize / 2, el_size);
+    char *last = _at(array, asize - 1, el_size);
+
+    if (compare(mid, array) < 0)
+        _swap(mid, array, el_size);
+    if (compare(last, mid) < 0) {
+        _swap(last, mid, el_size);
+        if (compare(mid, array) < 0)
+            _swap(mid, array, el_size);
+    }
+
+    _swap(array, mid, el_size);
+}
+
+static void _introsort(char *array, size_t asize, size_t el_size,
+                       compare_fn_t compare, unsigned depth)
+{
+    while (asize > SORT_INSERTION_THRESHOLD) {
+        if (depth-- == 0) {
+            _heapsort(array, asize, el_size, compare);
+            return;
+        }
+
+        _pivot(array, asize, el_size, compare);
+
+        // both scans stop on elements equal to the pivot, which splits runs
+        // of equal elements evenly
+        size_t i = 0, j = asize;
+        for (;;) {
+            do {
+                i++;
+            } while (i < asize &&
+                     compare(_at(array, i, el_size), array) < 0);
+            do {
+                j--;
+            } while (compare(_at(array, j, el_size), array) > 0);
+
+            if (i >= j)
+                break;
+            _swap(_at(array, i, el_size), _at(array, j, el_size), el_size);
+        }
+        _swap(array, _at(array, j, el_size), el_size);
+
+        // recurse into the shorter part so the stack stays O(log n)
+        if (j < asize - j - 1) {
+            _introsort(array, j, el_size, compare, depth);
+            array = _at(array, j + 1, el_size);
+            asize -= j + 1;
+        } else {
+            _introsort(_at(array, j + 1, el_size), asize - j - 1, el_size,
+                       compare, depth);
+            asize = j;
+        }
+    }
+
+    _insertion(array, asize, el_size, compare);
+}
+
+int sort(void *array, size_t asize, size_t esize, compare_fn_t compare)
+{
+    if (!_check(array, asize, esize) || compare == NULL)
+        return -EINVAL;
+
+    _introsort(array, asize, esize, compare, sort_depth_limit_(asize));
+
+    return 0;
+}
+
+// ----- merge sort ------------------------------------------------------------
+
+// merges [left, mid) and [mid, end) of src into dst, equal elements are
+// taken from the left run first
+static void _merge(const char *src, char *dst, size_t left, size_t mid,
+                   size_t end, size_t el_size, compare_fn_t compare)
+{
+    size_t l = left, r = mid, out = left;
+
+    // already in order, typical for partially sorted input
+    if (mid > left && mid < end &&
+            compare(src + (mid * el_size), src + ((mid - 1) * el_size)) >= 0) {
+        memcpy(dst + (left * el_size), src + (left * el_size),
+               (end - left) * el_size);
+        return;
+    }
+
+    while (l < mid && r < end) {
+        const char *x1 = src + (l * el_size), *x2 = src + (r * el_size);
+
+        if (compare(x2, x1) < 0) {
+            _copy(dst + (out++ * el_size), x2, el_size);
+            r++;
+        } else {
+            _copy(dst + (out++ * el_size), x1, el_size);
+            l++;
+        }
+    }
+
+    memcpy(dst + (out * el_size), src + (l * el_size), (mid - l) * el_size);
+    out += mid - l;
+    memcpy(dst + (out * el_size), src + (r * el_size), (end - r) * el_size);
+}
+
+int sort_stable_buffered(void *array, size_t asize, size_t esize,
+                         compare_fn_t compare, void *buffer)
+{
+    if (!_check(array, asize, esize) || compare == NULL ||
+            (buffer == NULL && asize > 0))
+        return -EINVAL;
+
+    for (size_t i = 0; i < asize; i += SORT_INSERTION_THRESHOLD) {
+        size_t n = asize - i < SORT_INSERTION_THRESHOLD ?
+                   asize - i : SORT_INSERTION_THRESHOLD;
+        _insertion(_at(array, i, esize), n, esize, compare);
+    }
+
+    char *src = array, *dst = buffer;
+
+    for (size_t width = SORT_INSERTION_THRESHOLD; width < asize; width *= 2) {
+        for (size_t left = 0; left < asize; left += 2 * width) {
+            size_t mid = asize - left < width ? asize : left + width;
+            size_t end = asize - mid < width ? asize : mid + width;
+
+            _merge(src, dst, left, mid, end, esize, compare);
+        }
+
+        char *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != array)
+        memcpy(array, src, asize * esize);
+
+    return 0;
+}
+
+int sort_stable(void *array, size_t asize, size_t esize, compare_fn_t compare)
+{
+    if (!_check(array, asize, esize) || compare == NULL)
+        return -EINVAL;
+    if (asize <= SORT_INSERTION_THRESHOLD)
+        return sort_stable_buffered(array, asize, esize, compare, array);
+
+    void *buffer = malloc(asize * esize);
+    if (buffer == NULL)
+        return -ENOMEM;
+
+    int ret = sort_stable_buffered(array, asize, esize, compare, buffer);
+
+    free(buffer);
+
+    return ret;
+}
+
+// ----- radix sort ------------------------------------------------------------
+
+// Histograms of all the bytes are collected in a single pass over the keys,
+// then every byte with more than one value takes one scatter pass.
+
+static void _histograms(const uint64_t *keys, size_t asize, unsigned bytes,
+                        size_t (*counts)[RADIX_BUCKETS])
+{
+    memset(counts, 0, bytes * sizeof(*counts));
+
+    for (size_t i = 0; i < asize; i++) {
+        for (unsigned b = 0; b < bytes; b++)
+            counts[b][(keys[i] >> (b * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+}
+
+// turns the counts into starting offsets, false when all the keys share
+// the byte and the pass can be skipped
+static bool _offsets(size_t *counts, size_t asize)
+{
+    size_t sum = 0;
+
+    for (size_t i = 0; i < RADIX_BUCKETS; i++) {
+        if (counts[i] == asize)
+            return false;
+
+        size_t count = counts[i];
+        counts[i] = sum;
+        sum += count;
+    }
+
+    return true;
+}
+
+int sort_radix(void *array, size_t asize, size_t esize, sort_key_fn_t key)
+{
+    if (!_check(array, asize, esize) || key == NULL)
+        return -EINVAL;
+    if (asize < 2)
+        return 0;
+    if (asize > SIZE_MAX / (2 * sizeof(uint64_t)))
+        return -ENOMEM;
+
+    int ret = -ENOMEM;
+    size_t (*counts)[RADIX_BUCKETS] = malloc(sizeof(uint64_t) *
+                                             sizeof(*counts));
+    uint64_t *keys = malloc(2 * asize * sizeof(uint64_t));
+    char *buffer = malloc(asize * esize);
+    if (counts == NULL || keys == NULL || buffer == NULL)
+        goto free_all_;
+
+    for (size_t i = 0; i < asize; i++)
+        keys[i] = key(_at(array, i, esize));
+
+    _histograms(keys, asize, sizeof(uint64_t), counts);
+
+    uint64_t *src_keys = keys, *dst_keys = keys + asize;
+    char *src = array, *dst = buffer;
+
+    for (unsigned b = 0; b < sizeof(uint64_t); b++) {
+        if (!_offsets(counts[b], asize))
+            continue;
+
+        for (size_t i = 0; i < asize; i++) {
+            size_t bucket = (src_keys[i] >> (b * RADIX_BITS)) &
+                            (RADIX_BUCKETS - 1);
+            size_t to = counts[b][bucket]++;
+
+            dst_keys[to] = src_keys[i];
+            _copy(_at(dst, to, esize), _at(src, i, esize), esize);
+        }
+
+        uint64_t *swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+
+        char *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != array)
+        memcpy(array, src, asize * esize);
+
+    ret = 0;
+
+free_all_:
+    free(buffer);
+    free(keys);
+    free(counts);
+
+    return ret;
+}
+
+// Signed integers get their sign bit flipped, which orders them the same
+// way as unsigned ones.
+
+#define RADIX_SORT(name, T, U, flip)                                        \
+int sort_radix_##name(T *array, size_t asize)                               \
+{                                                                           \
+    if (array == NULL && asize > 0)                                         \
+        return -EINVAL;                                                     \
+    if (asize < 2)                                                          \
+        return 0;                                                           \
+    if (asize > SIZE_MAX / sizeof(T))                                       \
+        return -ENOMEM;                                                     \
+                                                                            \
+    size_t counts[sizeof(T)][RADIX_BUCKETS] = {{0}};                        \
+    T *buffer = malloc(asize * sizeof(T));                                  \
+    if (buffer == NULL)                                                     \
+        return -ENOMEM;                                                     \
+                                                                            \
+    for (size_t i = 0; i < asize; i++) {                                    \
+        U key = (U) array[i] ^ (flip);                                      \
+        for (unsigned b = 0; b < sizeof(T); b++)                            \
+            counts[b][(key >> (b * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;   \
+    }                                                                       \
+                                                                            \
+    T *src = array, *dst = buffer;                                          \
+    for (unsigned b = 0; b < sizeof(T); b++) {                              \
+        if (!_offsets(counts[b], asize))                                    \
+            continue;                                                       \
+        for (size_t i = 0; i < asize; i++) {                                \
+            U key = (U) src[i] ^ (flip);                                    \
+            dst[counts[b][(key >> (b * RADIX_BITS)) &                       \
+                          (RADIX_BUCKETS - 1)]++] = src[i];                 \
+        }                                                                   \
+        T *swap = src;                                                      \
+        src = dst;                                                          \
+        dst = swap;                                                         \
+    }                                                                       \
+                                                                            \
+    if (src != array)                                                       \
+        memcpy(array, src, asize * sizeof(T));                              \
+    free(buffer);                                                           \
+                                                                            \
+    return 0;                                                               \
+}
+
+RADIX_SORT(i32, int32_t, uint32_t, (uint32_t) 1 << 31)
+RADIX_SORT(u32, uint32_t, uint32_t, 0)
+RADIX_SORT(i64, int64_t, uint64_t, (uint64_t) 1 << 63)
+RADIX_SORT(u64, uint64_t, uint64_t, 0)
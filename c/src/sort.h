@@ -0,0 +1,230 @@
+/**
+ * @file sort.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SORT_H__
+#define __SORT_H__
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// All the sorts order the array ascending according to compare, called the
+// same way as by the binary searches, so their results can be searched
+// directly. They return 0 upon success, -EINVAL on invalid arguments and
+// -ENOMEM when the temporary storage cannot be allocated.
+
+// Introsort: quicksort with median of three pivots falling back to heapsort
+// when the recursion gets too deep and to insertion sort on short ranges.
+// O(n log n) in the worst case, in place, not stable.
+
+int sort(void *array, size_t asize, size_t esize, compare_fn_t compare);
+
+// Merge sort: bottom-up merges of insertion sorted runs through a temporary
+// array of the same size, stable. The buffered variant takes the temporary
+// array of asize * esize bytes from the caller and never fails on memory.
+
+int sort_stable(void *array, size_t asize, size_t esize, compare_fn_t compare);
+int sort_stable_buffered(void *array, size_t asize, size_t esize,
+                         compare_fn_t compare, void *buffer);
+
+// LSD radix sort by an unsigned integer key, one pass per byte of the key
+// skipping the bytes which are the same in all the keys. O(n) for fixed
+// width keys and stable. The generic variant calls key once per element and
+// needs memory for two copies of the keys and one of the array, the typed
+// ones sort the integers themselves and need one copy of the array.
+
+typedef uint64_t (*sort_key_fn_t)(const void *element);
+
+int sort_radix(void *array, size_t asize, size_t esize, sort_key_fn_t key);
+
+int sort_radix_i32(int32_t *array, size_t asize);
+int sort_radix_u32(uint32_t *array, size_t asize);
+int sort_radix_i64(int64_t *array, size_t asize);
+int sort_radix_u64(uint64_t *array, size_t asize);
+
+// ranges up to this long are insertion sorted
+#define SORT_INSERTION_THRESHOLD 16
+
+// introsort switches to heapsort after 2 * log2(n) levels
+static inline unsigned sort_depth_limit_(size_t asize)
+{
+    unsigned depth = 0;
+    for (; asize > 1; asize >>= 1)
+        depth += 2;
+    return depth;
+}
+
+// Generates sorts specialised for one element type:
+//
+//   void name(T *array, size_t asize);
+//   int name##_stable(T *array, size_t asize);
+//
+// cmp is a function or a macro called as cmp(x1, x2) with pointers to T,
+// returning a negative, zero or positive value like compare_fn_t. The
+// functions are static inline so the comparison gets inlined instead of
+// being called through a pointer. name is introsort, name##_stable merge
+// sort returning 0 or -ENOMEM.
+#define SORT_DEFINE(name, T, cmp)                                           \
+static inline void name##_swap_(T *x1, T *x2)                               \
+{                                                                           \
+    T tmp = *x1;                                                            \
+    *x1 = *x2;                                                              \
+    *x2 = tmp;                                                              \
+}                                                                           \
+                                                                            \
+static inline void name##_insertion_(T *array, size_t asize)                \
+{                                                                           \
+    for (size_t i = 1; i < asize; i++) {                                    \
+        T el = array[i];                                                    \
+        size_t j = i;                                                       \
+        for (; j > 0 && cmp(&el, &array[j - 1]) < 0; j--)                   \
+            array[j] = array[j - 1];                                        \
+        array[j] = el;                                                      \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void name##_sift_(T *array, size_t root, size_t asize)        \
+{                                                                           \
+    for (size_t child; (child = 2 * root + 1) < asize; root = child) {      \
+        if (child + 1 < asize && cmp(&array[child], &array[child + 1]) < 0) \
+            child++;                                                        \
+        if (cmp(&array[root], &array[child]) >= 0)                          \
+            return;                                                         \
+        name##_swap_(&array[root], &array[child]);                          \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void name##_heap_(T *array, size_t asize)                     \
+{                                                                           \
+    for (size_t i = asize / 2; i-- > 0;)                                    \
+        name##_sift_(array, i, asize);                                      \
+    for (size_t i = asize; i-- > 1;) {                                      \
+        name##_swap_(&array[0], &array[i]);                                 \
+        name##_sift_(array, 0, i);                                          \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void name##_intro_(T *array, size_t asize, unsigned depth)    \
+{                                                                           \
+    while (asize > SORT_INSERTION_THRESHOLD) {                              \
+        if (depth-- == 0) {                                                 \
+            name##_heap_(array, asize);                                     \
+            return;                                                         \
+        }                                                                   \
+        T *mid = &array[asize / 2], *last = &array[asize - 1];              \
+        if (cmp(mid, array) < 0)                                            \
+            name##_swap_(mid, array);                                       \
+        if (cmp(last, mid) < 0) {                                           \
+            name##_swap_(last, mid);                                        \
+            if (cmp(mid, array) < 0)                                        \
+                name##_swap_(mid, array);                                   \
+        }                                                                   \
+        name##_swap_(array, mid);                                           \
+        size_t i = 0, j = asize;                                            \
+        for (;;) {                                                          \
+            do i++; while (i < asize && cmp(&array[i], array) < 0);         \
+            do j--; while (cmp(&array[j], array) > 0);                      \
+            if (i >= j)                                                     \
+                break;                                                      \
+            name##_swap_(&array[i], &array[j]);                             \
+        }                                                                   \
+        name##_swap_(array, &array[j]);                                     \
+        if (j < asize - j - 1) {                                            \
+            name##_intro_(array, j, depth);                                 \
+            array += j + 1;                                                 \
+            asize -= j + 1;                                                 \
+        } else {                                                            \
+            name##_intro_(array + j + 1, asize - j - 1, depth);             \
+            asize = j;                                                      \
+        }                                                                   \
+    }                                                                       \
+    name##_insertion_(array, asize);                                        \
+}                                                                           \
+                                                                            \
+static inline void name(T *array, size_t asize)                             \
+{                                                                           \
+    if (array == NULL)                                                      \
+        return;                                                             \
+    name##_intro_(array, asize, sort_depth_limit_(asize));                  \
+}                                                                           \
+                                                                            \
+static inline int name##_stable(T *array, size_t asize)                     \
+{                                                                           \
+    if (array == NULL && asize > 0)                                         \
+        return -EINVAL;                                                     \
+    if (asize < 2)                                                          \
+        return 0;                                                           \
+    if (asize > SIZE_MAX / sizeof(T))                                       \
+        return -ENOMEM;                                                     \
+    T *buffer = (T *) malloc(asize * sizeof(T));                            \
+    if (buffer == NULL)                                                     \
+        return -ENOMEM;                                                     \
+    for (size_t i = 0; i < asize; i += SORT_INSERTION_THRESHOLD) {          \
+        size_t n = asize - i < SORT_INSERTION_THRESHOLD ?                   \
+                   asize - i : SORT_INSERTION_THRESHOLD;                    \
+        name##_insertion_(array + i, n);                                    \
+    }                                                                       \
+    T *src = array, *dst = buffer;                                          \
+    for (size_t width = SORT_INSERTION_THRESHOLD; width < asize;            \
+            width *= 2) {                                                   \
+        for (size_t left = 0; left < asize; left += 2 * width) {            \
+            size_t mid = asize - left < width ? asize : left + width;       \
+            size_t end = asize - mid < width ? asize : mid + width;         \
+            size_t l = left, r = mid, out = left;                           \
+            while (l < mid && r < end)                                      \
+                dst[out++] = cmp(&src[r], &src[l]) < 0 ? src[r++] :         \
+                                                         src[l++];          \
+            while (l < mid)                                                 \
+                dst[out++] = src[l++];                                      \
+            while (r < end)                                                 \
+                dst[out++] = src[r++];                                      \
+        }                                                                   \
+        T *swap = src;                                                      \
+        src = dst;                                                          \
+        dst = swap;                                                         \
+    }                                                                       \
+    if (src != array)                                                       \
+        memcpy(array, src, asize * sizeof(T));                              \
+    free(buffer);                                                           \
+    return 0;                                                               \
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SORT_H__
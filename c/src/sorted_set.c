@@ -0,0 +1,459 @@
+/**
+ * @file sorted_set.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+#include "binary_search.h"
+#include "sorted_set.h"
+
+// gallop through the longer array once it's this many times longer
+#define GALLOP_RATIO 32
+
+// the output is collected here and appended to the vector in batches
+#define SINK_BYTES 4096
+
+struct _sink {
+    struct vector *out;
+    size_t count;
+    size_t capacity;
+    bool indices;
+    int error;
+    union {
+        uint32_t u32[SINK_BYTES / sizeof(uint32_t)];
+        uint64_t u64[SINK_BYTES / sizeof(uint64_t)];
+        size_t idx[SINK_BYTES / sizeof(size_t)];
+    } buffer;
+};
+
+static enum vector_isa _isa = VECTOR_ISA_AUTO;
+
+static int _sink_init(struct _sink *sink, struct vector *out,
+                      enum sorted_set_output output, size_t esize)
+{
+    if (out == NULL || (output != SORTED_SET_VALUES &&
+                        output != SORTED_SET_INDICES))
+        return -EINVAL;
+
+    sink->indices = output == SORTED_SET_INDICES;
+    if (sink->indices)
+        esize = sizeof(size_t);
+    if (vector_element_size(out) != esize)
+        return -EINVAL;
+
+    sink->out = out;
+    sink->count = 0;
+    sink->capacity = SINK_BYTES / esize;
+    sink->error = 0;
+
+    return 0;
+}
+
+static void _flush(struct _sink *sink)
+{
+    if (sink->error == 0)
+        sink->error = vector_append(sink->out, &sink->buffer, sink->count);
+    sink->count = 0;
+}
+
+static int _sink_finish(struct _sink *sink)
+{
+    if (sink->count > 0)
+        _flush(sink);
+
+    return sink->error;
+}
+
+static inline bool _gallop(size_t asize, size_t bsize)
+{
+    size_t small = asize < bsize ? asize : bsize;
+    size_t large = asize < bsize ? bsize : asize;
+
+    return small <= large / GALLOP_RATIO;
+}
+
+// ----- scalar ----------------------------------------------------------------
+
+// The merge kernels start at positions i and j and take a mask of the
+// elements a[i], a[i + 1], ... the block kernels already found in b before
+// position j.
+
+#define SCALAR_SET_KERNELS(name, T) \
+    static inline int _compare_##name(const T *x1, const T *x2) \
+    { \
+        return (*x1 > *x2) - (*x1 < *x2); \
+    } \
+    BINARY_SEARCH_DEFINE(_search_##name, T, _compare_##name) \
+    static inline void _emit_##name(struct _sink *sink, T value, \
+                                    size_t index) \
+    { \
+        if (sink->count == sink->capacity) \
+            _flush(sink); \
+        if (sink->indices) \
+            sink->buffer.idx[sink->count++] = index; \
+        else \
+            sink->buffer.name[sink->count++] = value; \
+    } \
+    static inline void _emit_run_##name(struct _sink *sink, const T *a, \
+                                        size_t from, size_t to) \
+    { \
+        for (size_t k = from; k < to; k++) \
+            _emit_##name(sink, a[k], k); \
+    } \
+    /* position of the first element not less than key in array[from, n) */ \
+    static inline size_t _gallop_##name(const T *array, size_t from, \
+                                        size_t n, T key) \
+    { \
+        size_t left = from, probe = from, step = 1; \
+        while (probe < n && array[probe] < key) { \
+            left = probe + 1; \
+            probe = from + step; \
+            step *= 2; \
+        } \
+        size_t right = probe < n ? probe : n; \
+        return left + (size_t) _search_##name##_lower_bound(array + left, \
+                                                            right - left, \
+                                                            &key); \
+    } \
+    static void _intersect_merge_##name(const T *a, size_t na, const T *b, \
+                                        size_t nb, size_t i, size_t j, \
+                                        unsigned int matched, \
+                                        struct _sink *sink) \
+    { \
+        for (; matched != 0; matched &= matched - 1) { \
+            size_t k = i + __builtin_ctz(matched); \
+            _emit_##name(sink, a[k], k); \
+        } \
+        while (i < na && j < nb) { \
+            if (a[i] < b[j]) { \
+                i++; \
+            } else if (b[j] < a[i]) { \
+                j++; \
+            } else { \
+                _emit_##name(sink, a[i], i); \
+                i++; \
+                j++; \
+            } \
+        } \
+    } \
+    static void _difference_merge_##name(const T *a, size_t na, const T *b, \
+                                         size_t nb, size_t i, size_t j, \
+                                         unsigned int matched, \
+                                         struct _sink *sink) \
+    { \
+        for (size_t base = i; i < na; i++) { \
+            if (i - base < sizeof(matched) * CHAR_BIT && \
+                    (matched >> (i - base) & 1)) \
+                continue; \
+            while (j < nb && b[j] < a[i]) \
+                j++; \
+            if (j == nb || b[j] != a[i]) \
+                _emit_##name(sink, a[i], i); \
+        } \
+    } \
+    static void _union_merge_##name(const T *a, size_t na, const T *b, \
+                                    size_t nb, struct _sink *sink) \
+    { \
+        size_t i = 0, j = 0; \
+        while (i < na && j < nb) { \
+            if (a[i] < b[j]) { \
+                _emit_##name(sink, a[i++], 0); \
+            } else if (b[j] < a[i]) { \
+                _emit_##name(sink, b[j++], 0); \
+            } else { \
+                _emit_##name(sink, a[i++], 0); \
+                j++; \
+            } \
+        } \
+        _emit_run_##name(sink, a, i, na); \
+        _emit_run_##name(sink, b, j, nb); \
+    } \
+    static void _intersect_gallop_##name(const T *a, size_t na, const T *b, \
+                                         size_t nb, struct _sink *sink) \
+    { \
+        if (na <= nb) { \
+            for (size_t i = 0, j = 0; i < na; i++) { \
+                j = _gallop_##name(b, j, nb, a[i]); \
+                if (j == nb) \
+                    break; \
+                if (b[j] == a[i]) \
+                    _emit_##name(sink, a[i], i); \
+            } \
+        } else { \
+            for (size_t i = 0, j = 0; j < nb; j++) { \
+                i = _gallop_##name(a, i, na, b[j]); \
+                if (i == na) \
+                    break; \
+                if (a[i] == b[j]) \
+                    _emit_##name(sink, a[i], i); \
+            } \
+        } \
+    } \
+    static void _difference_gallop_##name(const T *a, size_t na, \
+                                          const T *b, size_t nb, \
+                                          struct _sink *sink) \
+    { \
+        if (na <= nb) { \
+            for (size_t i = 0, j = 0; i < na; i++) { \
+                j = _gallop_##name(b, j, nb, a[i]); \
+                if (j == nb || b[j] != a[i]) \
+                    _emit_##name(sink, a[i], i); \
+            } \
+        } else { \
+            size_t i = 0; \
+            for (size_t j = 0; j < nb && i < na; j++) { \
+                size_t k = _gallop_##name(a, i, na, b[j]); \
+                _emit_run_##name(sink, a, i, k); \
+                i = k < na && a[k] == b[j] ? k + 1 : k; \
+            } \
+            _emit_run_##name(sink, a, i, na); \
+        } \
+    } \
+    static void _union_gallop_##name(const T *a, size_t na, const T *b, \
+                                     size_t nb, struct _sink *sink) \
+    { \
+        const T *small = na <= nb ? a : b, *large = na <= nb ? b : a; \
+        size_t ns = na <= nb ? na : nb, nl = na <= nb ? nb : na; \
+        size_t j = 0; \
+        for (size_t i = 0; i < ns; i++) { \
+            size_t k = _gallop_##name(large, j, nl, small[i]); \
+            for (; j < k; j++) \
+                _emit_##name(sink, large[j], 0); \
+            if (j < nl && large[j] == small[i]) \
+                j++; \
+            _emit_##name(sink, small[i], 0); \
+        } \
+        for (; j < nl; j++) \
+            _emit_##name(sink, large[j], 0); \
+    }
+
+SCALAR_SET_KERNELS(u32, uint32_t)
+SCALAR_SET_KERNELS(u64, uint64_t)
+
+#ifdef HAVE_X86
+
+// ----- AVX2 ------------------------------------------------------------------
+
+// A block of a is compared with all the rotations of a block of b, which
+// gives the mask of the elements of a present anywhere in the block of b.
+// The block with the smaller last element is done and gets replaced by the
+// next one, the masks of a block of a are collected until it's done.
+
+#define LOAD_SI256(p) _mm256_loadu_si256((const __m256i *) (p))
+
+__attribute__((target("avx2")))
+static inline unsigned int _match_u32_avx2(const uint32_t *a,
+                                           const uint32_t *b)
+{
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256i va = LOAD_SI256(a), vb = LOAD_SI256(b);
+    __m256i eq = _mm256_cmpeq_epi32(va, vb);
+
+    for (int r = 1; r < 8; r++) {
+        vb = _mm256_permutevar8x32_epi32(vb, rotate);
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+    }
+
+    return (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned int _match_u64_avx2(const uint64_t *a,
+                                           const uint64_t *b)
+{
+    __m256i va = LOAD_SI256(a), vb = LOAD_SI256(b);
+    __m256i eq = _mm256_cmpeq_epi64(va, vb);
+
+    for (int r = 1; r < 4; r++) {
+        vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, vb));
+    }
+
+    return (unsigned int) _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+}
+
+#define AVX2_SET_KERNELS(name, T, lanes) \
+    __attribute__((target("avx2"))) \
+    static void _intersect_##name##_avx2(const T *a, size_t na, const T *b, \
+                                         size_t nb, struct _sink *sink) \
+    { \
+        size_t i = 0, j = 0; \
+        unsigned int matched = 0; \
+        while (i + lanes <= na && j + lanes <= nb) { \
+            matched |= _match_##name##_avx2(a + i, b + j); \
+            T amax = a[i + lanes - 1], bmax = b[j + lanes - 1]; \
+            if (amax <= bmax) { \
+                for (; matched != 0; matched &= matched - 1) { \
+                    size_t k = i + __builtin_ctz(matched); \
+                    _emit_##name(sink, a[k], k); \
+                } \
+                i += lanes; \
+            } \
+            if (bmax <= amax) \
+                j += lanes; \
+        } \
+        _intersect_merge_##name(a, na, b, nb, i, j, matched, sink); \
+    } \
+    __attribute__((target("avx2"))) \
+    static void _difference_##name##_avx2(const T *a, size_t na, \
+                                          const T *b, size_t nb, \
+                                          struct _sink *sink) \
+    { \
+        size_t i = 0, j = 0; \
+        unsigned int matched = 0; \
+        while (i + lanes <= na && j + lanes <= nb) { \
+            matched |= _match_##name##_avx2(a + i, b + j); \
+            T amax = a[i + lanes - 1], bmax = b[j + lanes - 1]; \
+            if (amax <= bmax) { \
+                unsigned int missing = ~matched & ((1u << lanes) - 1); \
+                for (; missing != 0; missing &= missing - 1) { \
+                    size_t k = i + __builtin_ctz(missing); \
+                    _emit_##name(sink, a[k], k); \
+                } \
+                matched = 0; \
+                i += lanes; \
+            } \
+            if (bmax <= amax) \
+                j += lanes; \
+        } \
+        _difference_merge_##name(a, na, b, nb, i, j, matched, sink); \
+    }
+
+AVX2_SET_KERNELS(u32, uint32_t, 8)
+AVX2_SET_KERNELS(u64, uint64_t, 4)
+
+#endif // HAVE_X86
+
+static bool _isa_supported(enum vector_isa isa)
+{
+    switch (isa) {
+    case VECTOR_ISA_AUTO:
+    case VECTOR_ISA_SCALAR:
+        return true;
+#ifdef HAVE_X86
+    case VECTOR_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case VECTOR_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif // HAVE_X86
+    default:
+        return false;
+    }
+}
+
+static bool _use_avx2(void)
+{
+    if (_isa == VECTOR_ISA_AUTO)
+        return _isa_supported(VECTOR_ISA_AVX2);
+
+    return _isa == VECTOR_ISA_AVX2;
+}
+
+int sorted_set_set_isa(enum vector_isa isa)
+{
+    if (!_isa_supported(isa))
+        return -ENOTSUP;
+
+    _isa = isa;
+
+    return 0;
+}
+
+#ifdef HAVE_X86
+#define BLOCK_KERNEL(op, name, a, na, b, nb, sink) \
+    do { \
+        if (_use_avx2()) { \
+            _##op##_##name##_avx2(a, na, b, nb, sink); \
+            break; \
+        } \
+        _##op##_merge_##name(a, na, b, nb, 0, 0, 0, sink); \
+    } while (0)
+#else
+#define BLOCK_KERNEL(op, name, a, na, b, nb, sink) \
+    _##op##_merge_##name(a, na, b, nb, 0, 0, 0, sink)
+#endif // HAVE_X86
+
+#define SET_OPERATIONS(name, T) \
+    int sorted_set_intersect_##name(const T *a, size_t asize, const T *b, \
+                                    size_t bsize, struct vector *out, \
+                                    enum sorted_set_output output) \
+    { \
+        struct _sink sink; \
+        if ((a == NULL && asize > 0) || (b == NULL && bsize > 0)) \
+            return -EINVAL; \
+        int ret = _sink_init(&sink, out, output, sizeof(T)); \
+        if (ret < 0) \
+            return ret; \
+        if (_gallop(asize, bsize)) \
+            _intersect_gallop_##name(a, asize, b, bsize, &sink); \
+        else \
+            BLOCK_KERNEL(intersect, name, a, asize, b, bsize, &sink); \
+        return _sink_finish(&sink); \
+    } \
+    int sorted_set_difference_##name(const T *a, size_t asize, const T *b, \
+                                     size_t bsize, struct vector *out, \
+                                     enum sorted_set_output output) \
+    { \
+        struct _sink sink; \
+        if ((a == NULL && asize > 0) || (b == NULL && bsize > 0)) \
+            return -EINVAL; \
+        int ret = _sink_init(&sink, out, output, sizeof(T)); \
+        if (ret < 0) \
+            return ret; \
+        if (_gallop(asize, bsize)) \
+            _difference_gallop_##name(a, asize, b, bsize, &sink); \
+        else \
+            BLOCK_KERNEL(difference, name, a, asize, b, bsize, &sink); \
+        return _sink_finish(&sink); \
+    } \
+    int sorted_set_union_##name(const T *a, size_t asize, const T *b, \
+                                size_t bsize, struct vector *out) \
+    { \
+        struct _sink sink; \
+        if ((a == NULL && asize > 0) || (b == NULL && bsize > 0)) \
+            return -EINVAL; \
+        int ret = _sink_init(&sink, out, SORTED_SET_VALUES, sizeof(T)); \
+        if (ret < 0) \
+            return ret; \
+        if (_gallop(asize, bsize)) \
+            _union_gallop_##name(a, asize, b, bsize, &sink); \
+        else \
+            _union_merge_##name(a, asize, b, bsize, &sink); \
+        return _sink_finish(&sink); \
+    }
+
+SET_OPERATIONS(u32, uint32_t)
+SET_OPERATIONS(u64, uint64_t)
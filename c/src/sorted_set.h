@@ -0,0 +1,105 @@
+/**
+ * @file sorted_set.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SORTED_SET_H__
+#define __SORTED_SET_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vector.h"
+#include "vector_scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** What the set operations append to the output vector. */
+enum sorted_set_output {
+    SORTED_SET_VALUES,  //!< the elements, the vector holds the element type
+    SORTED_SET_INDICES, //!< positions in the first array, the vector holds
+                        //!< size_t
+};
+
+/** Forces the set operations to use a given instruction set.
+ *
+ * By default the kernels are chosen at runtime based on the features of the
+ * CPU. There are scalar and AVX2 kernels only, SSE2 selects the scalar ones.
+ * This function is meant for testing and benchmarking, it's not thread-safe.
+ *
+ * @param[in] isa the instruction set to use
+ *
+ * @return 0 upon success and negative error code if the CPU doesn't support
+ *         the instruction set
+ */
+int sorted_set_set_isa(enum vector_isa isa);
+
+// The arrays are sets: sorted in ascending order and without duplicates. The
+// result is appended to the output vector in ascending order.
+//
+// When one array is much shorter than the other one, each of its elements is
+// looked up in the longer one by galloping from the previous match. Arrays
+// of similar sizes are merged instead, the intersection and the difference
+// comparing whole blocks of both arrays at once with AVX2.
+//
+// All the functions return 0 upon success, -EINVAL on invalid arguments
+// (including an output vector of wrong element size) and -ENOMEM when the
+// output vector cannot grow.
+
+/** Elements present in both a and b. */
+int sorted_set_intersect_u32(const uint32_t *a, size_t asize,
+                             const uint32_t *b, size_t bsize,
+                             struct vector *out,
+                             enum sorted_set_output output);
+int sorted_set_intersect_u64(const uint64_t *a, size_t asize,
+                             const uint64_t *b, size_t bsize,
+                             struct vector *out,
+                             enum sorted_set_output output);
+
+/** Elements of a not present in b. */
+int sorted_set_difference_u32(const uint32_t *a, size_t asize,
+                              const uint32_t *b, size_t bsize,
+                              struct vector *out,
+                              enum sorted_set_output output);
+int sorted_set_difference_u64(const uint64_t *a, size_t asize,
+                              const uint64_t *b, size_t bsize,
+                              struct vector *out,
+                              enum sorted_set_output output);
+
+/** Elements present in a or b, the output holds values only. */
+int sorted_set_union_u32(const uint32_t *a, size_t asize,
+                         const uint32_t *b, size_t bsize,
+                         struct vector *out);
+int sorted_set_union_u64(const uint64_t *a, size_t asize,
+                         const uint64_t *b, size_t bsize,
+                         struct vector *out);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SORTED_SET_H__
@@ -0,0 +1,352 @@
+/**
+ * @file stree.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+#include "stree.h"
+
+#define CACHE_LINE_SIZE 64
+#define B STREE_NODE_KEYS
+
+// counts the keys of a node which are smaller (lt) or not greater (le) than
+// a given key
+typedef size_t (*rank_fn_t)(const int32_t *node, int32_t key);
+
+struct stree {
+    int32_t *nodes;         //!< all the layers, the root first
+    size_t *layers;         //!< offset of every layer, the leaves last
+    size_t height;          //!< number of layers
+    size_t el_count;
+    rank_fn_t rank_lt;
+    rank_fn_t rank_le;
+};
+
+// ----- scalar ----------------------------------------------------------------
+
+static size_t _rank_lt_scalar(const int32_t *node, int32_t key)
+{
+    size_t rank = 0;
+    for (size_t i = 0; i < B; ++i)
+        rank += node[i] < key;
+    return rank;
+}
+
+static size_t _rank_le_scalar(const int32_t *node, int32_t key)
+{
+    size_t rank = 0;
+    for (size_t i = 0; i < B; ++i)
+        rank += node[i] <= key;
+    return rank;
+}
+
+#ifdef HAVE_X86
+
+// ----- sse2 ------------------------------------------------------------------
+
+__attribute__((target("sse2")))
+static size_t _rank_lt_sse2(const int32_t *node, int32_t key)
+{
+    __m128i k = _mm_set1_epi32(key);
+    unsigned int mask = 0;
+
+    for (size_t i = 0; i < B / 4; ++i) {
+        __m128i keys = _mm_load_si128((const __m128i *) node + i);
+        __m128i lt = _mm_cmpgt_epi32(k, keys);
+        mask |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(lt)) << (i * 4);
+    }
+
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2")))
+static size_t _rank_le_sse2(const int32_t *node, int32_t key)
+{
+    __m128i k = _mm_set1_epi32(key);
+    unsigned int mask = 0;
+
+    for (size_t i = 0; i < B / 4; ++i) {
+        __m128i keys = _mm_load_si128((const __m128i *) node + i);
+        __m128i gt = _mm_cmpgt_epi32(keys, k);
+        mask |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(gt)) << (i * 4);
+    }
+
+    return B - __builtin_popcount(mask);
+}
+
+// ----- avx2 ------------------------------------------------------------------
+
+__attribute__((target("avx2,popcnt")))
+static size_t _rank_lt_avx2(const int32_t *node, int32_t key)
+{
+    __m256i k = _mm256_set1_epi32(key);
+    __m256i lo = _mm256_load_si256((const __m256i *) node);
+    __m256i hi = _mm256_load_si256((const __m256i *) node + 1);
+
+    unsigned int mask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, lo))) |
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, hi))) << 8;
+
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t _rank_le_avx2(const int32_t *node, int32_t key)
+{
+    __m256i k = _mm256_set1_epi32(key);
+    __m256i lo = _mm256_load_si256((const __m256i *) node);
+    __m256i hi = _mm256_load_si256((const __m256i *) node + 1);
+
+    unsigned int mask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(lo, k))) |
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(hi, k))) << 8;
+
+    return B - __builtin_popcount(mask);
+}
+
+#endif // HAVE_X86
+
+static bool _isa_supported(enum vector_isa isa)
+{
+    switch (isa) {
+    case VECTOR_ISA_AUTO:
+    case VECTOR_ISA_SCALAR:
+        return true;
+#ifdef HAVE_X86
+    case VECTOR_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case VECTOR_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("popcnt");
+#endif // HAVE_X86
+    default:
+        return false;
+    }
+}
+
+int stree_set_isa(struct stree *tree, enum vector_isa isa)
+{
+    if (tree == NULL)
+        return -EINVAL;
+    if (!_isa_supported(isa))
+        return -ENOTSUP;
+
+    if (isa == VECTOR_ISA_AUTO) {
+        isa = _isa_supported(VECTOR_ISA_AVX2) ? VECTOR_ISA_AVX2 :
+              _isa_supported(VECTOR_ISA_SSE2) ? VECTOR_ISA_SSE2 :
+              VECTOR_ISA_SCALAR;
+    }
+
+    switch (isa) {
+#ifdef HAVE_X86
+    case VECTOR_ISA_AVX2:
+        tree->rank_lt = _rank_lt_avx2;
+        tree->rank_le = _rank_le_avx2;
+        break;
+    case VECTOR_ISA_SSE2:
+        tree->rank_lt = _rank_lt_sse2;
+        tree->rank_le = _rank_le_sse2;
+        break;
+#endif // HAVE_X86
+    default:
+        tree->rank_lt = _rank_lt_scalar;
+        tree->rank_le = _rank_le_scalar;
+        break;
+    }
+
+    return 0;
+}
+
+static inline int32_t *_node(struct stree *tree, size_t layer, size_t idx)
+{
+    return tree->nodes + (tree->layers[layer] + idx) * B;
+}
+
+// The separator key j of an inner node is the first key of its child j + 1.
+// The first key of a subtree is the first key of its leftmost leaf, the
+// leftmost leaf of node i which is h layers above the leaves is i * (B + 1)^h.
+// Separators of children past the end of the layer below are INT32_MAX, as is
+// the padding of the last leaf, so that no key is ever less than them.
+static void _fill(struct stree *tree, const int32_t *keys)
+{
+    size_t leaves = tree->height - 1;
+    size_t span = 1;
+
+    int32_t *leaf = _node(tree, leaves, 0);
+    size_t leaf_count = tree->layers[leaves + 1] - tree->layers[leaves];
+    memcpy(leaf, keys, tree->el_count * sizeof(*keys));
+    for (size_t i = tree->el_count; i < leaf_count * B; ++i)
+        leaf[i] = INT32_MAX;
+
+    for (size_t layer = leaves; layer-- > 0; span *= B + 1) {
+        size_t count = tree->layers[layer + 1] - tree->layers[layer];
+
+        for (size_t i = 0; i < count; ++i) {
+            int32_t *node = _node(tree, layer, i);
+
+            for (size_t j = 0; j < B; ++j) {
+                size_t first = (i * (B + 1) + j + 1) * span * B;
+                node[j] = first < tree->el_count ? keys[first] : INT32_MAX;
+            }
+        }
+    }
+}
+
+struct stree *stree_create(const int32_t *keys, size_t count)
+{
+    if (keys == NULL || count == 0 || count > SSIZE_MAX)
+        goto return_einval_;
+
+    struct stree *tree = malloc(sizeof(*tree));
+    if (tree == NULL)
+        goto return_enomem_;
+
+    // count the layers and the nodes in them, the leaves first
+    size_t nodes = (count + B - 1) / B;
+    size_t total = nodes;
+    tree->height = 1;
+    while (nodes > 1) {
+        nodes = (nodes + B) / (B + 1);
+        total += nodes;
+        tree->height += 1;
+    }
+
+    if (total > SIZE_MAX / CACHE_LINE_SIZE)
+        goto free_tree_;
+
+    tree->layers = malloc((tree->height + 1) * sizeof(size_t));
+    if (tree->layers == NULL)
+        goto free_tree_;
+
+    tree->nodes = aligned_alloc(CACHE_LINE_SIZE, total * CACHE_LINE_SIZE);
+    if (tree->nodes == NULL)
+        goto free_layers_;
+
+    // now lay the layers out from the root down
+    tree->layers[tree->height] = total;
+    nodes = (count + B - 1) / B;
+    for (size_t layer = tree->height; layer-- > 0;) {
+        tree->layers[layer] = tree->layers[layer + 1] - nodes;
+        nodes = (nodes + B) / (B + 1);
+    }
+
+    tree->el_count = count;
+    _fill(tree, keys);
+    stree_set_isa(tree, VECTOR_ISA_AUTO);
+
+    return tree;
+
+free_layers_:
+    free(tree->layers);
+free_tree_:
+    free(tree);
+return_enomem_:
+    errno = ENOMEM;
+    return NULL;
+return_einval_:
+    errno = EINVAL;
+    return NULL;
+}
+
+void stree_destroy(struct stree *tree)
+{
+    if (tree == NULL)
+        return;
+
+    free(tree->nodes);
+    free(tree->layers);
+    free(tree);
+}
+
+size_t stree_size(struct stree *tree)
+{
+    return tree->el_count;
+}
+
+// Descends into child i of a node where i is the rank of the key among the
+// separators. When all the keys of the leaf reached are smaller the bound is
+// the first key of the next leaf which is exactly where the rank points to.
+static size_t _bound(struct stree *tree, int32_t key, rank_fn_t rank)
+{
+    size_t idx = 0;
+
+    for (size_t layer = 0; layer + 1 < tree->height; ++layer)
+        idx = idx * (B + 1) + rank(_node(tree, layer, idx), key);
+
+    idx = idx * B + rank(_node(tree, tree->height - 1, idx), key);
+
+    return idx < tree->el_count ? idx : tree->el_count;
+}
+
+static inline int32_t _key(struct stree *tree, size_t idx)
+{
+    return tree->nodes[tree->layers[tree->height - 1] * B + idx];
+}
+
+size_t stree_lower_bound(struct stree *tree, int32_t key)
+{
+    if (tree == NULL)
+        return 0;
+
+    return _bound(tree, key, tree->rank_lt);
+}
+
+ssize_t stree_search_leftmost(struct stree *tree, int32_t key)
+{
+    if (tree == NULL)
+        return -1;
+
+    size_t left = _bound(tree, key, tree->rank_lt);
+    if (left < tree->el_count && _key(tree, left) == key)
+        return left;
+    return -1;
+}
+
+ssize_t stree_search_rightmost(struct stree *tree, int32_t key)
+{
+    if (tree == NULL)
+        return -1;
+
+    // the padding is not greater than INT32_MAX either, it would lead the
+    // search past the last child
+    size_t right = key == INT32_MAX ? tree->el_count :
+                   _bound(tree, key, tree->rank_le);
+    if (right > 0 && _key(tree, right - 1) == key)
+        return right - 1;
+    return -1;
+}
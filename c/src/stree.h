@@ -0,0 +1,126 @@
+/**
+ * @file stree.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __STREE_H__
+#define __STREE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "vector_scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Number of keys in a node of the tree, 16 keys fill a cache line. */
+#define STREE_NODE_KEYS 16
+
+struct stree;
+
+/** Builds a static B+-tree over a sorted array of keys.
+ *
+ * The leaves hold all the keys in order, 16 to a cache line sized node. Each
+ * inner node holds 16 separator keys and has 17 children, so a lookup
+ * touches one cache line per level of the tree, i.e. about log17(n) of them
+ * instead of the log2(n) of the binary search. Every node is compared with
+ * the key at once using SIMD instructions.
+ *
+ * The tree is a copy, the source array may be freed.
+ *
+ * @param[in] keys the keys sorted in ascending order
+ * @param[in] count number of keys
+ *
+ * @return pointer to the tree or NULL on error, @c errno is set to indicate
+ *         the error
+ */
+struct stree *stree_create(const int32_t *keys, size_t count);
+
+/** Destroys the tree.
+ *
+ * @param[in] tree pointer to the tree
+ */
+void stree_destroy(struct stree *tree);
+
+/** Returns number of keys in the tree.
+ *
+ * @param[in] tree pointer to the tree
+ *
+ * @return number of keys
+ */
+size_t stree_size(struct stree *tree);
+
+/** Forces the node comparisons to use a given instruction set.
+ *
+ * By default the best instruction set supported by the CPU is used. This
+ * function is meant for testing and benchmarking.
+ *
+ * @param[in] tree pointer to the tree
+ * @param[in] isa the instruction set to use
+ *
+ * @return 0 upon success and negative error code if the CPU doesn't support
+ *         the instruction set
+ */
+int stree_set_isa(struct stree *tree, enum vector_isa isa);
+
+/** Returns the number of keys smaller than @c key.
+ *
+ * This is the position at which @c key would be inserted in front of all
+ * the equal keys.
+ *
+ * @param[in] tree pointer to the tree
+ * @param[in] key the key to look for
+ *
+ * @return position of the first key not less than @c key, 0 if @c tree is
+ *         NULL
+ */
+size_t stree_lower_bound(struct stree *tree, int32_t key);
+
+/** Same as binary_search_leftmost_i32() on the source array.
+ *
+ * @param[in] tree pointer to the tree
+ * @param[in] key the key to look for
+ *
+ * @return position of the first equal key or -1 if there is none
+ */
+ssize_t stree_search_leftmost(struct stree *tree, int32_t key);
+
+/** Same as binary_search_rightmost_i32() on the source array.
+ *
+ * @param[in] tree pointer to the tree
+ * @param[in] key the key to look for
+ *
+ * @return position of the last equal key or -1 if there is none
+ */
+ssize_t stree_search_rightmost(struct stree *tree, int32_t key);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __STREE_H__
@@ -25,31 +25,72 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <stdio.h>
+#define _POSIX_C_SOURCE 200809L
+
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+#include "sort.h"
 #include "vector.h"
 
-#ifndef NDEBUG
-#define debug(fmt, ...) printf(fmt "\n", ##__VA_ARGS__)
+#ifdef VECTOR_STATS
+#include <stdatomic.h>
+
+#define stat_add(vec, field, n)                                             \
+    do {                                                                    \
+        (vec)->stats.field += (n);                                          \
+        atomic_fetch_add_explicit(&_global_stats.field, (n),                \
+                                  memory_order_relaxed);                    \
+    } while (0)
+#define stat_capacity(vec) _stat_capacity(vec)
 #else
-#define debug(fmt, ...)
+#define stat_add(vec, field, n) do { } while (0)
+#define stat_capacity(vec) do { } while (0)
 #endif
 
+#define VECTOR_FILE_MAGIC "VECTOR\0\0"
+#define VECTOR_FILE_VERSION 1
+#define VECTOR_FILE_BYTE_ORDER 0x01020304
+#define VECTOR_FILE_ALIGNMENT 4096
+
 struct vector {
     void *array;
     size_t min_capacity;
     size_t capacity;
     size_t el_count;
     size_t el_size;
+
+    void *map;          //!< file mapping backing the array, NULL if on heap
+    size_t map_size;
+    bool readonly;
+
+    struct vector_policy policy;
+    size_t shrink_retry_below;  //!< set after a failed shrink, SIZE_MAX if none
+
+#ifdef VECTOR_STATS
+    struct vector_stats stats;
+#endif
+};
+
+struct vector_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t el_size;
+    uint64_t count;
+    uint64_t alignment;
 };
 
 static inline uintmax_t _ceil_pow2(uintmax_t x)
 {
-    return 1 << (sizeof(x) * __CHAR_BIT__ - __builtin_clzimax(x - 1));
+    return (uintmax_t) 1 << (sizeof(x) * __CHAR_BIT__ -
+                             __builtin_clzimax(x - 1));
 }
 
 static inline size_t _init_capacity(size_t size)
@@ -58,22 +99,137 @@ static inline size_t _init_capacity(size_t size)
     return size < min_capacity ? min_capacity : _ceil_pow2(size);
 }
 
+#ifdef VECTOR_STATS
+static struct {
+    atomic_uint_fast64_t grows;
+    atomic_uint_fast64_t shrinks;
+    atomic_uint_fast64_t bytes_reallocated;
+    atomic_uint_fast64_t bytes_moved;
+    atomic_size_t peak_capacity;
+} _global_stats;
+
+static void _stat_capacity(struct vector *vec)
+{
+    if (vec->capacity > vec->stats.peak_capacity)
+        vec->stats.peak_capacity = vec->capacity;
+
+    size_t peak = atomic_load_explicit(&_global_stats.peak_capacity,
+                                       memory_order_relaxed);
+    while (vec->capacity > peak &&
+            !atomic_compare_exchange_weak_explicit(
+                &_global_stats.peak_capacity, &peak, vec->capacity,
+                memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+#endif
+
+static inline size_t _data_offset(size_t alignment)
+{
+    size_t header = sizeof(struct vector_file_header);
+    return (header + alignment - 1) / alignment * alignment;
+}
+
+// moves a mapped array to the heap, realloc() can't be used for it
+static void *_unmap(struct vector *vec, size_t new_capacity)
+{
+    void *array = malloc(new_capacity * vec->el_size);
+    if (array == NULL)
+        return NULL;
+
+    size_t count = vec->el_count < new_capacity ? vec->el_count : new_capacity;
+    memcpy(array, vec->array, count * vec->el_size);
+
+    munmap(vec->map, vec->map_size);
+    vec->map = NULL;
+    vec->map_size = 0;
+
+    return array;
+}
+
 static bool _resize(struct vector *vec, size_t new_capacity)
 {
-    void *array = realloc(vec->array, new_capacity * vec->el_size);
+    void *array;
+
+    if (vec->map != NULL)
+        array = _unmap(vec, new_capacity);
+    else
+        array = realloc(vec->array, new_capacity * vec->el_size);
+
     if (array == NULL) {
         errno = ENOMEM;
         return false;
     }
 
-    debug("(%s) old: %zu, new: %zu", __func__, vec->capacity, new_capacity);
+    if (new_capacity > vec->capacity)
+        stat_add(vec, grows, 1);
+    else
+        stat_add(vec, shrinks, 1);
+    stat_add(vec, bytes_reallocated, new_capacity * vec->el_size);
 
     vec->capacity = new_capacity;
     vec->array = array;
+    vec->shrink_retry_below = SIZE_MAX;
+
+    stat_capacity(vec);
 
     return true;
 }
 
+// returns capacity * num / den without overflowing the intermediate product
+static inline size_t _scale(size_t capacity, size_t num, size_t den)
+{
+    size_t scaled = capacity / den * num + capacity % den * num / den;
+    return capacity / den > SIZE_MAX / num ? SIZE_MAX : scaled;
+}
+
+static inline size_t _grow_capacity(struct vector *vec, size_t capacity)
+{
+    const struct vector_policy *policy = &vec->policy;
+
+    // mapped vectors start with the capacity equal to the number of elements
+    // which may be well below the minimum
+    size_t grown = _scale(capacity, policy->growth_num, policy->growth_den);
+    if (grown <= capacity)
+        grown = capacity + 1;
+    return grown < vec->min_capacity ? vec->min_capacity : grown;
+}
+
+static inline bool _should_shrink(struct vector *vec)
+{
+    const struct vector_policy *policy = &vec->policy;
+
+    return !policy->never_shrink &&
+        vec->capacity > vec->min_capacity &&
+        vec->el_count < vec->shrink_retry_below &&
+        vec->el_count < _scale(vec->capacity, policy->shrink_threshold_num,
+                               policy->shrink_threshold_den);
+}
+
+static void _shrink(struct vector *vec)
+{
+    const struct vector_policy *policy = &vec->policy;
+
+    while (_should_shrink(vec)) {
+        size_t new_capacity = _scale(vec->capacity, policy->shrink_num,
+                                     policy->shrink_den);
+        if (new_capacity < vec->min_capacity)
+            new_capacity = vec->min_capacity;
+
+        // if the resize fails we can still continue to exist with the bigger
+        // size; back off until the vector halves again so that every
+        // subsequent remove doesn't pay for another failing realloc()
+        if (!_resize(vec, new_capacity)) {
+            vec->shrink_retry_below = vec->el_count / 2;
+            break;
+        }
+    }
+}
+
+static inline void *_element(struct vector *vec, size_t idx)
+{
+    return (char *) vec->array + (idx * vec->el_size);
+}
+
 struct vector *vector_create(size_t capacity, size_t el_size)
 {
     if (el_size == 0)
@@ -89,13 +245,22 @@ struct vector *vector_create(size_t capacity, size_t el_size)
     if (vec->array == NULL)
         goto free_list_;
 
+    vec->map = NULL;
+    vec->map_size = 0;
+    vec->readonly = false;
+
+    vec->policy = VECTOR_POLICY_DEFAULT;
+    vec->shrink_retry_below = SIZE_MAX;
+
     vec->min_capacity = new_capacity;
     vec->capacity = new_capacity;
     vec->el_count = capacity;
     vec->el_size = el_size;
 
-    debug("vector create; capacity: %zu, element count: %zu, element size: %zu",
-          vec->capacity, vec->el_count, vec->el_size);
+#ifdef VECTOR_STATS
+    memset(&vec->stats, 0, sizeof(vec->stats));
+#endif
+    stat_capacity(vec);
 
     return vec;
 
@@ -110,7 +275,10 @@ void vector_destroy(struct vector *vector)
     if (vector == NULL)
         return;
 
-    free(vector->array);
+    if (vector->map != NULL)
+        munmap(vector->map, vector->map_size);
+    else
+        free(vector->array);
     free(vector);
 }
 
@@ -124,16 +292,85 @@ size_t vector_capacity(struct vector *vector)
     return vector->capacity;
 }
 
+size_t vector_element_size(struct vector *vector)
+{
+    return vector->el_size;
+}
+
+bool vector_is_readonly(struct vector *vector)
+{
+    return vector != NULL && vector->readonly;
+}
+
+int vector_set_policy(struct vector *vec, const struct vector_policy *policy)
+{
+    if (vec == NULL || policy == NULL)
+        return -EINVAL;
+
+    // the growth must make room for at least one more element and, unless
+    // disabled, a shrink must leave room for the elements still stored;
+    // zero fractions would never shrink and make the capacity scaling divide
+    // by zero
+    if (policy->growth_den == 0 || policy->growth_num <= policy->growth_den)
+        return -EINVAL;
+    if (!policy->never_shrink) {
+        if (policy->shrink_num == 0 || policy->shrink_threshold_num == 0 ||
+                policy->shrink_den == 0 || policy->shrink_threshold_den == 0 ||
+                policy->shrink_num >= policy->shrink_den ||
+                policy->shrink_threshold_num >= policy->shrink_threshold_den)
+            return -EINVAL;
+        if ((uintmax_t) policy->shrink_num * policy->shrink_threshold_den <
+                (uintmax_t) policy->shrink_threshold_num * policy->shrink_den)
+            return -EINVAL;
+    }
+
+    vec->policy = *policy;
+
+    return 0;
+}
+
+int vector_reserve(struct vector *vec, size_t capacity)
+{
+    if (vec == NULL)
+        return -EINVAL;
+    if (vec->readonly)
+        return -EROFS;
+    if (capacity <= vec->capacity)
+        return 0;
+    if (capacity > SIZE_MAX / vec->el_size)
+        return -ENOMEM;
+
+    return _resize(vec, capacity) ? 0 : -ENOMEM;
+}
+
+int vector_shrink_to_fit(struct vector *vec)
+{
+    if (vec == NULL)
+        return -EINVAL;
+    if (vec->readonly)
+        return -EROFS;
+
+    // realloc() of zero bytes may free the array, keep at least one element
+    size_t new_capacity = vec->el_count > 0 ? vec->el_count : 1;
+    if (new_capacity >= vec->capacity)
+        return 0;
+
+    return _resize(vec, new_capacity) ? 0 : -ENOMEM;
+}
+
 int vector_insert(struct vector *vec, size_t idx, void *el)
 {
     if (vec == NULL || idx > vec->el_count) {
         return -EINVAL;
     }
+    if (vec->readonly) {
+        return -EROFS;
+    }
 
     // check and if needed resize
 
     if (vec->el_count == vec->capacity) {
-        if (!_resize(vec, (size_t) (vec->capacity * 3 / 2))) {
+        if (!_resize(vec, _grow_capacity(vec, vec->capacity))) {
             return -ENOMEM;
         }
     }
@@ -145,9 +382,9 @@ int vector_insert(struct vector *vec, size_t idx, void *el)
             (vec->el_count - idx) * vec->el_size);
     memcpy((char *) vec->array + (idx * vec->el_size), el, vec->el_size);
 
-    vec->el_count += 1;
+    stat_add(vec, bytes_moved, (vec->el_count - idx) * vec->el_size);
 
-    debug("(%s) index: %zu, element count: %zu", __func__, idx, vec->el_count);
+    vec->el_count += 1;
 
     return 0;
 }
@@ -157,22 +394,19 @@ int vector_remove(struct vector *vec, size_t idx)
     if (vec == NULL || idx >= vec->el_count) {
         return -EINVAL;
     }
+    if (vec->readonly) {
+        return -EROFS;
+    }
 
     memmove((char *) vec->array + (idx * vec->el_size),
             (char *) vec->array + ((idx + 1) * vec->el_size),
             (vec->el_count - idx - 1) * vec->el_size);
 
-    vec->el_count -= 1;
+    stat_add(vec, bytes_moved, (vec->el_count - idx - 1) * vec->el_size);
 
-    if (vec->el_count < vec->capacity / 2 &&
-            vec->capacity > vec->min_capacity) {
-        // ignore the error because if the resize fails we can still continue
-        // to exist with the bigger size (though we're going to retry with
-        // every remove now).
-        (void) _resize(vec, (size_t) (vec->capacity * 2 / 3));
-    }
+    vec->el_count -= 1;
 
-    debug("(%s) index: %zu, element count: %zu", __func__, idx, vec->el_count);
+    _shrink(vec);
 
     return 0;
 }
@@ -183,6 +417,10 @@ void vector_set(struct vector *vec, size_t idx, void *el)
         errno = EINVAL;
         return;
     }
+    if (vec->readonly) {
+        errno = EROFS;
+        return;
+    }
 
     memcpy((char *) vec->array + (idx * vec->el_size), el, vec->el_size);
 }
@@ -196,3 +434,349 @@ void *vector_get(struct vector *vector, size_t index)
 
     return (char *) vector->array + (index * vector->el_size);
 }
+
+void *vector_data(struct vector *vector)
+{
+    if (vector == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return vector->array;
+}
+
+ssize_t vector_insert_sorted(struct vector *vec, compare_fn_t compare,
+                             void *el)
+{
+    if (vec == NULL || compare == NULL || el == NULL)
+        return -EINVAL;
+
+    size_t idx = binary_search_upper_bound(vec->array, vec->el_count,
+                                           vec->el_size, compare, el);
+
+    int ret = vector_insert(vec, idx, el);
+    if (ret < 0)
+        return ret;
+
+    return idx;
+}
+
+ssize_t vector_find(struct vector *vec, compare_fn_t compare, void *key)
+{
+    if (vec == NULL)
+        return -1;
+
+    return binary_search_leftmost(vec->array, vec->el_count, vec->el_size,
+                                  compare, key);
+}
+
+ssize_t vector_erase_key(struct vector *vec, compare_fn_t compare, void *key)
+{
+    if (vec == NULL || compare == NULL || key == NULL)
+        return -EINVAL;
+    if (vec->readonly)
+        return -EROFS;
+
+    size_t first, last;
+    binary_search_equal_range(vec->array, vec->el_count, vec->el_size,
+                              compare, key, &first, &last);
+
+    size_t count = last - first;
+    if (count == 0)
+        return 0;
+
+    memmove(_element(vec, first), _element(vec, last),
+            (vec->el_count - last) * vec->el_size);
+
+    stat_add(vec, bytes_moved, (vec->el_count - last) * vec->el_size);
+
+    vec->el_count -= count;
+
+    _shrink(vec);
+
+    return count;
+}
+
+// makes room for count more elements with a single resize
+static bool _grow_for(struct vector *vec, size_t count)
+{
+    if (count > SIZE_MAX / vec->el_size - vec->el_count)
+        return false;
+
+    size_t needed = vec->el_count + count;
+
+    if (needed > vec->capacity) {
+        size_t new_capacity = vec->capacity;
+        while (new_capacity < needed)
+            new_capacity = _grow_capacity(vec, new_capacity);
+        if (new_capacity > SIZE_MAX / vec->el_size)
+            new_capacity = needed;
+
+        if (!_resize(vec, new_capacity))
+            return false;
+    }
+
+    return true;
+}
+
+int vector_append(struct vector *vec, const void *els, size_t count)
+{
+    if (vec == NULL || (els == NULL && count > 0))
+        return -EINVAL;
+
+    if (vec->readonly)
+        return -EROFS;
+    if (count == 0)
+        return 0;
+
+    if (!_grow_for(vec, count))
+        return -ENOMEM;
+
+    memcpy(_element(vec, vec->el_count), els, count * vec->el_size);
+    vec->el_count += count;
+
+    return 0;
+}
+
+int vector_merge_sorted_bulk(struct vector *vec, compare_fn_t compare,
+                             const void *els, size_t count)
+{
+    if (vec == NULL || compare == NULL || (els == NULL && count > 0))
+        return -EINVAL;
+
+    if (vec->readonly)
+        return -EROFS;
+    if (count == 0)
+        return 0;
+
+    size_t needed = vec->el_count + count;
+    if (!_grow_for(vec, count))
+        return -ENOMEM;
+
+    // merge from the back so that every element is moved exactly once and
+    // no temporary storage is needed; on equal keys the new element goes
+    // last, the same as with vector_insert_sorted()
+
+    const char *src = els;
+    size_t old = vec->el_count, new = count, dst = needed;
+
+    while (new > 0) {
+        const void *el = src + ((new - 1) * vec->el_size);
+
+        if (old > 0 && compare(el, _element(vec, old - 1)) < 0) {
+            memcpy(_element(vec, --dst), _element(vec, --old), vec->el_size);
+            stat_add(vec, bytes_moved, vec->el_size);
+        } else {
+            memcpy(_element(vec, --dst), el, vec->el_size);
+            new -= 1;
+        }
+    }
+
+    vec->el_count = needed;
+
+    return 0;
+}
+
+int vector_sort(struct vector *vec, compare_fn_t compare)
+{
+    if (vec == NULL || compare == NULL)
+        return -EINVAL;
+    if (vec->readonly)
+        return -EROFS;
+
+    return sort(vec->array, vec->el_count, vec->el_size, compare);
+}
+
+int vector_sort_stable(struct vector *vec, compare_fn_t compare)
+{
+    if (vec == NULL || compare == NULL)
+        return -EINVAL;
+    if (vec->readonly)
+        return -EROFS;
+
+    return sort_stable(vec->array, vec->el_count, vec->el_size, compare);
+}
+
+static int _write_all(int fd, const void *buf, size_t size)
+{
+    const char *p = buf;
+
+    while (size > 0) {
+        ssize_t ret = write(fd, p, size);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        p += ret;
+        size -= ret;
+    }
+
+    return 0;
+}
+
+int vector_save(struct vector *vec, const char *path)
+{
+    if (vec == NULL || path == NULL)
+        return -EINVAL;
+
+    struct vector_file_header header = {
+        .magic = VECTOR_FILE_MAGIC,
+        .version = VECTOR_FILE_VERSION,
+        .byte_order = VECTOR_FILE_BYTE_ORDER,
+        .el_size = vec->el_size,
+        .count = vec->el_count,
+        .alignment = VECTOR_FILE_ALIGNMENT,
+    };
+    char padding[VECTOR_FILE_ALIGNMENT] = {0};
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -errno;
+
+    int ret = _write_all(fd, &header, sizeof(header));
+    if (ret == 0) {
+        ret = _write_all(fd, padding,
+                         _data_offset(VECTOR_FILE_ALIGNMENT) - sizeof(header));
+    }
+    if (ret == 0)
+        ret = _write_all(fd, vec->array, vec->el_count * vec->el_size);
+
+    if (close(fd) < 0 && ret == 0)
+        ret = -errno;
+
+    return ret;
+}
+
+struct vector *vector_map(const char *path, int flags)
+{
+    if (path == NULL || (flags != VECTOR_MAP_READONLY &&
+                         flags != VECTOR_MAP_PRIVATE)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct vector *vec;
+    struct vector_file_header header;
+    struct stat st;
+    int err;
+
+    if (fstat(fd, &st) < 0)
+        goto close_file_;
+
+    errno = EINVAL;
+    if ((size_t) st.st_size < sizeof(header))
+        goto close_file_;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header))
+        goto close_file_;
+    if (memcmp(header.magic, VECTOR_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != VECTOR_FILE_VERSION ||
+            header.byte_order != VECTOR_FILE_BYTE_ORDER ||
+            header.el_size == 0)
+        goto close_file_;
+
+    // a larger alignment than the page gains nothing and could make the
+    // data offset wrap around
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (header.alignment == 0 ||
+            (header.alignment & (header.alignment - 1)) != 0 ||
+            page_size < 0 || header.alignment > (uint64_t) page_size)
+        goto close_file_;
+
+    size_t offset = _data_offset(header.alignment);
+    if (header.count > (SIZE_MAX - offset) / header.el_size ||
+            (size_t) st.st_size < offset + header.count * header.el_size)
+        goto close_file_;
+
+    vec = malloc(sizeof(*vec));
+    if (vec == NULL)
+        goto close_file_;
+
+    int prot = PROT_READ;
+    if (flags == VECTOR_MAP_PRIVATE)
+        prot |= PROT_WRITE;
+
+    vec->map_size = offset + header.count * header.el_size;
+    vec->map = mmap(NULL, vec->map_size, prot, MAP_PRIVATE, fd, 0);
+    if (vec->map == MAP_FAILED)
+        goto free_vector_;
+
+    vec->array = (char *) vec->map + offset;
+    // the mapping holds exactly the stored elements, the vector never
+    // shrinks below them
+    vec->min_capacity = header.count;
+    vec->capacity = header.count;
+    vec->el_count = header.count;
+    vec->el_size = header.el_size;
+    vec->readonly = flags == VECTOR_MAP_READONLY;
+
+    vec->policy = VECTOR_POLICY_DEFAULT;
+    vec->shrink_retry_below = SIZE_MAX;
+
+#ifdef VECTOR_STATS
+    memset(&vec->stats, 0, sizeof(vec->stats));
+#endif
+    stat_capacity(vec);
+
+    close(fd);
+
+    return vec;
+
+free_vector_:
+    free(vec);
+close_file_:
+    err = errno;
+    close(fd);
+    errno = err;
+    return NULL;
+}
+
+int vector_get_stats(struct vector *vec, struct vector_stats *stats)
+{
+#ifdef VECTOR_STATS
+    if (vec == NULL || stats == NULL)
+        return -EINVAL;
+
+    *stats = vec->stats;
+
+    return 0;
+#else
+    (void) vec;
+    (void) stats;
+    return -ENOTSUP;
+#endif
+}
+
+int vector_get_global_stats(struct vector_stats *stats)
+{
+#ifdef VECTOR_STATS
+    if (stats == NULL)
+        return -EINVAL;
+
+    stats->grows = atomic_load(&_global_stats.grows);
+    stats->shrinks = atomic_load(&_global_stats.shrinks);
+    stats->bytes_reallocated = atomic_load(&_global_stats.bytes_reallocated);
+    stats->bytes_moved = atomic_load(&_global_stats.bytes_moved);
+    stats->peak_capacity = atomic_load(&_global_stats.peak_capacity);
+
+    return 0;
+#else
+    (void) stats;
+    return -ENOTSUP;
+#endif
+}
+
+void vector_reset_global_stats(void)
+{
+#ifdef VECTOR_STATS
+    atomic_store(&_global_stats.grows, 0);
+    atomic_store(&_global_stats.shrinks, 0);
+    atomic_store(&_global_stats.bytes_reallocated, 0);
+    atomic_store(&_global_stats.bytes_moved, 0);
+    atomic_store(&_global_stats.peak_capacity, 0);
+#endif
+}
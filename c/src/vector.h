@@ -36,9 +36,69 @@
 #define VECTOR_H
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "binary_search.h"
+
+/** Flags of vector_map(). */
+enum {
+    VECTOR_MAP_READONLY,    //!< the vector can't be modified
+    VECTOR_MAP_PRIVATE,     //!< modifications are copy-on-write, never saved
+};
 
 struct vector;
 
+/** Resize policy of a vector.
+ *
+ * All the factors are fractions given as numerator and denominator. When
+ * a vector is full its capacity is multiplied by the growth factor. When
+ * after a removal the number of elements falls under the shrink threshold
+ * (a fraction of the capacity) the capacity is multiplied by the shrink
+ * factor. A threshold well below the shrink factor gives hysteresis: the
+ * vector has to lose many elements before it shrinks and many more have to
+ * come back before it grows again. The capacity never drops below the one
+ * the vector was created with.
+ */
+struct vector_policy {
+    size_t growth_num;
+    size_t growth_den;
+    size_t shrink_threshold_num;
+    size_t shrink_threshold_den;
+    size_t shrink_num;
+    size_t shrink_den;
+    bool never_shrink;          //!< the capacity is only ever increased
+};
+
+/** Grow by 3/2 when full, shrink to 2/3 when less than half full. */
+#define VECTOR_POLICY_DEFAULT ((struct vector_policy) {                     \
+    .growth_num = 3, .growth_den = 2,                                       \
+    .shrink_threshold_num = 1, .shrink_threshold_den = 2,                   \
+    .shrink_num = 2, .shrink_den = 3,                                       \
+    .never_shrink = false,                                                  \
+})
+
+/** Grow by 3/2 when full, shrink to 2/3 when less than quarter full. */
+#define VECTOR_POLICY_HYSTERESIS ((struct vector_policy) {                  \
+    .growth_num = 3, .growth_den = 2,                                       \
+    .shrink_threshold_num = 1, .shrink_threshold_den = 4,                   \
+    .shrink_num = 2, .shrink_den = 3,                                       \
+    .never_shrink = false,                                                  \
+})
+
+/** Resize and data movement counters.
+ *
+ * The counters are only maintained if the library is compiled with
+ * @c VECTOR_STATS defined.
+ */
+struct vector_stats {
+    uint64_t grows;             //!< number of capacity increases
+    uint64_t shrinks;           //!< number of capacity decreases
+    uint64_t bytes_reallocated; //!< bytes requested from realloc()
+    uint64_t bytes_moved;       //!< bytes shifted by insertions and removals
+    size_t peak_capacity;       //!< highest capacity seen, in elements
+};
+
 /** Created vector object and initialises it.
  *
  * Creates a vector. If capacity is 0 then default one will be assumed and
@@ -80,6 +140,59 @@ size_t vector_size(struct vector *vector);
  */
 size_t vector_capacity(struct vector *vector);
 
+/** Returns size of a single element of the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return size of the vector's element
+ */
+size_t vector_element_size(struct vector *vector);
+
+/** Tells whether the vector is a read-only file mapping.
+ *
+ * The storage of such a vector returned by vector_data() must not be
+ * written to.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return true if the vector can't be modified
+ */
+bool vector_is_readonly(struct vector *vector);
+
+/** Sets the resize policy of the vector.
+ *
+ * The new policy is applied with the next insertion or removal.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] policy the policy, see struct vector_policy
+ *
+ * @return 0 upon success, -EINVAL if the growth factor isn't greater than 1,
+ *         the shrink factor or threshold is zero or the shrink factor is
+ *         smaller than the shrink threshold
+ */
+int vector_set_policy(struct vector *vector,
+                      const struct vector_policy *policy);
+
+/** Makes sure the vector can hold @c capacity elements without resizing.
+ *
+ * The capacity is never decreased by this call, though later removals may
+ * shrink the vector according to its policy.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] capacity requested capacity
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_reserve(struct vector *vector, size_t capacity);
+
+/** Reduces the capacity of the vector to the number of its elements.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_shrink_to_fit(struct vector *vector);
+
 /** Inserts an element at a given position in the vector.
  *
  * Insert an element at the gieven position. This means that the element will
@@ -137,4 +250,180 @@ void vector_set(struct vector *vector, size_t index, void *element);
  */
 void *vector_get(struct vector *vector, size_t index);
 
+/** Returns pointer to the vector's storage.
+ *
+ * The elements are stored contiguously so the returned pointer can be used to
+ * access all @c vector_size() elements directly. The pointer is only valid
+ * until the next operation that may resize the vector. The storage of a
+ * read-only mapping, see vector_is_readonly(), must not be written to.
+ *
+ * @param[in] vector pointer to the vector object
+ *
+ * @return pointer to the first element of the vector
+ */
+void *vector_data(struct vector *vector);
+
+/** Inserts an element into a sorted vector keeping it sorted.
+ *
+ * The position is looked up with a binary search. If the vector already
+ * holds elements equal to @c element the new one is placed after all of them
+ * so the insertion order of equal elements is preserved.
+ *
+ * This call may trigger a resize operation if the vector runs out of space.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ * @param[in] element the element to put into the vector
+ *
+ * @return index of the inserted element upon success and negative error code
+ *         otherwise
+ */
+ssize_t vector_insert_sorted(struct vector *vector, compare_fn_t compare,
+                             void *element);
+
+/** Finds an element in a sorted vector.
+ *
+ * Has the same semantics as binary_search_leftmost(), i.e. if there are
+ * multiple elements equal to @c key the index of the first one is returned.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ * @param[in] key the element to look for
+ *
+ * @return index of the element or -1 if the element wasn't found
+ */
+ssize_t vector_find(struct vector *vector, compare_fn_t compare, void *key);
+
+/** Removes all elements equal to a given key from a sorted vector.
+ *
+ * All the matching elements are removed with a single data move. This call
+ * may trigger a vector resize operation if the number of elements falls under
+ * predefined threshold.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ * @param[in] key the element to remove
+ *
+ * @return number of removed elements upon success and negative error code
+ *         otherwise
+ */
+ssize_t vector_erase_key(struct vector *vector, compare_fn_t compare,
+                         void *key);
+
+/** Appends a batch of elements at the end of the vector.
+ *
+ * The vector is resized at most once for the whole batch.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] elements array of elements to append
+ * @param[in] count number of elements in the array
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_append(struct vector *vector, const void *elements, size_t count);
+
+/** Merges a sorted batch of elements into a sorted vector.
+ *
+ * The vector is resized at most once and the batch is merged in a single
+ * linear pass, so merging @c count elements into a vector of @c n elements
+ * costs O(n + count) instead of O(n * count) for separate inserts. Elements
+ * from the batch are placed after the equal elements already present in the
+ * vector.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ * @param[in] elements array of elements sorted according to @c compare
+ * @param[in] count number of elements in the array
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_merge_sorted_bulk(struct vector *vector, compare_fn_t compare,
+                             const void *elements, size_t count);
+
+/** Sorts the vector in place with sort().
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_sort(struct vector *vector, compare_fn_t compare);
+
+/** Sorts the vector in place with sort_stable().
+ *
+ * Equal elements keep their order. A temporary copy of the elements is
+ * allocated for the duration of the call.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_sort_stable(struct vector *vector, compare_fn_t compare);
+
+/** Saves the vector to a file.
+ *
+ * The file starts with a header followed by the raw elements of the vector:
+ *
+ * | offset | size | field                                             |
+ * |--------|------|---------------------------------------------------|
+ * | 0      | 8    | magic, "VECTOR\0\0"                               |
+ * | 8      | 4    | format version, currently 1                       |
+ * | 12     | 4    | 0x01020304, to detect files from other endianness |
+ * | 16     | 8    | element size                                      |
+ * | 24     | 8    | element count                                     |
+ * | 32     | 8    | alignment of the elements in the file             |
+ *
+ * The elements start at the first offset past the header that is a multiple
+ * of the alignment. All the fields are stored in the native byte order.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] path path of the file, overwritten if it exists
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_save(struct vector *vector, const char *path);
+
+/** Creates a vector backed by a file written by vector_save().
+ *
+ * The file is memory mapped so this call takes constant time and the pages
+ * are read in lazily as they get accessed.
+ *
+ * With @c VECTOR_MAP_READONLY all operations that modify the vector fail
+ * with @c EROFS. With @c VECTOR_MAP_PRIVATE the vector can be modified, pages
+ * are copied on the first write and the file is never changed. Once such
+ * a vector needs to grow its elements are moved to the heap.
+ *
+ * @param[in] path path of the file
+ * @param[in] flags @c VECTOR_MAP_READONLY or @c VECTOR_MAP_PRIVATE
+ *
+ * @return pointer to the vector object or NULL on error, @c errno is set
+ *         to indicate the error
+ */
+struct vector *vector_map(const char *path, int flags);
+
+/** Returns resize and data movement counters of the vector.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[out] stats the counters
+ *
+ * @return 0 upon success, -ENOTSUP if compiled without @c VECTOR_STATS and
+ *         negative error code otherwise
+ */
+int vector_get_stats(struct vector *vector, struct vector_stats *stats);
+
+/** Returns resize and data movement counters summed over all the vectors.
+ *
+ * The peak capacity is the highest capacity of any single vector.
+ *
+ * @param[out] stats the counters
+ *
+ * @return 0 upon success, -ENOTSUP if compiled without @c VECTOR_STATS and
+ *         negative error code otherwise
+ */
+int vector_get_global_stats(struct vector_stats *stats);
+
+/** Zeroes the global counters. */
+void vector_reset_global_stats(void);
+
 #endif // VECTOR_H
@@ -0,0 +1,714 @@
+/**
+ * @file vector_parallel.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "countdownlatch.h"
+#include "sort.h"
+#include "vector_parallel.h"
+
+#define CACHE_LINE_SIZE 64
+#define DEFAULT_CHUNK_BYTES (64 * 1024)
+
+struct _job {
+    void (*run)(struct _job *job, size_t chunk);
+    size_t chunks;
+    atomic_size_t next;
+    countdownlatch_t done;
+};
+
+struct vector_pool {
+    pthread_t *threads;
+    unsigned int count;
+
+    pthread_mutex_t submit;     //!< serialises jobs from different callers
+    pthread_mutex_t mutex;      //!< protects all the fields below
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+
+    struct _job *job;
+    unsigned long generation;
+    unsigned int active;
+    bool stop;
+};
+
+struct _range_job {
+    struct _job job;
+    size_t count;
+    size_t step;
+    size_t head;    //!< elements of the first chunk
+    char *src;
+    size_t src_size;
+    char *dst;
+    size_t dst_size;
+    void *arg;
+    union {
+        vector_for_each_fn_t for_each;
+        vector_transform_fn_t transform;
+        struct {
+            vector_reduce_fn_t fn;
+            char *accs;
+            size_t acc_size;
+            size_t acc_stride;
+            const void *identity;
+        } reduce;
+        struct {
+            compare_fn_t compare;
+            size_t width;
+            bool stable;
+        } sort;
+        struct {
+            compare_fn_t compare;
+            size_t count;
+        } search;
+    } u;
+};
+
+static size_t _gcd(size_t a, size_t b)
+{
+    while (b != 0) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// number of elements in one chunk; a multiple of the number of elements that
+// span a whole number of cache lines so that a chunk starting at a line
+// boundary also ends at one
+static size_t _chunk_step(size_t el_size, size_t count, size_t grain)
+{
+    if (grain == 0)
+        grain = DEFAULT_CHUNK_BYTES / el_size;
+    if (grain == 0)
+        grain = 1;
+
+    size_t line = CACHE_LINE_SIZE / _gcd(el_size, CACHE_LINE_SIZE);
+    size_t step = (grain + line - 1) / line * line;
+
+    // the latch counts the chunks, one more for the head, with an unsigned
+    // int
+    while (count / step >= UINT_MAX - 1)
+        step *= 2;
+
+    return step;
+}
+
+static void _job_work(struct _job *job)
+{
+    size_t chunk;
+
+    while ((chunk = atomic_fetch_add(&job->next, 1)) < job->chunks) {
+        job->run(job, chunk);
+        countdownlatch_countdown(&job->done);
+    }
+}
+
+static void *_worker(void *arg)
+{
+    struct vector_pool *pool = arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    for (;;) {
+        while (!pool->stop && (pool->job == NULL || pool->generation == seen))
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+
+        if (pool->stop)
+            break;
+
+        struct _job *job = pool->job;
+        seen = pool->generation;
+        pool->active += 1;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        _job_work(job);
+
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->idle);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static int _run(struct vector_pool *pool, struct _job *job)
+{
+    int ret = countdownlatch_init(&job->done, job->chunks);
+    if (ret != 0)
+        return -ret;
+
+    atomic_init(&job->next, 0);
+
+    if (pool != NULL) {
+        pthread_mutex_lock(&pool->submit);
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->job = job;
+        pool->generation += 1;
+        pthread_cond_broadcast(&pool->wake);
+
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    _job_work(job);
+    countdownlatch_await(&job->done);
+
+    if (pool != NULL) {
+        // the job lives on the caller's stack so wait until none of the
+        // workers references it anymore
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->job = NULL;
+        while (pool->active > 0)
+            pthread_cond_wait(&pool->idle, &pool->mutex);
+
+        pthread_mutex_unlock(&pool->mutex);
+        pthread_mutex_unlock(&pool->submit);
+    }
+
+    countdownlatch_destroy(&job->done);
+
+    return 0;
+}
+
+// elements before the first cache line boundary of the data, which end the
+// first chunk so that the following ones start at line boundaries; a whole
+// step if the data is aligned, not given or no element starts at a boundary
+static size_t _chunk_head(const char *data, size_t el_size, size_t step)
+{
+    if (data == NULL)
+        return step;
+
+    size_t line = CACHE_LINE_SIZE / _gcd(el_size, CACHE_LINE_SIZE);
+    for (size_t i = 1; i < line; i++) {
+        if (((uintptr_t) data + i * el_size) % CACHE_LINE_SIZE == 0)
+            return i;
+    }
+    return step;
+}
+
+// the chunks are aligned to the cache lines of the data the job writes to,
+// NULL if it has no such data or the chunks have to start at multiples of
+// the step
+static void _range_init(struct _range_job *rj, size_t count,
+                        const void *data, size_t el_size, size_t grain,
+                        void (*run)(struct _job *, size_t))
+{
+    rj->count = count;
+    rj->step = _chunk_step(el_size, rj->count, grain);
+    rj->head = _chunk_head(data, el_size, rj->step);
+    rj->job.run = run;
+    if (rj->count <= rj->head)
+        rj->job.chunks = rj->count > 0;
+    else
+        rj->job.chunks = 1 + (rj->count - rj->head + rj->step - 1) / rj->step;
+}
+
+static inline size_t _chunk_begin(struct _range_job *rj, size_t chunk)
+{
+    return chunk == 0 ? 0 : rj->head + (chunk - 1) * rj->step;
+}
+
+static inline size_t _chunk_end(struct _range_job *rj, size_t chunk)
+{
+    size_t end = rj->head + chunk * rj->step;
+    return end < rj->count ? end : rj->count;
+}
+
+struct vector_pool *vector_pool_create(unsigned int threads)
+{
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int) cpus : 1;
+    }
+
+    struct vector_pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        goto return_null_;
+
+    pool->threads = calloc(threads, sizeof(*pool->threads));
+    if (pool->threads == NULL)
+        goto free_pool_;
+
+    pthread_mutex_init(&pool->submit, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (; pool->count < threads; pool->count++) {
+        if (pthread_create(&pool->threads[pool->count], NULL, _worker,
+                           pool) != 0)
+            goto destroy_pool_;
+    }
+
+    return pool;
+
+destroy_pool_:
+    vector_pool_destroy(pool);
+    return NULL;
+free_pool_:
+    free(pool);
+return_null_:
+    return NULL;
+}
+
+void vector_pool_destroy(struct vector_pool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned int i = 0; i < pool->count; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_mutex_destroy(&pool->submit);
+
+    free(pool->threads);
+    free(pool);
+}
+
+// ----- for_each --------------------------------------------------------------
+
+static void _for_each_run(struct _job *job, size_t chunk)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+
+    for (size_t i = _chunk_begin(rj, chunk); i < _chunk_end(rj, chunk); i++)
+        rj->u.for_each(rj->src + (i * rj->src_size), i, rj->arg);
+}
+
+int vector_parallel_for_each(struct vector_pool *pool, struct vector *vec,
+                             size_t grain, vector_for_each_fn_t fn, void *arg)
+{
+    if (vec == NULL || fn == NULL)
+        return -EINVAL;
+    if (vector_is_readonly(vec))
+        return -EROFS;
+
+    struct _range_job rj = {
+        .src = vector_data(vec),
+        .src_size = vector_element_size(vec),
+        .arg = arg,
+        .u.for_each = fn,
+    };
+    _range_init(&rj, vector_size(vec), rj.src, rj.src_size, grain,
+                _for_each_run);
+
+    if (rj.count == 0)
+        return 0;
+
+    return _run(pool, &rj.job);
+}
+
+// ----- transform -------------------------------------------------------------
+
+static void _transform_run(struct _job *job, size_t chunk)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+
+    for (size_t i = _chunk_begin(rj, chunk); i < _chunk_end(rj, chunk); i++) {
+        rj->u.transform(rj->src + (i * rj->src_size),
+                        rj->dst + (i * rj->dst_size), rj->arg);
+    }
+}
+
+int vector_parallel_transform(struct vector_pool *pool, struct vector *src,
+                              struct vector *dst, size_t grain,
+                              vector_transform_fn_t fn, void *arg)
+{
+    if (src == NULL || dst == NULL || fn == NULL ||
+            vector_size(src) != vector_size(dst))
+        return -EINVAL;
+    if (vector_is_readonly(dst))
+        return -EROFS;
+
+    struct _range_job rj = {
+        .src = vector_data(src),
+        .src_size = vector_element_size(src),
+        .dst = vector_data(dst),
+        .dst_size = vector_element_size(dst),
+        .arg = arg,
+        .u.transform = fn,
+    };
+    _range_init(&rj, vector_size(src), rj.dst, rj.dst_size, grain,
+                _transform_run);
+
+    if (rj.count == 0)
+        return 0;
+
+    return _run(pool, &rj.job);
+}
+
+// ----- reduce ----------------------------------------------------------------
+
+static void _reduce_run(struct _job *job, size_t chunk)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+    void *acc = rj->u.reduce.accs + (chunk * rj->u.reduce.acc_stride);
+
+    memcpy(acc, rj->u.reduce.identity, rj->u.reduce.acc_size);
+
+    for (size_t i = _chunk_begin(rj, chunk); i < _chunk_end(rj, chunk); i++)
+        rj->u.reduce.fn(acc, rj->src + (i * rj->src_size), rj->arg);
+}
+
+int vector_parallel_reduce(struct vector_pool *pool, struct vector *vec,
+                           size_t grain, vector_reduce_fn_t reduce,
+                           vector_combine_fn_t combine, void *result,
+                           size_t result_size, void *arg)
+{
+    if (vec == NULL || reduce == NULL || combine == NULL || result == NULL ||
+            result_size == 0)
+        return -EINVAL;
+
+    struct _range_job rj = {
+        .src = vector_data(vec),
+        .src_size = vector_element_size(vec),
+        .arg = arg,
+        .u.reduce.fn = reduce,
+        .u.reduce.acc_size = result_size,
+        .u.reduce.identity = result,
+    };
+    _range_init(&rj, vector_size(vec), NULL, rj.src_size, grain,
+                _reduce_run);
+
+    if (rj.count == 0)
+        return 0;
+
+    // keep every accumulator in its own cache line(s)
+    size_t stride = (result_size + CACHE_LINE_SIZE - 1) /
+                    CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    rj.u.reduce.accs = aligned_alloc(CACHE_LINE_SIZE, rj.job.chunks * stride);
+    if (rj.u.reduce.accs == NULL)
+        return -ENOMEM;
+    rj.u.reduce.acc_stride = stride;
+
+    int ret = _run(pool, &rj.job);
+    if (ret == 0) {
+        for (size_t i = 0; i < rj.job.chunks; i++)
+            combine(result, rj.u.reduce.accs + (i * stride), arg);
+    }
+
+    free(rj.u.reduce.accs);
+
+    return ret;
+}
+
+// ----- sort ------------------------------------------------------------------
+
+static void _sort_run(struct _job *job, size_t chunk)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+    size_t first = _chunk_begin(rj, chunk);
+
+    size_t count = _chunk_end(rj, chunk) - first;
+
+    // the chunks of the merge buffer are free until the merges start
+    if (rj->u.sort.stable)
+        sort_stable_buffered(rj->src + (first * rj->src_size), count,
+                             rj->src_size, rj->u.sort.compare,
+                             rj->dst + (first * rj->src_size));
+    else
+        sort(rj->src + (first * rj->src_size), count, rj->src_size,
+             rj->u.sort.compare);
+}
+
+// merges runs [first, first + width) and [first + width, first + 2 * width)
+// of src into dst
+static void _merge_run(struct _job *job, size_t pair)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+    compare_fn_t compare = rj->u.sort.compare;
+    size_t el_size = rj->src_size;
+    size_t width = rj->u.sort.width;
+
+    size_t left = pair * 2 * width;
+    size_t mid = left + width < rj->count ? left + width : rj->count;
+    size_t end = mid + width < rj->count ? mid + width : rj->count;
+    size_t right = mid, out = left;
+
+    while (left < mid && right < end) {
+        const char *l = rj->src + (left * el_size);
+        const char *r = rj->src + (right * el_size);
+
+        if (compare(r, l) < 0) {
+            memcpy(rj->dst + (out++ * el_size), r, el_size);
+            right += 1;
+        } else {
+            memcpy(rj->dst + (out++ * el_size), l, el_size);
+            left += 1;
+        }
+    }
+
+    memcpy(rj->dst + (out * el_size), rj->src + (left * el_size),
+           (mid - left) * el_size);
+    out += mid - left;
+    memcpy(rj->dst + (out * el_size), rj->src + (right * el_size),
+           (end - right) * el_size);
+}
+
+static int _sort(struct vector_pool *pool, char *data, size_t count,
+                 size_t el_size, size_t grain, compare_fn_t compare,
+                 bool stable)
+{
+    struct _range_job rj = {
+        .src = data,
+        .src_size = el_size,
+        .u.sort.compare = compare,
+        .u.sort.stable = stable,
+    };
+    // the merges expect runs at multiples of the step
+    _range_init(&rj, count, NULL, el_size, grain, _sort_run);
+
+    if (rj.count < 2)
+        return 0;
+
+    char *tmp = NULL;
+    if (stable || rj.job.chunks > 1) {
+        tmp = malloc(rj.count * el_size);
+        if (tmp == NULL)
+            return -ENOMEM;
+    }
+    rj.dst = tmp;
+
+    int ret = _run(pool, &rj.job);
+    if (ret != 0 || rj.job.chunks == 1)
+        goto free_tmp_;
+
+    // the merges take the left element on ties, so they keep the order of
+    // equal elements
+    rj.job.run = _merge_run;
+
+    for (size_t width = rj.step; width < rj.count; width *= 2) {
+        rj.u.sort.width = width;
+        rj.job.chunks = (rj.count + 2 * width - 1) / (2 * width);
+
+        ret = _run(pool, &rj.job);
+        if (ret != 0)
+            break;
+
+        char *swap = rj.src;
+        rj.src = rj.dst;
+        rj.dst = swap;
+    }
+
+    if (rj.src != data)
+        memcpy(data, rj.src, rj.count * el_size);
+
+free_tmp_:
+    free(tmp);
+
+    return ret;
+}
+
+int vector_parallel_sort(struct vector_pool *pool, struct vector *vec,
+                         size_t grain, compare_fn_t compare)
+{
+    if (vec == NULL || compare == NULL)
+        return -EINVAL;
+    if (vector_is_readonly(vec))
+        return -EROFS;
+
+    return _sort(pool, vector_data(vec), vector_size(vec),
+                 vector_element_size(vec), grain, compare, false);
+}
+
+int vector_parallel_sort_stable(struct vector_pool *pool, struct vector *vec,
+                                size_t grain, compare_fn_t compare)
+{
+    if (vec == NULL || compare == NULL)
+        return -EINVAL;
+    if (vector_is_readonly(vec))
+        return -EROFS;
+
+    return _sort(pool, vector_data(vec), vector_size(vec),
+                 vector_element_size(vec), grain, compare, true);
+}
+
+int vector_parallel_sort_array(struct vector_pool *pool, void *array,
+                               size_t asize, size_t esize, size_t grain,
+                               compare_fn_t compare)
+{
+    if ((array == NULL && asize > 0) || esize == 0 || compare == NULL ||
+            asize > SSIZE_MAX / esize)
+        return -EINVAL;
+
+    return _sort(pool, array, asize, esize, grain, compare, false);
+}
+
+int vector_parallel_sort_array_stable(struct vector_pool *pool, void *array,
+                                      size_t asize, size_t esize,
+                                      size_t grain, compare_fn_t compare)
+{
+    if ((array == NULL && asize > 0) || esize == 0 || compare == NULL ||
+            asize > SSIZE_MAX / esize)
+        return -EINVAL;
+
+    return _sort(pool, array, asize, esize, grain, compare, true);
+}
+
+// ----- search ----------------------------------------------------------------
+
+// Every record holds a key followed by its position in the batch, so the
+// records sort with the comparator of the elements. Once a key is looked up
+// its result replaces it in the record, so every task writes only to its own
+// chunk of records, and a final pass moves the results to their positions.
+
+// the key is padded to whole size_t, so a result always fits in its place
+static inline size_t _record_key_size(size_t el_size)
+{
+    return (el_size + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+}
+
+static void _search_run(struct _job *job, size_t chunk)
+{
+    struct _range_job *rj = (struct _range_job *) job;
+    compare_fn_t compare = rj->u.search.compare;
+    size_t el_size = rj->dst_size;
+    size_t first = _chunk_begin(rj, chunk), end = _chunk_end(rj, chunk);
+
+    // the range of the vector between the smallest and the largest key
+    ssize_t left = binary_search_lower_bound(rj->dst, rj->u.search.count,
+                                             el_size, compare,
+                                             rj->src + (first * rj->src_size));
+    ssize_t right = binary_search_upper_bound(rj->dst, rj->u.search.count,
+                                              el_size, compare,
+                                              rj->src +
+                                              ((end - 1) * rj->src_size));
+    char *range = rj->dst + (left * el_size);
+    size_t hint = 0;
+
+    for (size_t i = first; i < end; i++) {
+        char *record = rj->src + (i * rj->src_size);
+
+        ssize_t found = binary_search_gallop_leftmost(range,
+                                                      (size_t) (right - left),
+                                                      el_size, compare,
+                                                      record, hint);
+        if (found >= 0)
+            hint = (size_t) found;
+
+        ssize_t result = found < 0 ? -1 : left + found;
+        memcpy(record, &result, sizeof(result));
+    }
+}
+
+int vector_parallel_search(struct vector_pool *pool, struct vector *vec,
+                           struct vector *keys, struct vector *results,
+                           size_t grain, compare_fn_t compare)
+{
+    if (vec == NULL || keys == NULL || results == NULL || compare == NULL ||
+            vector_element_size(keys) != vector_element_size(vec) ||
+            vector_element_size(results) != sizeof(ssize_t) ||
+            vector_size(results) != vector_size(keys))
+        return -EINVAL;
+    if (vector_is_readonly(results))
+        return -EROFS;
+
+    size_t count = vector_size(keys);
+    size_t el_size = vector_element_size(vec);
+    ssize_t *found = vector_data(results);
+
+    if (count == 0)
+        return 0;
+
+    if (vector_size(vec) == 0) {
+        for (size_t i = 0; i < count; i++)
+            found[i] = -1;
+        return 0;
+    }
+
+    size_t key_size = _record_key_size(el_size);
+    struct vector *records = vector_create(count, key_size + sizeof(size_t));
+    if (records == NULL)
+        return -ENOMEM;
+
+    char *record = vector_data(records);
+    const char *key = vector_data(keys);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(record, key + (i * el_size), el_size);
+        memcpy(record + key_size, &i, sizeof(i));
+        record += key_size + sizeof(size_t);
+    }
+
+    int ret = vector_parallel_sort(pool, records, grain, compare);
+    if (ret != 0)
+        goto destroy_records_;
+
+    struct _range_job rj = {
+        .src = vector_data(records),
+        .src_size = vector_element_size(records),
+        .dst = vector_data(vec),
+        .dst_size = el_size,
+        .u.search.compare = compare,
+        .u.search.count = vector_size(vec),
+    };
+    _range_init(&rj, vector_size(records), rj.src, rj.src_size, grain,
+                _search_run);
+
+    ret = _run(pool, &rj.job);
+    if (ret != 0)
+        goto destroy_records_;
+
+    record = vector_data(records);
+    for (size_t i = 0; i < count; i++) {
+        size_t index;
+        memcpy(&index, record + key_size, sizeof(index));
+        memcpy(&found[index], record, sizeof(*found));
+        record += key_size + sizeof(size_t);
+    }
+
+destroy_records_:
+    vector_destroy(records);
+
+    return ret;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file vector_parallel.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __VECTOR_PARALLEL_H__
+#define __VECTOR_PARALLEL_H__
+
+#include <stddef.h>
+
+#include "binary_search.h"
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct vector_pool;
+
+typedef void (*vector_for_each_fn_t)(void *element, size_t index, void *arg);
+typedef void (*vector_transform_fn_t)(const void *in, void *out, void *arg);
+typedef void (*vector_reduce_fn_t)(void *acc, const void *element, void *arg);
+typedef void (*vector_combine_fn_t)(void *acc, const void *other, void *arg);
+
+/** Creates a pool of worker threads.
+ *
+ * The thread calling any of the vector_parallel_*() functions takes part in
+ * the work as well, so a pool of N threads runs the callbacks on N + 1
+ * threads.
+ *
+ * @param[in] threads number of worker threads, if 0 then the number of online
+ *            processors is used
+ *
+ * @return pointer to the pool object or NULL on error
+ */
+struct vector_pool *vector_pool_create(unsigned int threads);
+
+/** Stops all the worker threads and destroys the pool.
+ *
+ * @param[in] pool pointer to the pool object
+ */
+void vector_pool_destroy(struct vector_pool *pool);
+
+/** Calls a function for every element of the vector.
+ *
+ * The storage of the vector is split into chunks of at least @c grain
+ * elements. The chunk size is rounded up so that every chunk spans a whole
+ * number of cache lines and no two threads write to the same cache line.
+ * The chunks are then distributed among the threads of the pool.
+ *
+ * The order in which the function is called is unspecified.
+ *
+ * @param[in] pool pointer to the pool object, if NULL then all the work is
+ *            done by the calling thread
+ * @param[in] vector pointer to the vector object
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] fn function to call
+ * @param[in] arg user argument passed to @c fn
+ *
+ * @return 0 upon success, -EROFS if the vector is a read-only mapping and
+ *         other negative error code otherwise
+ */
+int vector_parallel_for_each(struct vector_pool *pool, struct vector *vector,
+                             size_t grain, vector_for_each_fn_t fn, void *arg);
+
+/** Transforms elements of one vector into another.
+ *
+ * For every index @c i the function is called with the i-th element of
+ * @c src and the i-th element of @c dst. Both vectors must have the same size
+ * but may have different element sizes. @c src and @c dst may be the same
+ * vector.
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] src pointer to the source vector
+ * @param[in] dst pointer to the destination vector
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] fn function to call
+ * @param[in] arg user argument passed to @c fn
+ *
+ * @return 0 upon success, -EROFS if @c dst is a read-only mapping and other
+ *         negative error code otherwise
+ */
+int vector_parallel_transform(struct vector_pool *pool, struct vector *src,
+                              struct vector *dst, size_t grain,
+                              vector_transform_fn_t fn, void *arg);
+
+/** Reduces all the elements of the vector to a single value.
+ *
+ * Every task starts with a copy of the initial value of @c result (which has
+ * to be an identity of the reduction) and folds its chunk into it with
+ * @c reduce. Partial results are then folded into @c result with @c combine
+ * in the order of the chunks, so the reduction doesn't need to be commutative
+ * but it has to be associative.
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] vector pointer to the vector object
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] reduce function folding an element into an accumulator
+ * @param[in] combine function folding an accumulator into another one
+ * @param[in,out] result the identity value on input and the result on output
+ * @param[in] result_size size of the result
+ * @param[in] arg user argument passed to @c reduce and @c combine
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_parallel_reduce(struct vector_pool *pool, struct vector *vector,
+                           size_t grain, vector_reduce_fn_t reduce,
+                           vector_combine_fn_t combine, void *result,
+                           size_t result_size, void *arg);
+
+/** Sorts the vector.
+ *
+ * The chunks are sorted in parallel with sort() and then merged pairwise,
+ * with the merges of every pass running in parallel. The sort is not stable.
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] vector pointer to the vector object
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success, -EROFS if the vector is a read-only mapping and
+ *         other negative error code otherwise
+ */
+int vector_parallel_sort(struct vector_pool *pool, struct vector *vector,
+                         size_t grain, compare_fn_t compare);
+
+/** Sorts the vector keeping the order of equal elements.
+ *
+ * Same as vector_parallel_sort() but the chunks are sorted with
+ * sort_stable().
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] vector pointer to the vector object
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success, -EROFS if the vector is a read-only mapping and
+ *         other negative error code otherwise
+ */
+int vector_parallel_sort_stable(struct vector_pool *pool,
+                                struct vector *vector, size_t grain,
+                                compare_fn_t compare);
+
+/** Sorts an array, see vector_parallel_sort().
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] array the array to sort
+ * @param[in] asize number of elements in the array
+ * @param[in] esize size of a single element
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_parallel_sort_array(struct vector_pool *pool, void *array,
+                               size_t asize, size_t esize, size_t grain,
+                               compare_fn_t compare);
+
+/** Sorts an array keeping the order of equal elements, see
+ * vector_parallel_sort_stable().
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] array the array to sort
+ * @param[in] asize number of elements in the array
+ * @param[in] esize size of a single element
+ * @param[in] grain minimum number of elements processed by one task, if 0
+ *            then a default is used
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success and negative error code otherwise
+ */
+int vector_parallel_sort_array_stable(struct vector_pool *pool, void *array,
+                                      size_t asize, size_t esize,
+                                      size_t grain, compare_fn_t compare);
+
+/** Looks up a batch of keys in a sorted vector.
+ *
+ * The keys are sorted together with their positions in the batch and the
+ * sorted batch is split into chunks of at least @c grain keys. Every task
+ * first narrows the vector down to the range spanned by its chunk and then
+ * gallops through that range from one key to the next, so the threads work
+ * on disjoint parts of the vector. Every task stores its results in its own
+ * chunk of the sorted batch; the results are then moved to their positions
+ * in @c results by a single thread, one more pass over the batch.
+ *
+ * For every index @c i the i-th element of @c results is set to what
+ * binary_search_leftmost() returns for the i-th key. @c results must have
+ * the same size as @c keys and elements of type @c ssize_t.
+ *
+ * @param[in] pool pointer to the pool object or NULL
+ * @param[in] vector pointer to the vector sorted according to @c compare
+ * @param[in] keys pointer to the vector of keys to look up, the keys have the
+ *            same type as the elements of @c vector
+ * @param[out] results pointer to the vector of results
+ * @param[in] grain minimum number of keys processed by one task, if 0 then
+ *            a default is used
+ * @param[in] compare function comparing two elements
+ *
+ * @return 0 upon success, -EROFS if @c results is a read-only mapping and
+ *         other negative error code otherwise
+ */
+int vector_parallel_search(struct vector_pool *pool, struct vector *vector,
+                           struct vector *keys, struct vector *results,
+                           size_t grain, compare_fn_t compare);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __VECTOR_PARALLEL_H__
@@ -0,0 +1,400 @@
+/**
+ * @file vector_scan.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+#include "vector_scan.h"
+
+typedef ssize_t (*find_fn_t)(const void *array, size_t n, const void *key);
+typedef size_t (*count_fn_t)(const void *array, size_t n, const void *key);
+typedef void (*minmax_fn_t)(const void *array, size_t n, void *min,
+                            void *max);
+
+struct _kernels {
+    find_fn_t find;
+    count_fn_t count;
+    minmax_fn_t minmax;
+};
+
+static const size_t _type_size[] = {
+    [VECTOR_INT8] = sizeof(int8_t),
+    [VECTOR_UINT8] = sizeof(uint8_t),
+    [VECTOR_INT16] = sizeof(int16_t),
+    [VECTOR_UINT16] = sizeof(uint16_t),
+    [VECTOR_INT32] = sizeof(int32_t),
+    [VECTOR_UINT32] = sizeof(uint32_t),
+    [VECTOR_INT64] = sizeof(int64_t),
+    [VECTOR_UINT64] = sizeof(uint64_t),
+    [VECTOR_FLOAT] = sizeof(float),
+    [VECTOR_DOUBLE] = sizeof(double),
+};
+
+static enum vector_isa _isa = VECTOR_ISA_AUTO;
+
+// ----- scalar ----------------------------------------------------------------
+
+#define SCALAR_EQ_KERNELS(name, T) \
+    static ssize_t _find_##name##_scalar(const void *array, size_t n, \
+                                         const void *key) \
+    { \
+        const T *p = array, k = *(const T *) key; \
+        for (size_t i = 0; i < n; i++) { \
+            if (p[i] == k) \
+                return i; \
+        } \
+        return -1; \
+    } \
+    static size_t _count_##name##_scalar(const void *array, size_t n, \
+                                         const void *key) \
+    { \
+        const T *p = array, k = *(const T *) key; \
+        size_t count = 0; \
+        for (size_t i = 0; i < n; i++) \
+            count += p[i] == k; \
+        return count; \
+    }
+
+#define SCALAR_MINMAX_KERNEL(name, T) \
+    static void _minmax_##name##_scalar(const void *array, size_t n, \
+                                        void *min, void *max) \
+    { \
+        const T *p = array; \
+        T lo = p[0], hi = p[0]; \
+        for (size_t i = 1; i < n; i++) { \
+            lo = p[i] < lo ? p[i] : lo; \
+            hi = p[i] > hi ? p[i] : hi; \
+        } \
+        memcpy(min, &lo, sizeof(lo)); \
+        memcpy(max, &hi, sizeof(hi)); \
+    }
+
+// equality of integers doesn't depend on the signedness so the signed kernels
+// serve the unsigned types as well
+SCALAR_EQ_KERNELS(i8, int8_t)
+SCALAR_EQ_KERNELS(i16, int16_t)
+SCALAR_EQ_KERNELS(i32, int32_t)
+SCALAR_EQ_KERNELS(i64, int64_t)
+SCALAR_EQ_KERNELS(f32, float)
+SCALAR_EQ_KERNELS(f64, double)
+
+SCALAR_MINMAX_KERNEL(i8, int8_t)
+SCALAR_MINMAX_KERNEL(u8, uint8_t)
+SCALAR_MINMAX_KERNEL(i16, int16_t)
+SCALAR_MINMAX_KERNEL(u16, uint16_t)
+SCALAR_MINMAX_KERNEL(i32, int32_t)
+SCALAR_MINMAX_KERNEL(u32, uint32_t)
+SCALAR_MINMAX_KERNEL(i64, int64_t)
+SCALAR_MINMAX_KERNEL(u64, uint64_t)
+SCALAR_MINMAX_KERNEL(f32, float)
+SCALAR_MINMAX_KERNEL(f64, double)
+
+static const struct _kernels _scalar_kernels[] = {
+    [VECTOR_INT8] = {_find_i8_scalar, _count_i8_scalar, _minmax_i8_scalar},
+    [VECTOR_UINT8] = {_find_i8_scalar, _count_i8_scalar, _minmax_u8_scalar},
+    [VECTOR_INT16] = {_find_i16_scalar, _count_i16_scalar, _minmax_i16_scalar},
+    [VECTOR_UINT16] = {_find_i16_scalar, _count_i16_scalar,
+                       _minmax_u16_scalar},
+    [VECTOR_INT32] = {_find_i32_scalar, _count_i32_scalar, _minmax_i32_scalar},
+    [VECTOR_UINT32] = {_find_i32_scalar, _count_i32_scalar,
+                       _minmax_u32_scalar},
+    [VECTOR_INT64] = {_find_i64_scalar, _count_i64_scalar, _minmax_i64_scalar},
+    [VECTOR_UINT64] = {_find_i64_scalar, _count_i64_scalar,
+                       _minmax_u64_scalar},
+    [VECTOR_FLOAT] = {_find_f32_scalar, _count_f32_scalar, _minmax_f32_scalar},
+    [VECTOR_DOUBLE] = {_find_f64_scalar, _count_f64_scalar,
+                       _minmax_f64_scalar},
+};
+
+#ifdef HAVE_X86
+
+// ----- SIMD ------------------------------------------------------------------
+
+// Every kernel processes full registers and leaves the tail to the scalar
+// kernel. The comparison results are turned into bit masks with movemask,
+// which yields mbits bits per element.
+
+#define SIMD_EQ_KERNELS(isa, name, T, VT, lanes, mbits, set1, load, cmpeq, \
+                        movemask) \
+    __attribute__((target(#isa))) \
+    static ssize_t _find_##name##_##isa(const void *array, size_t n, \
+                                        const void *key) \
+    { \
+        const T *p = array; \
+        const VT k = set1(*(const T *) key); \
+        size_t i = 0; \
+        for (; i + lanes <= n; i += lanes) { \
+            unsigned int mask = movemask(cmpeq(load(p + i), k)); \
+            if (mask != 0) \
+                return i + __builtin_ctz(mask) / mbits; \
+        } \
+        ssize_t ret = _find_##name##_scalar(p + i, n - i, key); \
+        return ret < 0 ? -1 : (ssize_t) i + ret; \
+    } \
+    __attribute__((target(#isa))) \
+    static size_t _count_##name##_##isa(const void *array, size_t n, \
+                                        const void *key) \
+    { \
+        const T *p = array; \
+        const VT k = set1(*(const T *) key); \
+        size_t i = 0, count = 0; \
+        for (; i + lanes <= n; i += lanes) { \
+            unsigned int mask = movemask(cmpeq(load(p + i), k)); \
+            count += __builtin_popcount(mask); \
+        } \
+        return count / mbits + _count_##name##_scalar(p + i, n - i, key); \
+    }
+
+#define SIMD_MINMAX_KERNEL(isa, name, T, VT, lanes, load, store, vmin, vmax) \
+    __attribute__((target(#isa))) \
+    static void _minmax_##name##_##isa(const void *array, size_t n, \
+                                       void *min, void *max) \
+    { \
+        const T *p = array; \
+        if (n < lanes) { \
+            _minmax_##name##_scalar(array, n, min, max); \
+            return; \
+        } \
+        VT lo = load(p), hi = lo; \
+        size_t i = lanes; \
+        for (; i + lanes <= n; i += lanes) { \
+            VT v = load(p + i); \
+            lo = vmin(lo, v); \
+            hi = vmax(hi, v); \
+        } \
+        T l[lanes], h[lanes]; \
+        store(l, lo); \
+        store(h, hi); \
+        for (; i < n; i++) { \
+            l[0] = p[i] < l[0] ? p[i] : l[0]; \
+            h[0] = p[i] > h[0] ? p[i] : h[0]; \
+        } \
+        T unused; \
+        _minmax_##name##_scalar(l, lanes, min, &unused); \
+        _minmax_##name##_scalar(h, lanes, &unused, max); \
+    }
+
+#define LOAD_SI128(p) _mm_loadu_si128((const __m128i *) (p))
+#define STORE_SI128(p, v) _mm_storeu_si128((__m128i *) (p), (v))
+#define LOAD_SI256(p) _mm256_loadu_si256((const __m256i *) (p))
+#define STORE_SI256(p, v) _mm256_storeu_si256((__m256i *) (p), (v))
+
+#define CMPEQ_PS_256(a, b) _mm256_cmp_ps((a), (b), _CMP_EQ_OQ)
+#define CMPEQ_PD_256(a, b) _mm256_cmp_pd((a), (b), _CMP_EQ_OQ)
+
+#define SET1_EPI64(x) _mm_set1_epi64x((long long) (x))
+#define SET1_EPI64_256(x) _mm256_set1_epi64x((long long) (x))
+
+// SSE2 has no 64-bit compare, both 32-bit halves have to match instead
+__attribute__((target("sse2")))
+static inline __m128i _cmpeq_epi64_sse2(__m128i a, __m128i b)
+{
+    __m128i eq = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+SIMD_EQ_KERNELS(sse2, i8, int8_t, __m128i, 16, 1, _mm_set1_epi8, LOAD_SI128,
+                _mm_cmpeq_epi8, _mm_movemask_epi8)
+SIMD_EQ_KERNELS(sse2, i16, int16_t, __m128i, 8, 2, _mm_set1_epi16, LOAD_SI128,
+                _mm_cmpeq_epi16, _mm_movemask_epi8)
+SIMD_EQ_KERNELS(sse2, i32, int32_t, __m128i, 4, 4, _mm_set1_epi32, LOAD_SI128,
+                _mm_cmpeq_epi32, _mm_movemask_epi8)
+SIMD_EQ_KERNELS(sse2, i64, int64_t, __m128i, 2, 8, SET1_EPI64, LOAD_SI128,
+                _cmpeq_epi64_sse2, _mm_movemask_epi8)
+SIMD_EQ_KERNELS(sse2, f32, float, __m128, 4, 1, _mm_set1_ps, _mm_loadu_ps,
+                _mm_cmpeq_ps, _mm_movemask_ps)
+SIMD_EQ_KERNELS(sse2, f64, double, __m128d, 2, 1, _mm_set1_pd, _mm_loadu_pd,
+                _mm_cmpeq_pd, _mm_movemask_pd)
+
+// SSE2 only has min/max for unsigned bytes and signed words
+SIMD_MINMAX_KERNEL(sse2, u8, uint8_t, __m128i, 16, LOAD_SI128, STORE_SI128,
+                   _mm_min_epu8, _mm_max_epu8)
+SIMD_MINMAX_KERNEL(sse2, i16, int16_t, __m128i, 8, LOAD_SI128, STORE_SI128,
+                   _mm_min_epi16, _mm_max_epi16)
+SIMD_MINMAX_KERNEL(sse2, f32, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps,
+                   _mm_min_ps, _mm_max_ps)
+SIMD_MINMAX_KERNEL(sse2, f64, double, __m128d, 2, _mm_loadu_pd,
+                   _mm_storeu_pd, _mm_min_pd, _mm_max_pd)
+
+SIMD_EQ_KERNELS(avx2, i8, int8_t, __m256i, 32, 1, _mm256_set1_epi8,
+                LOAD_SI256, _mm256_cmpeq_epi8, _mm256_movemask_epi8)
+SIMD_EQ_KERNELS(avx2, i16, int16_t, __m256i, 16, 2, _mm256_set1_epi16,
+                LOAD_SI256, _mm256_cmpeq_epi16, _mm256_movemask_epi8)
+SIMD_EQ_KERNELS(avx2, i32, int32_t, __m256i, 8, 4, _mm256_set1_epi32,
+                LOAD_SI256, _mm256_cmpeq_epi32, _mm256_movemask_epi8)
+SIMD_EQ_KERNELS(avx2, i64, int64_t, __m256i, 4, 8, SET1_EPI64_256,
+                LOAD_SI256, _mm256_cmpeq_epi64, _mm256_movemask_epi8)
+SIMD_EQ_KERNELS(avx2, f32, float, __m256, 8, 1, _mm256_set1_ps,
+                _mm256_loadu_ps, CMPEQ_PS_256, _mm256_movemask_ps)
+SIMD_EQ_KERNELS(avx2, f64, double, __m256d, 4, 1, _mm256_set1_pd,
+                _mm256_loadu_pd, CMPEQ_PD_256, _mm256_movemask_pd)
+
+// there is no 64-bit integer min/max below AVX-512, those stay scalar
+SIMD_MINMAX_KERNEL(avx2, i8, int8_t, __m256i, 32, LOAD_SI256, STORE_SI256,
+                   _mm256_min_epi8, _mm256_max_epi8)
+SIMD_MINMAX_KERNEL(avx2, u8, uint8_t, __m256i, 32, LOAD_SI256, STORE_SI256,
+                   _mm256_min_epu8, _mm256_max_epu8)
+SIMD_MINMAX_KERNEL(avx2, i16, int16_t, __m256i, 16, LOAD_SI256, STORE_SI256,
+                   _mm256_min_epi16, _mm256_max_epi16)
+SIMD_MINMAX_KERNEL(avx2, u16, uint16_t, __m256i, 16, LOAD_SI256,
+                   STORE_SI256, _mm256_min_epu16, _mm256_max_epu16)
+SIMD_MINMAX_KERNEL(avx2, i32, int32_t, __m256i, 8, LOAD_SI256, STORE_SI256,
+                   _mm256_min_epi32, _mm256_max_epi32)
+SIMD_MINMAX_KERNEL(avx2, u32, uint32_t, __m256i, 8, LOAD_SI256, STORE_SI256,
+                   _mm256_min_epu32, _mm256_max_epu32)
+SIMD_MINMAX_KERNEL(avx2, f32, float, __m256, 8, _mm256_loadu_ps,
+                   _mm256_storeu_ps, _mm256_min_ps, _mm256_max_ps)
+SIMD_MINMAX_KERNEL(avx2, f64, double, __m256d, 4, _mm256_loadu_pd,
+                   _mm256_storeu_pd, _mm256_min_pd, _mm256_max_pd)
+
+static const struct _kernels _sse2_kernels[] = {
+    [VECTOR_INT8] = {_find_i8_sse2, _count_i8_sse2, _minmax_i8_scalar},
+    [VECTOR_UINT8] = {_find_i8_sse2, _count_i8_sse2, _minmax_u8_sse2},
+    [VECTOR_INT16] = {_find_i16_sse2, _count_i16_sse2, _minmax_i16_sse2},
+    [VECTOR_UINT16] = {_find_i16_sse2, _count_i16_sse2, _minmax_u16_scalar},
+    [VECTOR_INT32] = {_find_i32_sse2, _count_i32_sse2, _minmax_i32_scalar},
+    [VECTOR_UINT32] = {_find_i32_sse2, _count_i32_sse2, _minmax_u32_scalar},
+    [VECTOR_INT64] = {_find_i64_sse2, _count_i64_sse2, _minmax_i64_scalar},
+    [VECTOR_UINT64] = {_find_i64_sse2, _count_i64_sse2, _minmax_u64_scalar},
+    [VECTOR_FLOAT] = {_find_f32_sse2, _count_f32_sse2, _minmax_f32_sse2},
+    [VECTOR_DOUBLE] = {_find_f64_sse2, _count_f64_sse2, _minmax_f64_sse2},
+};
+
+static const struct _kernels _avx2_kernels[] = {
+    [VECTOR_INT8] = {_find_i8_avx2, _count_i8_avx2, _minmax_i8_avx2},
+    [VECTOR_UINT8] = {_find_i8_avx2, _count_i8_avx2, _minmax_u8_avx2},
+    [VECTOR_INT16] = {_find_i16_avx2, _count_i16_avx2, _minmax_i16_avx2},
+    [VECTOR_UINT16] = {_find_i16_avx2, _count_i16_avx2, _minmax_u16_avx2},
+    [VECTOR_INT32] = {_find_i32_avx2, _count_i32_avx2, _minmax_i32_avx2},
+    [VECTOR_UINT32] = {_find_i32_avx2, _count_i32_avx2, _minmax_u32_avx2},
+    [VECTOR_INT64] = {_find_i64_avx2, _count_i64_avx2, _minmax_i64_scalar},
+    [VECTOR_UINT64] = {_find_i64_avx2, _count_i64_avx2, _minmax_u64_scalar},
+    [VECTOR_FLOAT] = {_find_f32_avx2, _count_f32_avx2, _minmax_f32_avx2},
+    [VECTOR_DOUBLE] = {_find_f64_avx2, _count_f64_avx2, _minmax_f64_avx2},
+};
+
+#endif // HAVE_X86
+
+static bool _isa_supported(enum vector_isa isa)
+{
+    switch (isa) {
+    case VECTOR_ISA_AUTO:
+    case VECTOR_ISA_SCALAR:
+        return true;
+#ifdef HAVE_X86
+    case VECTOR_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case VECTOR_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif // HAVE_X86
+    default:
+        return false;
+    }
+}
+
+static const struct _kernels *_kernels(enum vector_type type)
+{
+    enum vector_isa isa = _isa;
+
+    if (isa == VECTOR_ISA_AUTO) {
+        isa = _isa_supported(VECTOR_ISA_AVX2) ? VECTOR_ISA_AVX2 :
+              _isa_supported(VECTOR_ISA_SSE2) ? VECTOR_ISA_SSE2 :
+              VECTOR_ISA_SCALAR;
+    }
+
+    switch (isa) {
+#ifdef HAVE_X86
+    case VECTOR_ISA_AVX2:
+        return &_avx2_kernels[type];
+    case VECTOR_ISA_SSE2:
+        return &_sse2_kernels[type];
+#endif // HAVE_X86
+    default:
+        return &_scalar_kernels[type];
+    }
+}
+
+static bool _check(struct vector *vec, enum vector_type type)
+{
+    return vec != NULL && (unsigned int) type <= VECTOR_DOUBLE &&
+           vector_element_size(vec) == _type_size[type];
+}
+
+int vector_scan_set_isa(enum vector_isa isa)
+{
+    if (!_isa_supported(isa))
+        return -ENOTSUP;
+
+    _isa = isa;
+
+    return 0;
+}
+
+ssize_t vector_find_eq(struct vector *vec, enum vector_type type,
+                       const void *key)
+{
+    if (!_check(vec, type) || key == NULL)
+        return -EINVAL;
+
+    return _kernels(type)->find(vector_data(vec), vector_size(vec), key);
+}
+
+ssize_t vector_count_eq(struct vector *vec, enum vector_type type,
+                        const void *key)
+{
+    if (!_check(vec, type) || key == NULL)
+        return -EINVAL;
+
+    return _kernels(type)->count(vector_data(vec), vector_size(vec), key);
+}
+
+int vector_minmax(struct vector *vec, enum vector_type type, void *min,
+                  void *max)
+{
+    if (!_check(vec, type) || vector_size(vec) == 0)
+        return -EINVAL;
+
+    // the kernels always write both values, as bytes since their type
+    // depends on the vector
+    unsigned char lo[sizeof(uint64_t)], hi[sizeof(uint64_t)];
+
+    _kernels(type)->minmax(vector_data(vec), vector_size(vec), lo, hi);
+
+    if (min != NULL)
+        memcpy(min, lo, _type_size[type]);
+    if (max != NULL)
+        memcpy(max, hi, _type_size[type]);
+
+    return 0;
+}
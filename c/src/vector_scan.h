@@ -0,0 +1,120 @@
+/**
+ * @file vector_scan.h
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __VECTOR_SCAN_H__
+#define __VECTOR_SCAN_H__
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Types of the elements the scan kernels can operate on. */
+enum vector_type {
+    VECTOR_INT8,
+    VECTOR_UINT8,
+    VECTOR_INT16,
+    VECTOR_UINT16,
+    VECTOR_INT32,
+    VECTOR_UINT32,
+    VECTOR_INT64,
+    VECTOR_UINT64,
+    VECTOR_FLOAT,
+    VECTOR_DOUBLE,
+};
+
+/** Instruction sets the scan kernels can be implemented with. */
+enum vector_isa {
+    VECTOR_ISA_AUTO,    //!< the best one supported by the CPU
+    VECTOR_ISA_SCALAR,
+    VECTOR_ISA_SSE2,
+    VECTOR_ISA_AVX2,
+};
+
+/** Forces the scan kernels to use a given instruction set.
+ *
+ * By default the kernels are chosen at runtime based on the features of the
+ * CPU. This function is meant for testing and benchmarking, it's not
+ * thread-safe.
+ *
+ * @param[in] isa the instruction set to use
+ *
+ * @return 0 upon success and negative error code if the CPU doesn't support
+ *         the instruction set
+ */
+int vector_scan_set_isa(enum vector_isa isa);
+
+/** Finds the first element equal to a given key.
+ *
+ * The element size of the vector has to match the size of @c type. Floating
+ * point elements are compared with @c ==, so NaN never matches.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] type type of the vector's elements
+ * @param[in] key pointer to the key of type @c type
+ *
+ * @return index of the element, -1 if there is no such element or negative
+ *         error code if the arguments are invalid
+ */
+ssize_t vector_find_eq(struct vector *vector, enum vector_type type,
+                       const void *key);
+
+/** Counts the elements equal to a given key.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] type type of the vector's elements
+ * @param[in] key pointer to the key of type @c type
+ *
+ * @return number of the elements or negative error code
+ */
+ssize_t vector_count_eq(struct vector *vector, enum vector_type type,
+                        const void *key);
+
+/** Finds the minimum and the maximum element of the vector.
+ *
+ * If the vector holds floating point NaNs the result is unspecified.
+ *
+ * @param[in] vector pointer to the vector object
+ * @param[in] type type of the vector's elements
+ * @param[out] min pointer to the minimum of type @c type, may be NULL
+ * @param[out] max pointer to the maximum of type @c type, may be NULL
+ *
+ * @return 0 upon success and negative error code otherwise, also if the
+ *         vector is empty
+ */
+int vector_minmax(struct vector *vector, enum vector_type type, void *min,
+                  void *max);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __VECTOR_SCAN_H__
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <errno.h>
 #include <cmocka.h>
 #include <binary_search.h>
 
@@ -433,6 +434,380 @@ static void bsr_search_int_repeating_middle_returns_success(void **state)
     assert_int_equal(9, ret);
 }
 
+static ssize_t compare_i64(const void *x1, const void *x2)
+{
+    int64_t a = *(int64_t *) x1, b = *(int64_t *) x2;
+    return (a > b) - (a < b);
+}
+
+static void typed_null_or_empty_array_returns_error(void **state)
+{
+    (void) state;
+    int32_t a[] = {1, 2, 3};
+
+    assert_int_equal(-1, binary_search_leftmost_i32(NULL, 3, 1));
+    assert_int_equal(-1, binary_search_rightmost_i32(NULL, 3, 1));
+    assert_int_equal(-1, binary_search_leftmost_i32(a, 0, 1));
+    assert_int_equal(-1, binary_search_rightmost_i32(a, 0, 1));
+    assert_int_equal(-1, binary_search_leftmost_i32(a, (size_t) SSIZE_MAX + 1,
+                                                    1));
+}
+
+static void typed_search_int32_repeating(void **state)
+{
+    (void) state;
+    int32_t a[] = {INT32_MIN, -5, -5, 0, 3, 3, 3, 3, 8, INT32_MAX};
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    assert_int_equal(0, binary_search_leftmost_i32(a, n, INT32_MIN));
+    assert_int_equal(1, binary_search_leftmost_i32(a, n, -5));
+    assert_int_equal(2, binary_search_rightmost_i32(a, n, -5));
+    assert_int_equal(4, binary_search_leftmost_i32(a, n, 3));
+    assert_int_equal(7, binary_search_rightmost_i32(a, n, 3));
+    assert_int_equal(9, binary_search_rightmost_i32(a, n, INT32_MAX));
+    assert_int_equal(-1, binary_search_leftmost_i32(a, n, 4));
+    assert_int_equal(-1, binary_search_rightmost_i32(a, n, -6));
+    assert_int_equal(0, binary_search_leftmost_i32(a, 1, INT32_MIN));
+    assert_int_equal(-1, binary_search_rightmost_i32(a, 1, 0));
+}
+
+static void typed_search_unsigned_and_double(void **state)
+{
+    (void) state;
+    uint64_t u[] = {0, 1, 1, UINT64_MAX - 1, UINT64_MAX, UINT64_MAX};
+    double d[] = {-1e300, -0.5, 0.0, 0.0, 2.5, 1e300};
+
+    assert_int_equal(1, binary_search_leftmost_u64(u, 6, 1));
+    assert_int_equal(2, binary_search_rightmost_u64(u, 6, 1));
+    assert_int_equal(4, binary_search_leftmost_u64(u, 6, UINT64_MAX));
+    assert_int_equal(5, binary_search_rightmost_u64(u, 6, UINT64_MAX));
+    assert_int_equal(-1, binary_search_leftmost_u64(u, 6, 2));
+
+    assert_int_equal(0, binary_search_leftmost_f64(d, 6, -1e300));
+    assert_int_equal(2, binary_search_leftmost_f64(d, 6, -0.0));
+    assert_int_equal(3, binary_search_rightmost_f64(d, 6, 0.0));
+    assert_int_equal(-1, binary_search_leftmost_f64(d, 6, 1.0));
+    assert_int_equal(-1, binary_search_rightmost_f64(d, 6, 0.0 / 0.0));
+}
+
+static void typed_search_matches_generic(void **state)
+{
+    (void) state;
+    static int64_t a[5000];
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    srand(time(NULL));
+    a[0] = -100;
+    for (size_t i = 1; i < n; i++)
+        a[i] = a[i - 1] + rand() % 3;
+
+    for (size_t size = 1; size <= n; size += size / 7 + 1) {
+        for (int64_t search = a[0] - 1; search <= a[size - 1] + 1; search++) {
+            assert_int_equal(
+                binary_search_leftmost(a, size, sizeof(a[0]), compare_i64,
+                                       &search),
+                binary_search_leftmost_i64(a, size, search));
+            assert_int_equal(
+                binary_search_rightmost(a, size, sizeof(a[0]), compare_i64,
+                                        &search),
+                binary_search_rightmost_i64(a, size, search));
+        }
+    }
+}
+
+static void batch_invalid_arguments_returns_error(void **state)
+{
+    (void) state;
+    int a[] = {1, 2, 3};
+    int keys[] = {2};
+    ssize_t out[1];
+
+    assert_int_equal(-EINVAL, binary_search_batch(NULL, 3, sizeof(int),
+                                                  compare_int, keys, 1, out));
+    assert_int_equal(-EINVAL, binary_search_batch(a, 3, sizeof(int), NULL,
+                                                  keys, 1, out));
+    assert_int_equal(-EINVAL, binary_search_batch(a, 3, sizeof(int),
+                                                  compare_int, keys, 1, NULL));
+    assert_int_equal(-EINVAL, binary_search_batch_i32(NULL, 3, keys, 1, out));
+    assert_int_equal(0, binary_search_batch_i32((int32_t *) a, 3, NULL, 0,
+                                                NULL));
+
+    out[0] = 0;
+    assert_int_equal(0, binary_search_batch(a, 0, sizeof(int), compare_int,
+                                            keys, 1, out));
+    assert_int_equal(-1, out[0]);
+}
+
+static void batch_matches_single_searches(void **state)
+{
+    (void) state;
+    static int64_t a[3000];
+    static int64_t keys[1000];
+    static ssize_t out[1000];
+    size_t n = sizeof(a) / sizeof(a[0]);
+    size_t m = sizeof(keys) / sizeof(keys[0]);
+
+    srand(time(NULL));
+    a[0] = 0;
+    for (size_t i = 1; i < n; i++)
+        a[i] = a[i - 1] + rand() % 3;
+    for (size_t i = 0; i < m; i++)
+        keys[i] = rand() % (a[n - 1] + 2) - 1;
+
+    for (size_t size = 1; size <= n; size += size / 3 + 1) {
+        for (size_t count = 0; count <= m; count += count / 2 + 7) {
+            assert_int_equal(0, binary_search_batch(a, size, sizeof(a[0]),
+                                                    compare_i64, keys, count,
+                                                    out));
+            for (size_t i = 0; i < count; i++)
+                assert_int_equal(binary_search_leftmost_i64(a, size, keys[i]),
+                                 out[i]);
+
+            assert_int_equal(0, binary_search_batch_i64(a, size, keys, count,
+                                                        out));
+            for (size_t i = 0; i < count; i++)
+                assert_int_equal(binary_search_leftmost_i64(a, size, keys[i]),
+                                 out[i]);
+        }
+    }
+}
+
+static void gallop_from_any_hint_matches_binary_search(void **state)
+{
+    (void) state;
+    int a[200];
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    a[0] = 0;
+    for (size_t i = 1; i < n; i++)
+        a[i] = a[i - 1] + rand() % 3;
+
+    for (size_t size = 1; size <= n; size += 13) {
+        for (int search = -1; search <= a[size - 1] + 1; search++) {
+            ssize_t left = binary_search_leftmost(a, size, sizeof(int),
+                                                  compare_int, &search);
+            ssize_t right = binary_search_rightmost(a, size, sizeof(int),
+                                                    compare_int, &search);
+
+            for (size_t hint = 0; hint <= size + 1; hint += 3) {
+                assert_int_equal(left, binary_search_gallop_leftmost(
+                    a, size, sizeof(int), compare_int, &search, hint));
+                assert_int_equal(right, binary_search_gallop_rightmost(
+                    a, size, sizeof(int), compare_int, &search, hint));
+            }
+        }
+    }
+
+    int search = 1;
+    assert_int_equal(-1, binary_search_gallop_leftmost(a, 0, sizeof(int),
+                                                       compare_int, &search,
+                                                       0));
+    assert_int_equal(-1, binary_search_gallop_rightmost(NULL, n, sizeof(int),
+                                                        compare_int, &search,
+                                                        0));
+}
+
+static void interpolation_matches_binary_search(void **state)
+{
+    (void) state;
+    static int64_t a[5000];
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    // uniform steps with a cluster of duplicates and a far outlier
+    for (size_t i = 0; i < n; i++)
+        a[i] = i < 1000 ? (int64_t) i * 10 : i < 1500 ? 10000 :
+               (int64_t) i * 10 + rand() % 10;
+    a[n - 1] = INT64_MAX;
+    a[0] = INT64_MIN;
+
+    for (size_t size = 1; size <= n; size += size / 3 + 1) {
+        for (size_t i = 0; i < size; i++) {
+            for (int64_t d = -1; d <= 1; d++) {
+                int64_t search = a[i] + (d < 0 && a[i] == INT64_MIN ? 0 :
+                                         d > 0 && a[i] == INT64_MAX ? 0 : d);
+                assert_int_equal(
+                    binary_search_leftmost_i64(a, size, search),
+                    binary_search_interpolation_leftmost_i64(a, size, search));
+                assert_int_equal(
+                    binary_search_rightmost_i64(a, size, search),
+                    binary_search_interpolation_rightmost_i64(a, size,
+                                                              search));
+            }
+        }
+    }
+}
+
+static void interpolation_typed_variants(void **state)
+{
+    (void) state;
+    int32_t i[] = {INT32_MIN, -3, 0, 0, 7, INT32_MAX};
+    uint64_t u[] = {0, 5, 5, 5, UINT64_MAX};
+    double d[] = {-1.0 / 0.0, -2.5, 0.0, 1e10, 1.0 / 0.0};
+
+    assert_int_equal(2, binary_search_interpolation_leftmost_i32(i, 6, 0));
+    assert_int_equal(3, binary_search_interpolation_rightmost_i32(i, 6, 0));
+    assert_int_equal(5, binary_search_interpolation_leftmost_i32(i, 6,
+                                                                 INT32_MAX));
+    assert_int_equal(-1, binary_search_interpolation_leftmost_i32(i, 6, 1));
+
+    assert_int_equal(1, binary_search_interpolation_leftmost_u64(u, 5, 5));
+    assert_int_equal(3, binary_search_interpolation_rightmost_u64(u, 5, 5));
+    assert_int_equal(-1, binary_search_interpolation_rightmost_u64(u, 5, 6));
+
+    assert_int_equal(0, binary_search_interpolation_leftmost_f64(d, 5,
+                                                                 -1.0 / 0.0));
+    assert_int_equal(3, binary_search_interpolation_leftmost_f64(d, 5, 1e10));
+    assert_int_equal(4, binary_search_interpolation_rightmost_f64(d, 5,
+                                                                  1.0 / 0.0));
+    assert_int_equal(-1, binary_search_interpolation_leftmost_f64(d, 5,
+                                                                  0.0 / 0.0));
+    assert_int_equal(-1, binary_search_interpolation_leftmost_f64(NULL, 5,
+                                                                  0.0));
+}
+
+static void bounds_return_insertion_points(void **state)
+{
+    (void) state;
+    int a[] = {1, 3, 3, 3, 5, 8};
+    size_t n = sizeof(a) / sizeof(a[0]);
+    int search;
+
+    search = 3;
+    assert_int_equal(1, binary_search_lower_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    assert_int_equal(4, binary_search_upper_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    search = 4;
+    assert_int_equal(4, binary_search_lower_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    assert_int_equal(4, binary_search_upper_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    search = 0;
+    assert_int_equal(0, binary_search_lower_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    search = 9;
+    assert_int_equal(6, binary_search_upper_bound(a, n, sizeof(int),
+                                                  compare_int, &search));
+    assert_int_equal(0, binary_search_lower_bound(a, 0, sizeof(int),
+                                                  compare_int, &search));
+
+    assert_int_equal(-1, binary_search_lower_bound(NULL, n, sizeof(int),
+                                                   compare_int, &search));
+    assert_int_equal(-1, binary_search_upper_bound(a, n, 0, compare_int,
+                                                   &search));
+}
+
+static void equal_range_matches_bounds(void **state)
+{
+    (void) state;
+    int a[500];
+    size_t n = sizeof(a) / sizeof(a[0]);
+    size_t first, last;
+
+    a[0] = 0;
+    for (size_t i = 1; i < n; i++)
+        a[i] = a[i - 1] + rand() % 3;
+
+    for (size_t size = 0; size <= n; size += 7) {
+        for (int search = -1; search <= a[n - 1] + 1; search++) {
+            assert_int_equal(0, binary_search_equal_range(
+                a, size, sizeof(int), compare_int, &search, &first, &last));
+            assert_int_equal(binary_search_lower_bound(
+                a, size, sizeof(int), compare_int, &search), first);
+            assert_int_equal(binary_search_upper_bound(
+                a, size, sizeof(int), compare_int, &search), last);
+        }
+    }
+
+    int search = 1;
+    assert_int_equal(-EINVAL, binary_search_equal_range(
+        a, n, sizeof(int), compare_int, &search, NULL, &last));
+}
+
+static inline int compare_int_inline(const int *x1, const int *x2)
+{
+    return (*x1 > *x2) - (*x1 < *x2);
+}
+
+#define COMPARE_KEY(x1, x2) (((x1)->key > (x2)->key) - ((x1)->key < (x2)->key))
+
+BINARY_SEARCH_DEFINE(bs_int, int, compare_int_inline)
+BINARY_SEARCH_DEFINE(bs_struct, struct test, COMPARE_KEY)
+
+static void search_below_first_element_returns_error(void **state)
+{
+    (void) state;
+    int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    int search = 0;
+    int ret = binary_search(a, sizeof(a) / sizeof(a[0]), sizeof(a[0]),
+                            compare_int, &search);
+    assert_int_equal(-1, ret);
+    assert_int_equal(-1, bs_int(a, sizeof(a) / sizeof(a[0]), &search));
+}
+
+static void defined_invalid_arguments_returns_error(void **state)
+{
+    (void) state;
+    int a[] = {1, 2, 3};
+    int search = 1;
+
+    assert_int_equal(-1, bs_int(NULL, 3, &search));
+    assert_int_equal(-1, bs_int(a, 0, &search));
+    assert_int_equal(-1, bs_int(a, (size_t) SSIZE_MAX + 1, &search));
+    assert_int_equal(-1, bs_int_leftmost(a, 3, NULL));
+    assert_int_equal(-1, bs_int_rightmost(NULL, 3, &search));
+    assert_int_equal(0, bs_int_lower_bound(a, 0, &search));
+    assert_int_equal(-1, bs_int_upper_bound(NULL, 3, &search));
+}
+
+static void defined_search_matches_generic(void **state)
+{
+    (void) state;
+    int a[700];
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    a[0] = 0;
+    for (size_t i = 1; i < n; i++)
+        a[i] = a[i - 1] + rand() % 3;
+
+    for (size_t size = 1; size <= n; size += 11) {
+        for (int search = -1; search <= a[size - 1] + 1; search++) {
+            assert_int_equal(binary_search(a, size, sizeof(int), compare_int,
+                                           &search),
+                             bs_int(a, size, &search));
+            assert_int_equal(binary_search_leftmost(a, size, sizeof(int),
+                                                    compare_int, &search),
+                             bs_int_leftmost(a, size, &search));
+            assert_int_equal(binary_search_rightmost(a, size, sizeof(int),
+                                                     compare_int, &search),
+                             bs_int_rightmost(a, size, &search));
+            assert_int_equal(binary_search_lower_bound(a, size, sizeof(int),
+                                                       compare_int, &search),
+                             bs_int_lower_bound(a, size, &search));
+            assert_int_equal(binary_search_upper_bound(a, size, sizeof(int),
+                                                       compare_int, &search),
+                             bs_int_upper_bound(a, size, &search));
+        }
+    }
+}
+
+static void defined_search_struct(void **state)
+{
+    (void) state;
+    struct test a[] = {{8, 1}, {7, 2}, {6, 2}, {5, 2},
+                       {4, 5}, {3, 6}, {2, 7}, {1, 8}};
+    size_t n = sizeof(a) / sizeof(a[0]);
+    struct test search = {0, 2};
+
+    assert_int_equal(1, bs_struct_leftmost(a, n, &search));
+    assert_int_equal(3, bs_struct_rightmost(a, n, &search));
+    search.key = 8;
+    assert_int_equal(7, bs_struct(a, n, &search));
+    search.key = 3;
+    assert_int_equal(-1, bs_struct(a, n, &search));
+    assert_int_equal(4, bs_struct_lower_bound(a, n, &search));
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -479,6 +854,26 @@ int main(void)
         cmocka_unit_test(bsr_search_int_repeating_first_returns_success),
         cmocka_unit_test(bsr_search_int_repeating_last_returns_success),
         cmocka_unit_test(bsr_search_int_repeating_middle_returns_success),
+
+        cmocka_unit_test(typed_null_or_empty_array_returns_error),
+        cmocka_unit_test(typed_search_int32_repeating),
+        cmocka_unit_test(typed_search_unsigned_and_double),
+        cmocka_unit_test(typed_search_matches_generic),
+
+        cmocka_unit_test(batch_invalid_arguments_returns_error),
+        cmocka_unit_test(batch_matches_single_searches),
+
+        cmocka_unit_test(gallop_from_any_hint_matches_binary_search),
+        cmocka_unit_test(interpolation_matches_binary_search),
+        cmocka_unit_test(interpolation_typed_variants),
+
+        cmocka_unit_test(bounds_return_insertion_points),
+        cmocka_unit_test(equal_range_matches_bounds),
+
+        cmocka_unit_test(search_below_first_element_returns_error),
+        cmocka_unit_test(defined_invalid_arguments_returns_error),
+        cmocka_unit_test(defined_search_matches_generic),
+        cmocka_unit_test(defined_search_struct),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
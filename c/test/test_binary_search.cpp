@@ -0,0 +1,83 @@
+/**
+ * @file test_binary_search.cpp
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "binary_search.h"
+
+namespace {
+
+ssize_t compare_int(const void *x1, const void *x2)
+{
+    return *(const int *) x1 - *(const int *) x2;
+}
+
+class BinarySearchTest : public ::testing::Test {
+public:
+    virtual ~BinarySearchTest() = default;
+
+protected:
+    virtual void SetUp() {
+        data_.push_back(0);
+        for (int i = 1; i < 500; ++i)
+            data_.push_back(data_.back() + rand() % 3);
+    }
+
+    std::vector<int> data_;
+};
+
+TEST_F(BinarySearchTest, InvalidArguments) {
+    int search = 1;
+
+    EXPECT_EQ(-1, binary_search(static_cast<const int *>(nullptr), 3, search));
+    EXPECT_EQ(-1, binary_search_leftmost(data_.data(), 0, search));
+    EXPECT_EQ(-1, binary_search_rightmost(data_.data(), 0, search));
+    EXPECT_EQ(0, binary_search_lower_bound(data_.data(), 0, search));
+}
+
+TEST_F(BinarySearchTest, MatchesGeneric) {
+    for (size_t size = 1; size <= data_.size(); size += 13) {
+        for (int search = -1; search <= data_[size - 1] + 1; ++search) {
+            EXPECT_EQ(binary_search(data_.data(), size, sizeof(int),
+                                    compare_int, &search),
+                      binary_search(data_.data(), size, search));
+            EXPECT_EQ(binary_search_leftmost(data_.data(), size, sizeof(int),
+                                             compare_int, &search),
+                      binary_search_leftmost(data_.data(), size, search));
+            EXPECT_EQ(binary_search_rightmost(data_.data(), size, sizeof(int),
+                                              compare_int, &search),
+                      binary_search_rightmost(data_.data(), size, search));
+            EXPECT_EQ(binary_search_lower_bound(data_.data(), size,
+                                                sizeof(int), compare_int,
+                                                &search),
+                      binary_search_lower_bound(data_.data(), size, search));
+            EXPECT_EQ(binary_search_upper_bound(data_.data(), size,
+                                                sizeof(int), compare_int,
+                                                &search),
+                      binary_search_upper_bound(data_.data(), size, search));
+        }
+    }
+}
+
+TEST_F(BinarySearchTest, CustomComparator) {
+    auto by_length = [](const std::string &a, const std::string &b) {
+        return (a.size() > b.size()) - (a.size() < b.size());
+    };
+    std::vector<std::string> sorted = {"Bob", "Dave", "alice", "carol"};
+
+    EXPECT_EQ(2, binary_search_leftmost(sorted.data(), sorted.size(),
+                                        std::string("12345"), by_length));
+    EXPECT_EQ(3, binary_search_rightmost(sorted.data(), sorted.size(),
+                                         std::string("12345"), by_length));
+    EXPECT_EQ(-1, binary_search(sorted.data(), sorted.size(),
+                                std::string("12"), by_length));
+    EXPECT_EQ(4, binary_search_upper_bound(sorted.data(), sorted.size(),
+                                           std::string("123456"), by_length));
+}
+
+} // namespace
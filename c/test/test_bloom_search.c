@@ -0,0 +1,185 @@
+/**
+ * @file test_bloom_search.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "binary_search.h"
+#include "bloom_search.h"
+
+#define __unused __attribute__((unused))
+
+#define KEY_COUNT 100000
+
+static int64_t keys[KEY_COUNT];
+
+static uint64_t hash_int64(const void *element)
+{
+    return (uint64_t) *(const int64_t *) element;
+}
+
+static ssize_t compare_int64(const void *x1, const void *x2)
+{
+    int64_t a = *(const int64_t *) x1, b = *(const int64_t *) x2;
+    return (a > b) - (a < b);
+}
+
+// even numbers, every tenth one repeated
+static void fill_keys(void)
+{
+    int64_t value = 0;
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        keys[i] = value;
+        if (i % 10 != 0)
+            value += 2;
+    }
+}
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    errno = 0;
+    assert_null(bloom_search_create(NULL, 10, sizeof(int64_t), hash_int64,
+                                    0));
+    assert_int_equal(EINVAL, errno);
+    assert_null(bloom_search_create(keys, 0, sizeof(int64_t), hash_int64, 0));
+    assert_null(bloom_search_create(keys, 10, 0, hash_int64, 0));
+    assert_null(bloom_search_create(keys, 10, sizeof(int64_t), NULL, 0));
+
+    int64_t key = 0;
+    struct bloom_search_stats stats;
+    assert_false(bloom_search_may_contain(NULL, &key));
+    assert_int_equal(-1, bloom_search_leftmost(NULL, compare_int64, &key));
+    assert_int_equal(-EINVAL, bloom_search_stats(NULL, &stats));
+
+    bloom_search_destroy(NULL);
+}
+
+static void results_match_binary_search(__unused void **state)
+{
+    struct bloom_search *bs = bloom_search_create(keys, KEY_COUNT,
+                                                  sizeof(int64_t),
+                                                  hash_int64, 0);
+    assert_non_null(bs);
+
+    for (int64_t key = -1; key <= keys[KEY_COUNT - 1] + 1; key++) {
+        assert_int_equal(binary_search_leftmost(keys, KEY_COUNT,
+                                                sizeof(int64_t),
+                                                compare_int64, &key),
+                         bloom_search_leftmost(bs, compare_int64, &key));
+        assert_int_equal(binary_search_rightmost(keys, KEY_COUNT,
+                                                 sizeof(int64_t),
+                                                 compare_int64, &key),
+                         bloom_search_rightmost(bs, compare_int64, &key));
+    }
+
+    bloom_search_destroy(bs);
+}
+
+static void reported_rate_matches_observed(__unused void **state)
+{
+    const size_t budgets[] = {0, KEY_COUNT / 2, KEY_COUNT * 2};
+
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+        struct bloom_search *bs = bloom_search_create(keys, KEY_COUNT,
+                                                      sizeof(int64_t),
+                                                      hash_int64,
+                                                      budgets[b]);
+        assert_non_null(bs);
+
+        struct bloom_search_stats stats;
+        assert_int_equal(0, bloom_search_stats(bs, &stats));
+        if (budgets[b] > 0)
+            assert_int_equal(budgets[b] / 64 * 64, stats.bytes);
+        assert_in_range(stats.hashes, 1, 16);
+
+        // odd numbers are all missing
+        size_t passed = 0, tried = 0;
+        for (int64_t key = 1; key < 2000001; key += 2, tried++)
+            passed += bloom_search_may_contain(bs, &key);
+
+        double observed = (double) passed / (double) tried;
+        assert_true(observed < 2 * stats.fpr + 0.001);
+        assert_true(observed > stats.fpr / 2 - 0.001);
+
+        // every key present passes
+        for (size_t i = 0; i < KEY_COUNT; i++)
+            assert_true(bloom_search_may_contain(bs, &keys[i]));
+
+        bloom_search_destroy(bs);
+    }
+
+    struct bloom_search *bs = bloom_search_create(keys, KEY_COUNT,
+                                                  sizeof(int64_t),
+                                                  hash_int64, 0);
+    struct bloom_search_stats stats;
+    assert_int_equal(0, bloom_search_stats(bs, &stats));
+    assert_true(stats.fpr < 0.02);
+    bloom_search_destroy(bs);
+}
+
+static void tiny_budget_still_works(__unused void **state)
+{
+    struct bloom_search *bs = bloom_search_create(keys, KEY_COUNT,
+                                                  sizeof(int64_t),
+                                                  hash_int64, 1);
+    assert_non_null(bs);
+
+    struct bloom_search_stats stats;
+    assert_int_equal(0, bloom_search_stats(bs, &stats));
+    assert_int_equal(64, stats.bytes);
+    assert_int_equal(1, stats.hashes);
+    assert_true(stats.fpr > 0.99);
+
+    int64_t key = keys[KEY_COUNT / 2];
+    assert_int_equal(KEY_COUNT / 2, bloom_search_leftmost(bs, compare_int64,
+                                                          &key));
+
+    bloom_search_destroy(bs);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(results_match_binary_search),
+        cmocka_unit_test(reported_rate_matches_observed),
+        cmocka_unit_test(tiny_budget_still_works),
+    };
+
+    fill_keys();
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
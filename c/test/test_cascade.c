@@ -0,0 +1,229 @@
+/**
+ * @file test_cascade.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "binary_search.h"
+#include "cascade.h"
+
+#define __unused __attribute__((unused))
+
+#define ARRAY_COUNT 24
+#define ARRAY_SIZE 1000
+
+static int32_t storage[ARRAY_COUNT][ARRAY_SIZE];
+static const void *arrays[ARRAY_COUNT];
+static size_t sizes[ARRAY_COUNT];
+
+static ssize_t compare_i32(const void *x1, const void *x2)
+{
+    int32_t a = *(const int32_t *) x1, b = *(const int32_t *) x2;
+    return (a > b) - (a < b);
+}
+
+static int qsort_i32(const void *x1, const void *x2)
+{
+    return (int) compare_i32(x1, x2);
+}
+
+static void fill_random(size_t count, int32_t range)
+{
+    for (size_t i = 0; i < count; ++i) {
+        sizes[i] = (size_t) rand() % (ARRAY_SIZE + 1);
+        for (size_t j = 0; j < sizes[i]; ++j)
+            storage[i][j] = rand() % range;
+        qsort(storage[i], sizes[i], sizeof(int32_t), qsort_i32);
+        arrays[i] = storage[i];
+    }
+}
+
+static void check_against_binary_search(size_t count, int32_t from, int32_t to)
+{
+    struct cascade *cascade = cascade_create(arrays, sizes, count,
+                                             sizeof(int32_t), compare_i32);
+    assert_non_null(cascade);
+    assert_int_equal(count, cascade_count(cascade));
+
+    size_t bounds[ARRAY_COUNT];
+    ssize_t positions[ARRAY_COUNT];
+
+    for (int32_t key = from; key <= to; ++key) {
+        assert_int_equal(0, cascade_lower_bound(cascade, &key, bounds));
+        assert_int_equal(0, cascade_search_leftmost(cascade, &key,
+                                                    positions));
+
+        for (size_t i = 0; i < count; ++i) {
+            void *array = (void *) arrays[i];
+            assert_int_equal(binary_search_lower_bound(array, sizes[i],
+                                                       sizeof(int32_t),
+                                                       compare_i32, &key),
+                             bounds[i]);
+            assert_int_equal(binary_search_leftmost(array, sizes[i],
+                                                    sizeof(int32_t),
+                                                    compare_i32, &key),
+                             positions[i]);
+        }
+    }
+
+    cascade_destroy(cascade);
+}
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    sizes[0] = 1;
+    arrays[0] = NULL;
+
+    errno = 0;
+    assert_null(cascade_create(arrays, sizes, 1, sizeof(int32_t),
+                               compare_i32));
+    assert_int_equal(EINVAL, errno);
+
+    arrays[0] = storage[0];
+    assert_null(cascade_create(NULL, sizes, 1, sizeof(int32_t), compare_i32));
+    assert_null(cascade_create(arrays, NULL, 1, sizeof(int32_t),
+                               compare_i32));
+    assert_null(cascade_create(arrays, sizes, 0, sizeof(int32_t),
+                               compare_i32));
+    assert_null(cascade_create(arrays, sizes, 1, 0, compare_i32));
+    assert_null(cascade_create(arrays, sizes, 1, sizeof(int32_t), NULL));
+
+    int32_t key = 0;
+    size_t bounds[1];
+    ssize_t positions[1];
+    assert_int_equal(-EINVAL, cascade_lower_bound(NULL, &key, bounds));
+    assert_int_equal(-EINVAL, cascade_search_leftmost(NULL, &key, positions));
+    assert_int_equal(0, cascade_count(NULL));
+
+    cascade_destroy(NULL);
+}
+
+static void empty_arrays_are_skipped(__unused void **state)
+{
+    static const int32_t values[] = {1, 3, 3, 5};
+
+    arrays[0] = NULL;
+    sizes[0] = 0;
+    arrays[1] = values;
+    sizes[1] = 4;
+    arrays[2] = NULL;
+    sizes[2] = 0;
+
+    struct cascade *cascade = cascade_create(arrays, sizes, 3,
+                                             sizeof(int32_t), compare_i32);
+    assert_non_null(cascade);
+
+    int32_t key = 3;
+    ssize_t positions[3];
+    assert_int_equal(0, cascade_search_leftmost(cascade, &key, positions));
+    assert_int_equal(-1, positions[0]);
+    assert_int_equal(1, positions[1]);
+    assert_int_equal(-1, positions[2]);
+
+    cascade_destroy(cascade);
+
+    // binary_search_lower_bound() rejects NULL arrays even when empty
+    arrays[0] = storage[0];
+    arrays[2] = storage[2];
+    check_against_binary_search(3, -1, 6);
+}
+
+static void random_arrays_match_binary_search(__unused void **state)
+{
+    srand(time(NULL));
+
+    fill_random(ARRAY_COUNT, 100000);
+    check_against_binary_search(ARRAY_COUNT, -1, 100000);
+    check_against_binary_search(1, -1, 100000);
+}
+
+static void many_duplicates_match_binary_search(__unused void **state)
+{
+    fill_random(ARRAY_COUNT, 50);
+    check_against_binary_search(ARRAY_COUNT, -1, 50);
+    check_against_binary_search(2, -1, 50);
+}
+
+static ssize_t compare_long_double(const void *x1, const void *x2)
+{
+    // the copies in the catalog have to be aligned like the arrays
+    assert_int_equal(0, (uintptr_t) x2 % _Alignof(long double));
+
+    long double a = *(const long double *) x1, b = *(const long double *) x2;
+    return (a > b) - (a < b);
+}
+
+static void strictly_aligned_elements(__unused void **state)
+{
+    static long double values[3][100];
+    const void *ld_arrays[3];
+    size_t ld_sizes[3];
+
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 100; ++j)
+            values[i][j] = (long double) (j * (i + 2)) / 4;
+        ld_arrays[i] = values[i];
+        ld_sizes[i] = 100;
+    }
+
+    struct cascade *cascade = cascade_create(ld_arrays, ld_sizes, 3,
+                                             sizeof(long double),
+                                             compare_long_double);
+    assert_non_null(cascade);
+
+    ssize_t positions[3];
+    long double key = 12;
+    assert_int_equal(0, cascade_search_leftmost(cascade, &key, positions));
+    assert_int_equal(24, positions[0]);
+    assert_int_equal(16, positions[1]);
+    assert_int_equal(12, positions[2]);
+
+    cascade_destroy(cascade);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(empty_arrays_are_skipped),
+        cmocka_unit_test(random_arrays_match_binary_search),
+        cmocka_unit_test(many_duplicates_match_binary_search),
+        cmocka_unit_test(strictly_aligned_elements),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
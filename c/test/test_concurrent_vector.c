@@ -0,0 +1,195 @@
+/**
+ * @file test_concurrent_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <cmocka.h>
+
+#include "concurrent_vector.h"
+
+#define __unused __attribute__((unused))
+
+#define THREADS 4
+#define ELEMENTS_PER_THREAD 50000
+
+struct element {
+    uint32_t thread;
+    uint32_t value;
+};
+
+struct context {
+    struct concurrent_vector *vector;
+    uint32_t thread;
+    int failed;
+};
+
+static int set_up(void **state)
+{
+    *state = concurrent_vector_create(4, sizeof(struct element));
+    if (*state == NULL)
+        return -1;
+    return 0;
+}
+
+static int tear_down(void **state)
+{
+    concurrent_vector_destroy(*state);
+    return 0;
+}
+
+static void create_with_zero_element_size(__unused void **state)
+{
+    assert_null(concurrent_vector_create(0, 0));
+}
+
+static void push_back_and_get(void **state)
+{
+    struct concurrent_vector *v = *state;
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        struct element e = {0, i};
+        assert_int_equal(i, concurrent_vector_push_back(v, &e));
+    }
+
+    assert_int_equal(1000, concurrent_vector_size(v));
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        struct element *e = concurrent_vector_get(v, i);
+        assert_non_null(e);
+        assert_int_equal(i, e->value);
+    }
+
+    errno = 0;
+    assert_null(concurrent_vector_get(v, 1000));
+    assert_int_equal(EINVAL, errno);
+}
+
+static void elements_never_move(void **state)
+{
+    struct concurrent_vector *v = *state;
+    struct element e = {0, 0};
+
+    concurrent_vector_push_back(v, &e);
+    struct element *first = concurrent_vector_get(v, 0);
+
+    for (uint32_t i = 1; i < 10000; i++) {
+        e.value = i;
+        concurrent_vector_push_back(v, &e);
+    }
+
+    assert_ptr_equal(first, concurrent_vector_get(v, 0));
+    assert_int_equal(0, first->value);
+}
+
+static void *writer(void *arg)
+{
+    struct context *ctx = arg;
+
+    for (uint32_t i = 0; i < ELEMENTS_PER_THREAD; i++) {
+        struct element e = {ctx->thread, i};
+        if (concurrent_vector_push_back(ctx->vector, &e) < 0)
+            ctx->failed = 1;
+    }
+
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    struct context *ctx = arg;
+    size_t total = THREADS * ELEMENTS_PER_THREAD;
+    size_t seen = 0;
+
+    // every published element must be consistent
+    while (seen < total) {
+        size_t size = concurrent_vector_size(ctx->vector);
+        for (size_t i = seen; i < size; i++) {
+            struct element *e = concurrent_vector_get(ctx->vector, i);
+            if (e == NULL)
+                break;
+            if (e->thread >= THREADS || e->value >= ELEMENTS_PER_THREAD)
+                ctx->failed = 1;
+            seen = i + 1;
+        }
+    }
+
+    return NULL;
+}
+
+static void concurrent_push_back(void **state)
+{
+    struct concurrent_vector *v = *state;
+    pthread_t threads[THREADS + 1];
+    struct context ctx[THREADS + 1];
+
+    for (uint32_t i = 0; i <= THREADS; i++) {
+        ctx[i].vector = v;
+        ctx[i].thread = i;
+        ctx[i].failed = 0;
+        pthread_create(&threads[i], NULL, i < THREADS ? writer : reader,
+                       &ctx[i]);
+    }
+
+    for (uint32_t i = 0; i <= THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        assert_int_equal(0, ctx[i].failed);
+    }
+
+    assert_int_equal(THREADS * ELEMENTS_PER_THREAD, concurrent_vector_size(v));
+
+    // every thread's elements are all there and in the order of pushing
+    uint32_t next[THREADS] = {0};
+    for (size_t i = 0; i < concurrent_vector_size(v); i++) {
+        struct element *e = concurrent_vector_get(v, i);
+        assert_non_null(e);
+        assert_int_equal(next[e->thread], e->value);
+        next[e->thread] += 1;
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_zero_element_size),
+        cmocka_unit_test_setup_teardown(push_back_and_get,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(elements_never_move,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(concurrent_push_back,
+                                        set_up, tear_down),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
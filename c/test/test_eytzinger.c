@@ -0,0 +1,209 @@
+/**
+ * @file test_eytzinger.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "eytzinger.h"
+
+#define __unused __attribute__((unused))
+
+static ssize_t compare_int(const void *x1, const void *x2)
+{
+    return *(int *) x1 - *(int *) x2;
+}
+
+struct record {
+    int64_t key;
+    char payload[120];
+};
+
+static ssize_t compare_record(const void *x1, const void *x2)
+{
+    const struct record *r1 = x1, *r2 = x2;
+    return (r1->key > r2->key) - (r1->key < r2->key);
+}
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    int a[] = {1, 2, 3};
+
+    errno = 0;
+    assert_null(eytzinger_create(NULL, 3, sizeof(int)));
+    assert_int_equal(EINVAL, errno);
+    assert_null(eytzinger_create(a, 0, sizeof(int)));
+    assert_null(eytzinger_create(a, 3, 0));
+    assert_null(eytzinger_create(a, (size_t) SSIZE_MAX + 1, sizeof(int)));
+}
+
+static void get_returns_elements_in_sorted_order(__unused void **state)
+{
+    int a[100];
+    for (int i = 0; i < 100; ++i)
+        a[i] = i * 3;
+
+    struct eytzinger *e = eytzinger_create(a, 100, sizeof(int));
+    assert_non_null(e);
+    assert_int_equal(100, eytzinger_size(e));
+
+    for (int i = 0; i < 100; ++i)
+        assert_int_equal(a[i], *(int *) eytzinger_get(e, i));
+
+    errno = 0;
+    assert_null(eytzinger_get(e, 100));
+    assert_int_equal(EINVAL, errno);
+
+    eytzinger_destroy(e);
+}
+
+static void get_matches_source_for_every_shape(__unused void **state)
+{
+    int a[600];
+    for (int i = 0; i < 600; ++i)
+        a[i] = i;
+
+    // perfect trees, trees with a single node on the last level and
+    // everything in between
+    for (size_t size = 1; size <= 600; ++size) {
+        struct eytzinger *e = eytzinger_create(a, size, sizeof(int));
+        assert_non_null(e);
+
+        for (int i = 0; i < (int) size; ++i) {
+            assert_int_equal(i, *(int *) eytzinger_get(e, i));
+            assert_int_equal(i, eytzinger_search_leftmost(e, compare_int,
+                                                          &a[i]));
+        }
+
+        eytzinger_destroy(e);
+    }
+}
+
+static void search_returns_original_index(__unused void **state)
+{
+    int a[] = {1, 3, 3, 3, 5, 8, 8, 13};
+    struct eytzinger *e = eytzinger_create(a, 8, sizeof(int));
+    assert_non_null(e);
+
+    int search = 3;
+    assert_int_equal(1, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(3, eytzinger_search_rightmost(e, compare_int, &search));
+    search = 1;
+    assert_int_equal(0, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(0, eytzinger_search_rightmost(e, compare_int, &search));
+    search = 13;
+    assert_int_equal(7, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(7, eytzinger_search_rightmost(e, compare_int, &search));
+
+    search = 0;
+    assert_int_equal(-1, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(-1, eytzinger_search_rightmost(e, compare_int, &search));
+    search = 4;
+    assert_int_equal(-1, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(-1, eytzinger_search_rightmost(e, compare_int, &search));
+    search = 14;
+    assert_int_equal(-1, eytzinger_search_leftmost(e, compare_int, &search));
+    assert_int_equal(-1, eytzinger_search_rightmost(e, compare_int, &search));
+
+    assert_int_equal(-1, eytzinger_search_leftmost(e, NULL, &search));
+    assert_int_equal(-1, eytzinger_search_rightmost(e, compare_int, NULL));
+
+    eytzinger_destroy(e);
+}
+
+static void search_matches_binary_search(__unused void **state)
+{
+    static int a[3000];
+
+    srand(time(NULL));
+    a[0] = 0;
+    for (size_t i = 1; i < 3000; ++i)
+        a[i] = a[i - 1] + rand() % 3;
+
+    for (size_t size = 1; size <= 3000; size += size / 5 + 1) {
+        struct eytzinger *e = eytzinger_create(a, size, sizeof(int));
+        assert_non_null(e);
+
+        for (int search = -1; search <= a[size - 1] + 1; ++search) {
+            assert_int_equal(
+                binary_search_leftmost(a, size, sizeof(int), compare_int,
+                                       &search),
+                eytzinger_search_leftmost(e, compare_int, &search));
+            assert_int_equal(
+                binary_search_rightmost(a, size, sizeof(int), compare_int,
+                                        &search),
+                eytzinger_search_rightmost(e, compare_int, &search));
+        }
+
+        eytzinger_destroy(e);
+    }
+}
+
+static void search_large_elements(__unused void **state)
+{
+    struct record a[257];
+    for (int i = 0; i < 257; ++i) {
+        a[i].key = (i / 2) * 10;
+        snprintf(a[i].payload, sizeof(a[i].payload), "record %d", i);
+    }
+
+    struct eytzinger *e = eytzinger_create(a, 257, sizeof(a[0]));
+    assert_non_null(e);
+
+    struct record search = { .key = 50 };
+    ssize_t idx = eytzinger_search_leftmost(e, compare_record, &search);
+    assert_int_equal(10, idx);
+    assert_string_equal("record 10",
+                        ((struct record *) eytzinger_get(e, idx))->payload);
+    assert_int_equal(11, eytzinger_search_rightmost(e, compare_record,
+                                                    &search));
+
+    eytzinger_destroy(e);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(get_returns_elements_in_sorted_order),
+        cmocka_unit_test(get_matches_source_for_every_shape),
+        cmocka_unit_test(search_returns_original_index),
+        cmocka_unit_test(search_matches_binary_search),
+        cmocka_unit_test(search_large_elements),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
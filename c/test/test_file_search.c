@@ -0,0 +1,187 @@
+/**
+ * @file test_file_search.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include "file_search.h"
+
+#define __unused __attribute__((unused))
+
+#define HEADER_SIZE 16
+#define RECORD_COUNT 20000
+
+struct record {
+    uint64_t key;
+    char payload[28];
+};
+
+static struct record records[RECORD_COUNT];
+
+static ssize_t compare_record(const void *x1, const void *x2)
+{
+    const struct record *r1 = x1, *r2 = x2;
+    return (r1->key > r2->key) - (r1->key < r2->key);
+}
+
+static void file_path(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/test_file_search_%d.bin", (int) getpid());
+}
+
+static int set_up(void **state)
+{
+    static char path[64];
+    file_path(path, sizeof(path));
+
+    srand(time(NULL));
+    records[0].key = 10;
+    for (size_t i = 0; i < RECORD_COUNT; ++i) {
+        if (i > 0)
+            records[i].key = records[i - 1].key + rand() % 3;
+        snprintf(records[i].payload, sizeof(records[i].payload), "%zu", i);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return -1;
+
+    char header[HEADER_SIZE] = "RECORDS";
+    if (fwrite(header, sizeof(header), 1, f) != 1 ||
+            fwrite(records, sizeof(records), 1, f) != 1) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    *state = path;
+
+    return 0;
+}
+
+static int tear_down(void **state)
+{
+    unlink(*state);
+    return 0;
+}
+
+static void check_against_binary_search(const char *path, size_t step)
+{
+    struct file_search *fs = file_search_open(path, HEADER_SIZE,
+                                              sizeof(struct record), step);
+    assert_non_null(fs);
+    assert_int_equal(RECORD_COUNT, file_search_size(fs));
+
+    struct record key;
+    for (key.key = 0; key.key <= records[RECORD_COUNT - 1].key + 1;
+            ++key.key) {
+        assert_int_equal(
+            binary_search_leftmost(records, RECORD_COUNT, sizeof(key),
+                                   compare_record, &key),
+            file_search_leftmost(fs, compare_record, &key));
+        assert_int_equal(
+            binary_search_rightmost(records, RECORD_COUNT, sizeof(key),
+                                    compare_record, &key),
+            file_search_rightmost(fs, compare_record, &key));
+    }
+
+    file_search_close(fs);
+}
+
+static void open_invalid_file_returns_error(void **state)
+{
+    errno = 0;
+    assert_null(file_search_open(NULL, 0, 8, 0));
+    assert_int_equal(EINVAL, errno);
+
+    assert_null(file_search_open("/nonexistent/file", 0, 8, 0));
+    assert_int_equal(ENOENT, errno);
+
+    // the records don't divide the file
+    assert_null(file_search_open(*state, HEADER_SIZE + 1,
+                                 sizeof(struct record), 0));
+    assert_int_equal(EINVAL, errno);
+}
+
+static void get_returns_mapped_records(void **state)
+{
+    struct file_search *fs = file_search_open(*state, HEADER_SIZE,
+                                              sizeof(struct record), 0);
+    assert_non_null(fs);
+
+    const struct record *r = file_search_get(fs, 1234);
+    assert_non_null(r);
+    assert_int_equal(records[1234].key, r->key);
+    assert_string_equal("1234", r->payload);
+
+    errno = 0;
+    assert_null(file_search_get(fs, RECORD_COUNT));
+    assert_int_equal(EINVAL, errno);
+
+    file_search_close(fs);
+}
+
+static void search_without_sample(void **state)
+{
+    check_against_binary_search(*state, 0);
+}
+
+static void search_with_sample(void **state)
+{
+    check_against_binary_search(*state, 1);
+    check_against_binary_search(*state, 64);
+    check_against_binary_search(*state, 1000);
+    check_against_binary_search(*state, RECORD_COUNT + 1);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(open_invalid_file_returns_error,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(get_returns_mapped_records,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(search_without_sample,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(search_with_sample,
+                                        set_up, tear_down),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
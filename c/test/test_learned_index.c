@@ -0,0 +1,141 @@
+/**
+ * @file test_learned_index.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "binary_search.h"
+#include "learned_index.h"
+
+#define __unused __attribute__((unused))
+
+#define KEY_COUNT 100000
+
+static uint64_t keys[KEY_COUNT];
+
+static void check_against_binary_search(size_t count, size_t max_error)
+{
+    struct learned_index *index = learned_index_create(keys, count,
+                                                       max_error);
+    assert_non_null(index);
+
+    for (size_t i = 0; i < count; ++i) {
+        for (int d = -1; d <= 1; ++d) {
+            uint64_t key = keys[i] + d;
+            assert_int_equal(binary_search_leftmost_u64(keys, count, key),
+                             learned_index_search(index, key));
+        }
+    }
+
+    struct learned_index_stats stats;
+    assert_int_equal(0, learned_index_stats(index, &stats));
+    assert_in_range(stats.segments, 1, count);
+    assert_true(stats.max_error <= max_error + 1);
+
+    learned_index_destroy(index);
+}
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    errno = 0;
+    assert_null(learned_index_create(NULL, 10, 8));
+    assert_int_equal(EINVAL, errno);
+    assert_null(learned_index_create(keys, 0, 8));
+
+    assert_int_equal(-1, learned_index_search(NULL, 1));
+    assert_int_equal(-EINVAL, learned_index_stats(NULL, NULL));
+}
+
+static void linear_keys_need_one_segment(__unused void **state)
+{
+    for (size_t i = 0; i < KEY_COUNT; ++i)
+        keys[i] = 1000 + i * 7;
+
+    struct learned_index *index = learned_index_create(keys, KEY_COUNT, 0);
+    assert_non_null(index);
+
+    struct learned_index_stats stats;
+    assert_int_equal(0, learned_index_stats(index, &stats));
+    assert_int_equal(1, stats.segments);
+
+    assert_int_equal(0, learned_index_search(index, 1000));
+    assert_int_equal(KEY_COUNT - 1,
+                     learned_index_search(index, 1000 + (KEY_COUNT - 1) * 7));
+    assert_int_equal(-1, learned_index_search(index, 999));
+    assert_int_equal(-1, learned_index_search(index, 1001));
+    assert_int_equal(-1, learned_index_search(index, UINT64_MAX));
+
+    learned_index_destroy(index);
+}
+
+static void random_gaps_match_binary_search(__unused void **state)
+{
+    srand(time(NULL));
+
+    keys[0] = rand() % 100;
+    for (size_t i = 1; i < KEY_COUNT; ++i)
+        keys[i] = keys[i - 1] + 1 + (uint64_t) rand() % 1000;
+
+    check_against_binary_search(KEY_COUNT, 0);
+    check_against_binary_search(KEY_COUNT, 16);
+    check_against_binary_search(KEY_COUNT, 256);
+    check_against_binary_search(1, 4);
+}
+
+static void skewed_keys_with_duplicates(__unused void **state)
+{
+    // quadratic growth with runs of equal keys and a huge jump at the end
+    for (size_t i = 0; i < KEY_COUNT; ++i)
+        keys[i] = (uint64_t) (i / 4) * (i / 4);
+    keys[KEY_COUNT - 2] = UINT64_MAX - 1;
+    keys[KEY_COUNT - 1] = UINT64_MAX;
+
+    check_against_binary_search(KEY_COUNT, 0);
+    check_against_binary_search(KEY_COUNT, 32);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(linear_keys_need_one_segment),
+        cmocka_unit_test(random_gaps_match_binary_search),
+        cmocka_unit_test(skewed_keys_with_duplicates),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,248 @@
+/**
+ * @file test_merge.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "merge.h"
+#include "vector.h"
+
+#define __unused __attribute__((unused))
+
+#define RUN_COUNT 70
+#define RUN_SIZE 500
+
+// records are compared by key only, seq tells where a record came from
+struct record {
+    int32_t key;
+    int32_t seq;
+};
+
+static struct record storage[RUN_COUNT][RUN_SIZE];
+static struct merge_run runs[RUN_COUNT];
+
+static struct record expected[RUN_COUNT * RUN_SIZE];
+static struct record merged[RUN_COUNT * RUN_SIZE];
+static size_t merged_count;
+
+static ssize_t compare_key(const void *x1, const void *x2)
+{
+    int32_t a = ((const struct record *) x1)->key;
+    int32_t b = ((const struct record *) x2)->key;
+    return (a > b) - (a < b);
+}
+
+// orders equal keys by their run and position in it, as a stable merge does
+static int qsort_key_seq(const void *x1, const void *x2)
+{
+    const struct record *a = x1, *b = x2;
+    if (a->key != b->key)
+        return (a->key > b->key) - (a->key < b->key);
+    return (a->seq > b->seq) - (a->seq < b->seq);
+}
+
+static void fill_random(size_t count, int32_t range)
+{
+    for (size_t i = 0; i < count; ++i) {
+        runs[i].size = (size_t) rand() % (RUN_SIZE + 1);
+        for (size_t j = 0; j < runs[i].size; ++j)
+            storage[i][j].key = rand() % range;
+        qsort(storage[i], runs[i].size, sizeof(struct record), qsort_key_seq);
+        for (size_t j = 0; j < runs[i].size; ++j)
+            storage[i][j].seq = (int32_t) (i * RUN_SIZE + j);
+        runs[i].array = storage[i];
+    }
+}
+
+// the stable order of all the records, then only the first or the last one
+// of every group of equal keys
+static size_t fill_expected(size_t count, enum merge_dedup dedup)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        for (size_t j = 0; j < runs[i].size; ++j)
+            expected[total++] = storage[i][j];
+    qsort(expected, total, sizeof(struct record), qsort_key_seq);
+
+    if (dedup == MERGE_ALL)
+        return total;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < total; ++i) {
+        bool first = i == 0 || expected[i - 1].key != expected[i].key;
+        bool last = i + 1 == total || expected[i + 1].key != expected[i].key;
+        if ((dedup == MERGE_LEFTMOST && first) ||
+                (dedup == MERGE_RIGHTMOST && last))
+            expected[kept++] = expected[i];
+    }
+    return kept;
+}
+
+static int collect(const void *element, size_t run, void *arg)
+{
+    const struct record *record = element;
+    assert_int_equal(run, (size_t) record->seq / RUN_SIZE);
+    merged[merged_count++] = *record;
+    if (arg != NULL && merged_count == *(size_t *) arg)
+        return 1;
+    return 0;
+}
+
+static void check_merge(size_t count, enum merge_dedup dedup)
+{
+    size_t total = fill_expected(count, dedup);
+
+    merged_count = 0;
+    assert_int_equal(0, merge_runs(runs, count, sizeof(struct record),
+                                   compare_key, dedup, collect, NULL));
+    assert_int_equal(total, merged_count);
+    assert_memory_equal(expected, merged, total * sizeof(struct record));
+
+    struct vector *vector = vector_create(0, sizeof(struct record));
+    assert_non_null(vector);
+    assert_int_equal(0, merge_runs_vector(vector, runs, count, compare_key,
+                                          dedup));
+    assert_int_equal(total, vector_size(vector));
+    if (total > 0)
+        assert_memory_equal(expected, vector_data(vector),
+                            total * sizeof(struct record));
+    vector_destroy(vector);
+}
+
+static void merge_with_invalid_arguments_returns_error(__unused void **state)
+{
+    runs[0].array = NULL;
+    runs[0].size = 1;
+    assert_int_equal(-EINVAL, merge_runs(runs, 1, sizeof(struct record),
+                                         compare_key, MERGE_ALL, collect,
+                                         NULL));
+
+    runs[0].array = storage[0];
+    assert_int_equal(-EINVAL, merge_runs(NULL, 1, sizeof(struct record),
+                                         compare_key, MERGE_ALL, collect,
+                                         NULL));
+    assert_int_equal(-EINVAL, merge_runs(runs, 1, 0, compare_key, MERGE_ALL,
+                                         collect, NULL));
+    assert_int_equal(-EINVAL, merge_runs(runs, 1, sizeof(struct record),
+                                         NULL, MERGE_ALL, collect, NULL));
+    assert_int_equal(-EINVAL, merge_runs(runs, 1, sizeof(struct record),
+                                         compare_key, MERGE_ALL, NULL,
+                                         NULL));
+    assert_int_equal(-EINVAL, merge_runs(runs, 1, sizeof(struct record),
+                                         compare_key, MERGE_RIGHTMOST + 1,
+                                         collect, NULL));
+    assert_int_equal(-EINVAL, merge_runs_vector(NULL, runs, 1, compare_key,
+                                                MERGE_ALL));
+}
+
+static void empty_runs_are_skipped(__unused void **state)
+{
+    merged_count = 0;
+    assert_int_equal(0, merge_runs(NULL, 0, sizeof(struct record),
+                                   compare_key, MERGE_ALL, collect, NULL));
+    assert_int_equal(0, merged_count);
+
+    for (size_t i = 0; i < 5; ++i) {
+        runs[i].array = i % 2 == 0 ? NULL : storage[i];
+        runs[i].size = 0;
+    }
+    runs[3].size = 2;
+    storage[3][0] = (struct record) {1, 3 * RUN_SIZE};
+    storage[3][1] = (struct record) {2, 3 * RUN_SIZE + 1};
+
+    check_merge(5, MERGE_ALL);
+    check_merge(5, MERGE_LEFTMOST);
+    check_merge(5, MERGE_RIGHTMOST);
+
+    runs[3].size = 0;
+    check_merge(5, MERGE_ALL);
+}
+
+static void random_runs_are_merged_stably(__unused void **state)
+{
+    srand(time(NULL));
+
+    fill_random(RUN_COUNT, 100000);
+    check_merge(RUN_COUNT, MERGE_ALL);
+    check_merge(37, MERGE_ALL);
+    check_merge(2, MERGE_ALL);
+    check_merge(1, MERGE_ALL);
+
+    fill_random(RUN_COUNT, 50);
+    check_merge(RUN_COUNT, MERGE_ALL);
+    check_merge(3, MERGE_ALL);
+}
+
+static void duplicates_are_removed(__unused void **state)
+{
+    fill_random(RUN_COUNT, 1000);
+    check_merge(RUN_COUNT, MERGE_LEFTMOST);
+    check_merge(RUN_COUNT, MERGE_RIGHTMOST);
+
+    fill_random(RUN_COUNT, 20);
+    check_merge(RUN_COUNT, MERGE_LEFTMOST);
+    check_merge(RUN_COUNT, MERGE_RIGHTMOST);
+    check_merge(1, MERGE_LEFTMOST);
+    check_merge(1, MERGE_RIGHTMOST);
+}
+
+static void emit_stops_the_merge(__unused void **state)
+{
+    fill_random(RUN_COUNT, 1000);
+    size_t total = fill_expected(RUN_COUNT, MERGE_ALL);
+    size_t stop = total / 2;
+
+    merged_count = 0;
+    assert_int_equal(1, merge_runs(runs, RUN_COUNT, sizeof(struct record),
+                                   compare_key, MERGE_ALL, collect, &stop));
+    assert_int_equal(stop, merged_count);
+    assert_memory_equal(expected, merged, stop * sizeof(struct record));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(merge_with_invalid_arguments_returns_error),
+        cmocka_unit_test(empty_runs_are_skipped),
+        cmocka_unit_test(random_runs_are_merged_stably),
+        cmocka_unit_test(duplicates_are_removed),
+        cmocka_unit_test(emit_stops_the_merge),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
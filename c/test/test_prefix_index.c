@@ -0,0 +1,190 @@
+/**
+ * @file test_prefix_index.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "binary_search.h"
+#include "prefix_index.h"
+
+#define __unused __attribute__((unused))
+
+#define STRING_COUNT 3000
+
+static char storage[STRING_COUNT][32];
+static const char *strings[STRING_COUNT];
+
+static const void *string_key(const void *element, size_t *size)
+{
+    const char *string = *(const char * const *) element;
+    *size = strlen(string);
+    return string;
+}
+
+static ssize_t compare_strings(const void *s1, const void *s2)
+{
+    return strcmp(*(const char * const *) s1, *(const char * const *) s2);
+}
+
+static int qsort_strings(const void *s1, const void *s2)
+{
+    return (int) compare_strings(s1, s2);
+}
+
+static void check_against_binary_search(size_t count)
+{
+    struct prefix_index *index = prefix_index_create(strings, count,
+                                                     sizeof(*strings),
+                                                     string_key);
+    assert_non_null(index);
+
+    for (size_t i = 0; i < count; ++i) {
+        char missing[40];
+        snprintf(missing, sizeof(missing), "%s!", strings[i]);
+
+        const char *search[] = {strings[i], missing};
+        for (size_t s = 0; s < 2; ++s) {
+            assert_int_equal(binary_search_leftmost(strings, count,
+                                                    sizeof(*strings),
+                                                    compare_strings,
+                                                    &search[s]),
+                             prefix_index_leftmost(index, compare_strings,
+                                                   &search[s]));
+            assert_int_equal(binary_search_rightmost(strings, count,
+                                                     sizeof(*strings),
+                                                     compare_strings,
+                                                     &search[s]),
+                             prefix_index_rightmost(index, compare_strings,
+                                                    &search[s]));
+        }
+    }
+
+    prefix_index_destroy(index);
+}
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    errno = 0;
+    assert_null(prefix_index_create(NULL, 10, sizeof(*strings), string_key));
+    assert_int_equal(EINVAL, errno);
+    assert_null(prefix_index_create(strings, 0, sizeof(*strings),
+                                    string_key));
+    assert_null(prefix_index_create(strings, 10, 0, string_key));
+    assert_null(prefix_index_create(strings, 10, sizeof(*strings), NULL));
+
+    const char *search = "";
+    assert_int_equal(-1, prefix_index_leftmost(NULL, compare_strings,
+                                               &search));
+    assert_int_equal(-1, prefix_index_rightmost(NULL, compare_strings,
+                                                &search));
+
+    prefix_index_destroy(NULL);
+}
+
+static void short_keys_are_zero_padded(__unused void **state)
+{
+    const char *words[] = {"", "a", "ab", "abc", "abcdefgh", "abcdefghi",
+                           "abd", "b", "b", "b", "ba"};
+    const size_t count = sizeof(words) / sizeof(*words);
+
+    struct prefix_index *index = prefix_index_create(words, count,
+                                                     sizeof(*words),
+                                                     string_key);
+    assert_non_null(index);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (i >= 7 && i <= 9)
+            continue;
+        assert_int_equal(i, prefix_index_leftmost(index, compare_strings,
+                                                  &words[i]));
+        assert_int_equal(i, prefix_index_rightmost(index, compare_strings,
+                                                   &words[i]));
+    }
+
+    const char *search = "b";
+    assert_int_equal(7, prefix_index_leftmost(index, compare_strings,
+                                              &search));
+    assert_int_equal(9, prefix_index_rightmost(index, compare_strings,
+                                               &search));
+
+    const char *missing[] = {"aa", "abcdefg", "abcdefghh", "c"};
+    for (size_t i = 0; i < sizeof(missing) / sizeof(*missing); ++i) {
+        assert_int_equal(-1, prefix_index_leftmost(index, compare_strings,
+                                                   &missing[i]));
+        assert_int_equal(-1, prefix_index_rightmost(index, compare_strings,
+                                                    &missing[i]));
+    }
+
+    prefix_index_destroy(index);
+}
+
+static void distinct_prefixes_match_binary_search(__unused void **state)
+{
+    for (size_t i = 0; i < STRING_COUNT; ++i) {
+        snprintf(storage[i], sizeof(storage[i]), "%08zx", i * 7919 % 100003);
+        strings[i] = storage[i];
+    }
+    qsort(strings, STRING_COUNT, sizeof(*strings), qsort_strings);
+
+    check_against_binary_search(STRING_COUNT);
+    check_against_binary_search(1);
+}
+
+static void shared_prefixes_with_duplicates(__unused void **state)
+{
+    // every key shares the first 8 bytes so all lookups go to the comparator
+    for (size_t i = 0; i < STRING_COUNT; ++i) {
+        snprintf(storage[i], sizeof(storage[i]), "https://host/%zu/%zu",
+                 i % 17, i / 51);
+        strings[i] = storage[i];
+    }
+    qsort(strings, STRING_COUNT, sizeof(*strings), qsort_strings);
+
+    check_against_binary_search(STRING_COUNT);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(short_keys_are_zero_padded),
+        cmocka_unit_test(distinct_prefixes_match_binary_search),
+        cmocka_unit_test(shared_prefixes_with_duplicates),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file test_snapshot_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <cmocka.h>
+
+#include "snapshot_vector.h"
+
+#define __unused __attribute__((unused))
+
+#define CHUNK_SIZE 16
+#define READERS 3
+#define VERSIONS 2000
+#define ELEMENTS 100
+
+static int set_up(void **state)
+{
+    struct snapshot_vector *sv = snapshot_vector_create(CHUNK_SIZE,
+                                                        sizeof(int));
+    if (sv == NULL)
+        return -1;
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    for (int i = 0; i < ELEMENTS; i++)
+        snapshot_txn_push_back(txn, &i);
+    snapshot_txn_commit(txn);
+
+    *state = sv;
+    return 0;
+}
+
+static int tear_down(void **state)
+{
+    snapshot_vector_destroy(*state);
+    return 0;
+}
+
+static void create_with_zero_element_size(__unused void **state)
+{
+    assert_null(snapshot_vector_create(0, 0));
+}
+
+static void create_from_vector(__unused void **state)
+{
+    struct vector *v = vector_create(0, sizeof(int));
+    for (int i = 0; i < 1000; i++)
+        vector_insert(v, i, &i);
+
+    struct snapshot_vector *sv = snapshot_vector_create_from(0, v);
+    assert_non_null(sv);
+
+    struct snapshot_reader *r = snapshot_vector_reader(sv);
+    const struct snapshot *snap = snapshot_pin(r);
+    assert_int_equal(1000, snapshot_size(snap));
+    for (int i = 0; i < 1000; i++)
+        assert_int_equal(i, *(const int *) snapshot_get(snap, i));
+    snapshot_unpin(r);
+
+    snapshot_vector_destroy(sv);
+    vector_destroy(v);
+}
+
+static void pinned_snapshot_ignores_later_commits(void **state)
+{
+    struct snapshot_vector *sv = *state;
+    struct snapshot_reader *r = snapshot_vector_reader(sv);
+    const struct snapshot *old = snapshot_pin(r);
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    int e = -1;
+    assert_int_equal(0, snapshot_txn_set(txn, 5, &e));
+    assert_int_equal(0, snapshot_txn_push_back(txn, &e));
+    assert_int_equal(-1, *(const int *) snapshot_txn_get(txn, 5));
+    snapshot_txn_commit(txn);
+
+    assert_int_equal(ELEMENTS, snapshot_size(old));
+    assert_int_equal(5, *(const int *) snapshot_get(old, 5));
+    snapshot_unpin(r);
+
+    const struct snapshot *new = snapshot_pin(r);
+    assert_int_equal(ELEMENTS + 1, snapshot_size(new));
+    assert_int_equal(-1, *(const int *) snapshot_get(new, 5));
+    assert_int_equal(-1, *(const int *) snapshot_get(new, ELEMENTS));
+    snapshot_unpin(r);
+
+    snapshot_reader_release(r);
+}
+
+static void unmodified_chunks_are_shared(void **state)
+{
+    struct snapshot_vector *sv = *state;
+    struct snapshot_reader *r = snapshot_vector_reader(sv);
+    const struct snapshot *old = snapshot_pin(r);
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    int e = -1;
+    snapshot_txn_set(txn, 0, &e);
+    snapshot_txn_commit(txn);
+
+    struct snapshot_reader *r2 = snapshot_vector_reader(sv);
+    const struct snapshot *new = snapshot_pin(r2);
+
+    assert_true(snapshot_get(old, 0) != snapshot_get(new, 0));
+    assert_ptr_equal(snapshot_get(old, CHUNK_SIZE),
+                     snapshot_get(new, CHUNK_SIZE));
+
+    snapshot_unpin(r2);
+    snapshot_unpin(r);
+    snapshot_reader_release(r2);
+    snapshot_reader_release(r);
+}
+
+static void abort_discards_changes(void **state)
+{
+    struct snapshot_vector *sv = *state;
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    int e = -1;
+    snapshot_txn_set(txn, 0, &e);
+    assert_int_equal(0, snapshot_txn_pop_back(txn));
+    assert_int_equal(ELEMENTS - 1, snapshot_txn_size(txn));
+    snapshot_txn_abort(txn);
+
+    struct snapshot_reader *r = snapshot_vector_reader(sv);
+    const struct snapshot *snap = snapshot_pin(r);
+    assert_int_equal(ELEMENTS, snapshot_size(snap));
+    assert_int_equal(0, *(const int *) snapshot_get(snap, 0));
+    snapshot_unpin(r);
+    snapshot_reader_release(r);
+}
+
+static void pop_back_and_push_back_again(void **state)
+{
+    struct snapshot_vector *sv = *state;
+    struct snapshot_reader *r = snapshot_vector_reader(sv);
+    const struct snapshot *old = snapshot_pin(r);
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    for (int i = 0; i < ELEMENTS; i++)
+        assert_int_equal(0, snapshot_txn_pop_back(txn));
+    assert_int_equal(-EINVAL, snapshot_txn_pop_back(txn));
+
+    int e = 7;
+    for (int i = 0; i < 20; i++)
+        assert_int_equal(0, snapshot_txn_push_back(txn, &e));
+    snapshot_txn_commit(txn);
+
+    for (int i = 0; i < ELEMENTS; i++)
+        assert_int_equal(i, *(const int *) snapshot_get(old, i));
+    snapshot_unpin(r);
+
+    const struct snapshot *new = snapshot_pin(r);
+    assert_int_equal(20, snapshot_size(new));
+    assert_int_equal(7, *(const int *) snapshot_get(new, 19));
+    snapshot_unpin(r);
+    snapshot_reader_release(r);
+}
+
+struct context {
+    struct snapshot_vector *vector;
+    atomic_bool *done;
+    int failed;
+};
+
+static void *reader(void *arg)
+{
+    struct context *ctx = arg;
+    struct snapshot_reader *r = snapshot_vector_reader(ctx->vector);
+
+    // every version has all the elements set to the same value
+    while (!atomic_load(ctx->done)) {
+        const struct snapshot *snap = snapshot_pin(r);
+        int first = *(const int *) snapshot_get(snap, 0);
+        for (size_t i = 1; i < snapshot_size(snap); i++) {
+            if (*(const int *) snapshot_get(snap, i) != first)
+                ctx->failed = 1;
+        }
+        snapshot_unpin(r);
+    }
+
+    snapshot_reader_release(r);
+
+    return NULL;
+}
+
+static void concurrent_readers_see_consistent_versions(void **state)
+{
+    struct snapshot_vector *sv = *state;
+    pthread_t threads[READERS];
+    struct context ctx[READERS];
+    atomic_bool done = false;
+
+    struct snapshot_txn *txn = snapshot_vector_begin(sv);
+    int zero = 0;
+    for (size_t i = 0; i < ELEMENTS; i++)
+        snapshot_txn_set(txn, i, &zero);
+    snapshot_txn_commit(txn);
+
+    for (int i = 0; i < READERS; i++) {
+        ctx[i] = (struct context) {sv, &done, 0};
+        pthread_create(&threads[i], NULL, reader, &ctx[i]);
+    }
+
+    for (int v = 1; v <= VERSIONS; v++) {
+        txn = snapshot_vector_begin(sv);
+        for (size_t i = 0; i < ELEMENTS; i++)
+            snapshot_txn_set(txn, i, &v);
+        snapshot_txn_commit(txn);
+    }
+
+    atomic_store(&done, true);
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(threads[i], NULL);
+        assert_int_equal(0, ctx[i].failed);
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_zero_element_size),
+        cmocka_unit_test(create_from_vector),
+        cmocka_unit_test_setup_teardown(pinned_snapshot_ignores_later_commits,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(unmodified_chunks_are_shared,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(abort_discards_changes,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(pop_back_and_push_back_again,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(
+                concurrent_readers_see_consistent_versions,
+                set_up, tear_down),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,213 @@
+/**
+ * @file test_soa_vector.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "soa_vector.h"
+
+#define __unused __attribute__((unused))
+
+#define DEFAULT_CAPACITY 32
+
+struct record {
+    uint8_t flag;
+    int64_t key;
+    double value;
+    char name[13];
+};
+
+static const struct soa_field fields[] = {
+    SOA_FIELD(struct record, flag),
+    SOA_FIELD(struct record, key),
+    SOA_FIELD(struct record, value),
+    SOA_FIELD(struct record, name),
+};
+
+enum { FLAG, KEY, VALUE, NAME, FIELD_COUNT };
+
+static struct record make_record(int i)
+{
+    struct record r;
+    memset(&r, 0, sizeof(r));
+    r.flag = i % 2;
+    r.key = 1000 + i;
+    r.value = i / 4.0;
+    snprintf(r.name, sizeof(r.name), "record %d", i);
+    return r;
+}
+
+static int set_up(void **state)
+{
+    *state = soa_vector_create(0, sizeof(struct record), fields, FIELD_COUNT);
+    if (*state == NULL)
+        return -1;
+    return 0;
+}
+
+static int tear_down(void **state)
+{
+    soa_vector_destroy(*state);
+    return 0;
+}
+
+static void create_with_non_zero_size_returns_success(__unused void **state)
+{
+    struct soa_vector *v = soa_vector_create(64, sizeof(struct record),
+                                             fields, FIELD_COUNT);
+
+    assert_non_null(v);
+    assert_int_equal(64, soa_vector_capacity(v));
+    assert_int_equal(64, soa_vector_size(v));
+    assert_int_equal(0, *(int64_t *) soa_vector_field(v, 63, KEY));
+
+    soa_vector_destroy(v);
+}
+
+static void create_with_invalid_field_returns_error(__unused void **state)
+{
+    struct soa_field bad[] = {{4, 8}};
+
+    assert_null(soa_vector_create(0, 8, bad, 1));
+    assert_null(soa_vector_create(0, 8, fields, 0));
+}
+
+static void insert_and_get_records_with_resize(void **state)
+{
+    struct soa_vector *v = *state;
+
+    for (int i = 0; i < 100; i++) {
+        struct record r = make_record(i);
+        assert_int_equal(0, soa_vector_insert(v, soa_vector_size(v), &r));
+    }
+
+    assert_int_equal(100, soa_vector_size(v));
+    assert_true(soa_vector_capacity(v) >= 100);
+
+    for (int i = 0; i < 100; i++) {
+        struct record expected = make_record(i), r;
+        memset(&r, 0, sizeof(r));
+
+        assert_int_equal(0, soa_vector_get(v, i, &r));
+        assert_memory_equal(&expected, &r, sizeof(r));
+    }
+}
+
+static void insert_in_the_middle_shifts_all_columns(void **state)
+{
+    struct soa_vector *v = *state;
+    struct record r0 = make_record(0), r1 = make_record(1),
+                  r2 = make_record(2);
+
+    soa_vector_insert(v, 0, &r0);
+    soa_vector_insert(v, 1, &r2);
+    soa_vector_insert(v, 1, &r1);
+
+    int64_t *keys = soa_vector_column(v, KEY);
+    double *values = soa_vector_column(v, VALUE);
+    for (int i = 0; i < 3; i++) {
+        assert_int_equal(1000 + i, keys[i]);
+        assert_true(values[i] == i / 4.0);
+    }
+
+    assert_int_equal(0, soa_vector_remove(v, 1));
+    assert_int_equal(2, soa_vector_size(v));
+    assert_int_equal(1002, *(int64_t *) soa_vector_field(v, 1, KEY));
+    assert_int_equal(-EINVAL, soa_vector_remove(v, 2));
+}
+
+static void set_overwrites_all_fields(void **state)
+{
+    struct soa_vector *v = *state;
+    struct record r0 = make_record(0), r5 = make_record(5), out;
+
+    soa_vector_insert(v, 0, &r0);
+    soa_vector_set(v, 0, &r5);
+
+    memset(&out, 0, sizeof(out));
+    soa_vector_get(v, 0, &out);
+    assert_memory_equal(&r5, &out, sizeof(out));
+
+    errno = 0;
+    soa_vector_set(v, 1, &r5);
+    assert_int_equal(EINVAL, errno);
+}
+
+static void columns_are_cache_line_aligned(void **state)
+{
+    struct soa_vector *v = *state;
+
+    for (size_t i = 0; i < FIELD_COUNT; i++)
+        assert_int_equal(0, (uintptr_t) soa_vector_column(v, i) % 64);
+    assert_null(soa_vector_column(v, FIELD_COUNT));
+}
+
+static void remove_shrinks_the_vector(void **state)
+{
+    struct soa_vector *v = *state;
+
+    for (int i = 0; i < DEFAULT_CAPACITY + 1; i++) {
+        struct record r = make_record(i);
+        soa_vector_insert(v, i, &r);
+    }
+    assert_int_equal(48, soa_vector_capacity(v));
+
+    while (soa_vector_size(v) > 10)
+        soa_vector_remove(v, 0);
+
+    assert_int_equal(DEFAULT_CAPACITY, soa_vector_capacity(v));
+    assert_int_equal(1000 + 23, *(int64_t *) soa_vector_field(v, 0, KEY));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_non_zero_size_returns_success),
+        cmocka_unit_test(create_with_invalid_field_returns_error),
+        cmocka_unit_test_setup_teardown(insert_and_get_records_with_resize,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(insert_in_the_middle_shifts_all_columns,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(set_overwrites_all_fields,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(columns_are_cache_line_aligned,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(remove_shrinks_the_vector,
+                                        set_up, tear_down),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,272 @@
+/**
+ * @file test_sort.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "sort.h"
+#include "vector.h"
+
+#define __unused __attribute__((unused))
+
+#define ELEMENTS 20011
+
+struct record {
+    int32_t key;
+    uint32_t seq;
+    char payload[72];
+};
+
+static ssize_t compare_i32(const void *x1, const void *x2)
+{
+    int32_t a = *(const int32_t *) x1, b = *(const int32_t *) x2;
+    return (a > b) - (a < b);
+}
+
+static inline int compare_i32_typed(const int32_t *x1, const int32_t *x2)
+{
+    return (*x1 > *x2) - (*x1 < *x2);
+}
+
+static inline int compare_record_typed(const struct record *x1,
+                                       const struct record *x2)
+{
+    return (x1->key > x2->key) - (x1->key < x2->key);
+}
+
+static ssize_t compare_record(const void *x1, const void *x2)
+{
+    return compare_record_typed(x1, x2);
+}
+
+static uint64_t record_key(const void *element)
+{
+    // flipping the sign bit orders signed keys as unsigned ones
+    return (uint32_t) ((const struct record *) element)->key ^ 0x80000000u;
+}
+
+SORT_DEFINE(sort_i32, int32_t, compare_i32_typed)
+SORT_DEFINE(sort_record, struct record, compare_record_typed)
+
+enum pattern { RANDOM, FEW_KEYS, SORTED, REVERSED, EQUAL, ORGAN_PIPE };
+
+static int32_t value(enum pattern pattern, size_t i, size_t n)
+{
+    switch (pattern) {
+    case RANDOM:
+        return (int32_t) ((uint32_t) rand() * 2654435761u);
+    case FEW_KEYS:
+        return rand() % 7 - 3;
+    case SORTED:
+        return (int32_t) i;
+    case REVERSED:
+        return (int32_t) (n - i);
+    case EQUAL:
+        return 42;
+    default:
+        return (int32_t) (i < n / 2 ? i : n - i);
+    }
+}
+
+static void fill_records(struct record *records, size_t n,
+                         enum pattern pattern)
+{
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = value(pattern, i, n);
+        records[i].seq = (uint32_t) i;
+        records[i].payload[0] = (char) i;
+    }
+}
+
+static void check_sorted(const struct record *records, size_t n, bool stable)
+{
+    for (size_t i = 1; i < n; i++) {
+        assert_true(records[i - 1].key <= records[i].key);
+        if (stable && records[i - 1].key == records[i].key)
+            assert_true(records[i - 1].seq < records[i].seq);
+    }
+    for (size_t i = 0; i < n; i++)
+        assert_int_equal((char) records[i].seq, records[i].payload[0]);
+}
+
+static void generic_sorts_order_all_patterns(__unused void **state)
+{
+    static struct record records[ELEMENTS];
+    const size_t sizes[] = {0, 1, 2, 15, 16, 17, 1000, ELEMENTS};
+
+    srand(time(NULL));
+
+    for (enum pattern p = RANDOM; p <= ORGAN_PIPE; p++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            size_t n = sizes[s];
+
+            fill_records(records, n, p);
+            assert_int_equal(0, sort(records, n, sizeof(*records),
+                                     compare_record));
+            check_sorted(records, n, false);
+
+            fill_records(records, n, p);
+            assert_int_equal(0, sort_stable(records, n, sizeof(*records),
+                                            compare_record));
+            check_sorted(records, n, true);
+
+            fill_records(records, n, p);
+            assert_int_equal(0, sort_radix(records, n, sizeof(*records),
+                                           record_key));
+            check_sorted(records, n, true);
+
+            fill_records(records, n, p);
+            sort_record(records, n);
+            check_sorted(records, n, false);
+
+            fill_records(records, n, p);
+            assert_int_equal(0, sort_record_stable(records, n));
+            check_sorted(records, n, true);
+        }
+    }
+}
+
+#define CHECK_RADIX(name, T) \
+    static void check_radix_##name(void) \
+    { \
+        static T array[ELEMENTS]; \
+        const uint64_t top = (uint64_t) 1 << (sizeof(T) * CHAR_BIT - 1); \
+        const T extremes[] = {(T) 0, (T) 1, (T) -1, (T) (1 << 30), \
+                              (T) (top - 1), (T) top}; \
+        for (size_t i = 0; i < ELEMENTS; i++) { \
+            array[i] = (T) (((uint64_t) rand() << 32 | (uint64_t) rand()) * \
+                            0x9e3779b97f4a7c15ULL); \
+            if (i % 3 == 0) \
+                array[i] = extremes[i / 3 % 6]; \
+        } \
+        uint64_t sum = 0; \
+        for (size_t i = 0; i < ELEMENTS; i++) \
+            sum += (uint64_t) array[i]; \
+        assert_int_equal(0, sort_radix_##name(array, ELEMENTS)); \
+        for (size_t i = 1; i < ELEMENTS; i++) \
+            assert_true(array[i - 1] <= array[i]); \
+        for (size_t i = 0; i < ELEMENTS; i++) \
+            sum -= (uint64_t) array[i]; \
+        assert_int_equal(0, sum); \
+        assert_int_equal(0, sort_radix_##name(array, 0)); \
+        assert_int_equal(-EINVAL, sort_radix_##name(NULL, 1)); \
+    }
+
+CHECK_RADIX(i32, int32_t)
+CHECK_RADIX(u32, uint32_t)
+CHECK_RADIX(i64, int64_t)
+CHECK_RADIX(u64, uint64_t)
+
+static void radix_sorts_integers(__unused void **state)
+{
+    check_radix_i32();
+    check_radix_u32();
+    check_radix_i64();
+    check_radix_u64();
+}
+
+static void typed_sort_matches_generic(__unused void **state)
+{
+    static int32_t typed[ELEMENTS], generic[ELEMENTS];
+
+    for (size_t i = 0; i < ELEMENTS; i++)
+        typed[i] = generic[i] = rand() % 1000 - 500;
+
+    sort_i32(typed, ELEMENTS);
+    assert_int_equal(0, sort(generic, ELEMENTS, sizeof(int32_t),
+                             compare_i32));
+    for (size_t i = 0; i < ELEMENTS; i++)
+        assert_int_equal(generic[i], typed[i]);
+
+    // the output is what the binary searches expect
+    int32_t key = generic[ELEMENTS / 2];
+    ssize_t first = binary_search_leftmost(generic, ELEMENTS,
+                                           sizeof(int32_t), compare_i32,
+                                           &key);
+    assert_true(first >= 0);
+    assert_int_equal(key, generic[first]);
+}
+
+static void sorts_vector_in_place(__unused void **state)
+{
+    struct vector *v = vector_create(ELEMENTS, sizeof(struct record));
+    fill_records(vector_data(v), ELEMENTS, FEW_KEYS);
+
+    assert_int_equal(0, vector_sort_stable(v, compare_record));
+    check_sorted(vector_data(v), ELEMENTS, true);
+
+    fill_records(vector_data(v), ELEMENTS, RANDOM);
+    assert_int_equal(0, vector_sort(v, compare_record));
+    check_sorted(vector_data(v), ELEMENTS, false);
+
+    assert_int_equal(-EINVAL, vector_sort(NULL, compare_record));
+    assert_int_equal(-EINVAL, vector_sort_stable(v, NULL));
+
+    vector_destroy(v);
+}
+
+static void invalid_arguments(__unused void **state)
+{
+    int32_t array[2] = {2, 1};
+
+    assert_int_equal(-EINVAL, sort(NULL, 2, sizeof(int32_t), compare_i32));
+    assert_int_equal(-EINVAL, sort(array, 2, 0, compare_i32));
+    assert_int_equal(-EINVAL, sort(array, 2, sizeof(int32_t), NULL));
+    assert_int_equal(-EINVAL, sort_stable(NULL, 2, sizeof(int32_t),
+                                          compare_i32));
+    assert_int_equal(-EINVAL, sort_stable_buffered(array, 2, sizeof(int32_t),
+                                                   compare_i32, NULL));
+    assert_int_equal(-EINVAL, sort_radix(array, 2, sizeof(int32_t), NULL));
+    assert_int_equal(-EINVAL, sort_i32_stable(NULL, 2));
+
+    assert_int_equal(0, sort(NULL, 0, sizeof(int32_t), compare_i32));
+    assert_int_equal(2, array[0]);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(generic_sorts_order_all_patterns),
+        cmocka_unit_test(radix_sorts_integers),
+        cmocka_unit_test(typed_sort_matches_generic),
+        cmocka_unit_test(sorts_vector_in_place),
+        cmocka_unit_test(invalid_arguments),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,225 @@
+/**
+ * @file test_sorted_set.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "sorted_set.h"
+#include "vector.h"
+
+#define __unused __attribute__((unused))
+
+static const enum vector_isa isas[] = {
+    VECTOR_ISA_SCALAR, VECTOR_ISA_AVX2,
+};
+
+// pairs of sizes covering the merge kernels with their scalar tails and the
+// galloping in both directions
+static const size_t sizes[][2] = {
+    {0, 0}, {0, 100}, {100, 0}, {7, 9}, {1037, 1000}, {5000, 4000},
+    {20, 5000}, {5000, 20}, {1, 3000},
+};
+
+// random sets drawn from a range a few times their size so that they
+// overlap partially
+#define CHECK_TYPE(name, T) \
+    static void fill_##name(T *set, size_t size, size_t range) \
+    { \
+        T value = 0; \
+        for (size_t i = 0; i < size; i++) { \
+            value += 1 + (T) ((size_t) rand() % (range / (size + 1) + 1)); \
+            set[i] = value; \
+        } \
+    } \
+    static void check_output_##name(struct vector *out, const T *a, \
+                                    size_t na, const T *b, size_t nb, \
+                                    int op, enum sorted_set_output output) \
+    { \
+        size_t i = 0, j = 0, n = 0; \
+        while (i < na || j < nb) { \
+            bool in_a = i < na && (j == nb || a[i] <= b[j]); \
+            bool in_b = j < nb && (i == na || b[j] <= a[i]); \
+            T value = in_a ? a[i] : b[j]; \
+            bool emitted = op == 0 ? in_a && in_b : \
+                           op == 1 ? in_a && !in_b : true; \
+            if (emitted) { \
+                assert_true(n < vector_size(out)); \
+                if (output == SORTED_SET_INDICES) \
+                    assert_int_equal(i, *(size_t *) vector_get(out, n)); \
+                else \
+                    assert_true(value == *(T *) vector_get(out, n)); \
+                n++; \
+            } \
+            i += in_a; \
+            j += in_b; \
+        } \
+        assert_int_equal(n, vector_size(out)); \
+    } \
+    static void check_##name(void) \
+    { \
+        T *a = malloc(5000 * sizeof(T)), *b = malloc(5000 * sizeof(T)); \
+        assert_non_null(a); \
+        assert_non_null(b); \
+        \
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) { \
+            size_t na = sizes[s][0], nb = sizes[s][1]; \
+            size_t range = 3 * (na > nb ? na : nb) + 8; \
+            fill_##name(a, na, range); \
+            fill_##name(b, nb, range); \
+            \
+            for (size_t k = 0; k < sizeof(isas) / sizeof(isas[0]); k++) { \
+                if (sorted_set_set_isa(isas[k]) != 0) \
+                    continue; \
+                for (int op = 0; op < 3; op++) { \
+                    struct vector *values = vector_create(0, sizeof(T)); \
+                    struct vector *indices = vector_create(0, \
+                                                           sizeof(size_t)); \
+                    if (op == 0) { \
+                        assert_int_equal(0, sorted_set_intersect_##name( \
+                            a, na, b, nb, values, SORTED_SET_VALUES)); \
+                        assert_int_equal(0, sorted_set_intersect_##name( \
+                            a, na, b, nb, indices, SORTED_SET_INDICES)); \
+                    } else if (op == 1) { \
+                        assert_int_equal(0, sorted_set_difference_##name( \
+                            a, na, b, nb, values, SORTED_SET_VALUES)); \
+                        assert_int_equal(0, sorted_set_difference_##name( \
+                            a, na, b, nb, indices, SORTED_SET_INDICES)); \
+                    } else { \
+                        assert_int_equal(0, sorted_set_union_##name( \
+                            a, na, b, nb, values)); \
+                    } \
+                    check_output_##name(values, a, na, b, nb, op, \
+                                        SORTED_SET_VALUES); \
+                    if (op < 2) \
+                        check_output_##name(indices, a, na, b, nb, op, \
+                                            SORTED_SET_INDICES); \
+                    vector_destroy(indices); \
+                    vector_destroy(values); \
+                } \
+            } \
+        } \
+        \
+        sorted_set_set_isa(VECTOR_ISA_AUTO); \
+        free(b); \
+        free(a); \
+    }
+
+CHECK_TYPE(u32, uint32_t)
+CHECK_TYPE(u64, uint64_t)
+
+static void random_sets_match_reference(__unused void **state)
+{
+    srand(time(NULL));
+
+    check_u32();
+    check_u64();
+}
+
+static void values_above_signed_range(__unused void **state)
+{
+    const uint64_t a[] = {1, UINT64_MAX - 8, UINT64_MAX - 5, UINT64_MAX - 3,
+                          UINT64_MAX - 2, UINT64_MAX - 1};
+    const uint64_t b[] = {2, 3, 4, UINT64_MAX - 7, UINT64_MAX - 5,
+                          UINT64_MAX - 4, UINT64_MAX - 1, UINT64_MAX};
+    const uint64_t common[] = {UINT64_MAX - 5, UINT64_MAX - 1};
+
+    for (size_t k = 0; k < sizeof(isas) / sizeof(isas[0]); k++) {
+        if (sorted_set_set_isa(isas[k]) != 0)
+            continue;
+
+        struct vector *out = vector_create(0, sizeof(uint64_t));
+        assert_int_equal(0, sorted_set_intersect_u64(a, 6, b, 8, out,
+                                                     SORTED_SET_VALUES));
+        assert_int_equal(2, vector_size(out));
+        for (size_t i = 0; i < 2; i++)
+            assert_true(common[i] == *(uint64_t *) vector_get(out, i));
+        vector_destroy(out);
+    }
+
+    sorted_set_set_isa(VECTOR_ISA_AUTO);
+}
+
+static void output_is_appended(__unused void **state)
+{
+    const uint32_t a[] = {1, 2, 3}, b[] = {2};
+    struct vector *out = vector_create(0, sizeof(uint32_t));
+
+    assert_int_equal(0, sorted_set_difference_u32(a, 3, b, 1, out,
+                                                  SORTED_SET_VALUES));
+    assert_int_equal(0, sorted_set_intersect_u32(a, 3, b, 1, out,
+                                                 SORTED_SET_VALUES));
+    assert_int_equal(3, vector_size(out));
+    assert_int_equal(1, *(uint32_t *) vector_get(out, 0));
+    assert_int_equal(3, *(uint32_t *) vector_get(out, 1));
+    assert_int_equal(2, *(uint32_t *) vector_get(out, 2));
+
+    vector_destroy(out);
+}
+
+static void invalid_arguments(__unused void **state)
+{
+    const uint32_t a[] = {1, 2, 3};
+    struct vector *out = vector_create(0, sizeof(uint32_t));
+
+    assert_int_equal(-EINVAL, sorted_set_intersect_u32(NULL, 1, a, 3, out,
+                                                       SORTED_SET_VALUES));
+    assert_int_equal(-EINVAL, sorted_set_intersect_u32(a, 3, a, 3, NULL,
+                                                       SORTED_SET_VALUES));
+    assert_int_equal(-EINVAL, sorted_set_union_u64(NULL, 0, NULL, 0, out));
+    // indices need a vector of size_t
+    assert_int_equal(-EINVAL, sorted_set_difference_u32(a, 3, a, 3, out,
+                                                        SORTED_SET_INDICES));
+    assert_int_equal(0, vector_size(out));
+
+    assert_int_equal(0, sorted_set_set_isa(VECTOR_ISA_SCALAR));
+    assert_int_equal(0, sorted_set_set_isa(VECTOR_ISA_AUTO));
+
+    vector_destroy(out);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(random_sets_match_reference),
+        cmocka_unit_test(values_above_signed_range),
+        cmocka_unit_test(output_is_appended),
+        cmocka_unit_test(invalid_arguments),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
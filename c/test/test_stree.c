@@ -0,0 +1,133 @@
+/**
+ * @file test_stree.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "binary_search.h"
+#include "stree.h"
+
+#define __unused __attribute__((unused))
+
+static const enum vector_isa isas[] = {
+    VECTOR_ISA_SCALAR, VECTOR_ISA_SSE2, VECTOR_ISA_AVX2,
+};
+
+static void create_with_invalid_arguments_returns_error(__unused void **state)
+{
+    int32_t a[] = {1, 2, 3};
+
+    errno = 0;
+    assert_null(stree_create(NULL, 3));
+    assert_int_equal(EINVAL, errno);
+    assert_null(stree_create(a, 0));
+
+    assert_int_equal(-1, stree_search_leftmost(NULL, 1));
+    assert_int_equal(-1, stree_search_rightmost(NULL, 1));
+    assert_int_equal(0, stree_lower_bound(NULL, 1));
+}
+
+static void search_small_tree(__unused void **state)
+{
+    int32_t a[] = {INT32_MIN, -7, 0, 0, 0, 4, 9, INT32_MAX, INT32_MAX};
+    struct stree *t = stree_create(a, 9);
+    assert_non_null(t);
+    assert_int_equal(9, stree_size(t));
+
+    for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); ++i) {
+        if (stree_set_isa(t, isas[i]) != 0)
+            continue;
+
+        assert_int_equal(0, stree_search_leftmost(t, INT32_MIN));
+        assert_int_equal(0, stree_search_rightmost(t, INT32_MIN));
+        assert_int_equal(2, stree_search_leftmost(t, 0));
+        assert_int_equal(4, stree_search_rightmost(t, 0));
+        assert_int_equal(7, stree_search_leftmost(t, INT32_MAX));
+        assert_int_equal(8, stree_search_rightmost(t, INT32_MAX));
+        assert_int_equal(-1, stree_search_leftmost(t, 5));
+        assert_int_equal(-1, stree_search_rightmost(t, -8));
+        assert_int_equal(6, stree_lower_bound(t, 5));
+        assert_int_equal(7, stree_lower_bound(t, INT32_MAX));
+    }
+
+    stree_destroy(t);
+}
+
+static void search_matches_binary_search(__unused void **state)
+{
+    static int32_t a[40000];
+    size_t n = sizeof(a) / sizeof(a[0]);
+
+    srand(time(NULL));
+    a[0] = -1000;
+    for (size_t i = 1; i < n; ++i)
+        a[i] = a[i - 1] + rand() % 3;
+
+    // 1 leaf, 1 full inner layer, 3 layers with a partial last leaf, ...
+    const size_t sizes[] = {1, 16, 17, 272, 273, 4625, 4913, n};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        size_t size = sizes[s];
+        struct stree *t = stree_create(a, size);
+        assert_non_null(t);
+
+        for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); ++i) {
+            if (stree_set_isa(t, isas[i]) != 0)
+                continue;
+
+            for (int32_t key = a[0] - 1; key <= a[size - 1] + 1; ++key) {
+                assert_int_equal(binary_search_leftmost_i32(a, size, key),
+                                 stree_search_leftmost(t, key));
+                assert_int_equal(binary_search_rightmost_i32(a, size, key),
+                                 stree_search_rightmost(t, key));
+            }
+        }
+
+        stree_destroy(t);
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(create_with_invalid_arguments_returns_error),
+        cmocka_unit_test(search_small_tree),
+        cmocka_unit_test(search_matches_binary_search),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
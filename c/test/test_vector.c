@@ -34,6 +34,7 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <errno.h>
+#include <unistd.h>
 #include <cmocka.h>
 
 #include "vector.h"
@@ -168,6 +169,446 @@ static void add_and_remove_elements_with_3_resizes(void **state)
     }
 }
 
+static ssize_t compare_int(const void *x1, const void *x2)
+{
+    return *(int *) x1 - *(int *) x2;
+}
+
+static void insert_sorted_keeps_order(void **state)
+{
+    struct vector *v = *state;
+    int a[] = {5, 3, 9, 1, 7, 3, 0, 8, 2, 6, 4};
+
+    for (size_t i = 0; i < sizeof(a) / sizeof(a[0]); i++) {
+        ssize_t idx = vector_insert_sorted(v, compare_int, &a[i]);
+        assert_true(idx >= 0);
+        assert_int_equal(a[i], *(int *) vector_get(v, idx));
+    }
+
+    assert_int_equal(sizeof(a) / sizeof(a[0]), vector_size(v));
+    for (size_t i = 1; i < vector_size(v); i++) {
+        assert_true(*(int *) vector_get(v, i - 1) <=
+                    *(int *) vector_get(v, i));
+    }
+}
+
+static void insert_sorted_puts_equal_elements_last(void **state)
+{
+    struct vector *v = *state;
+    int a[] = {1, 2, 2, 3};
+
+    for (size_t i = 0; i < sizeof(a) / sizeof(a[0]); i++)
+        vector_insert_sorted(v, compare_int, &a[i]);
+
+    int e = 2;
+    assert_int_equal(3, vector_insert_sorted(v, compare_int, &e));
+}
+
+static void find_returns_leftmost(void **state)
+{
+    struct vector *v = *state;
+    int a[] = {1, 2, 3, 3, 3, 4, 8};
+
+    for (size_t i = 0; i < sizeof(a) / sizeof(a[0]); i++)
+        vector_insert_sorted(v, compare_int, &a[i]);
+
+    int search = 3;
+    assert_int_equal(2, vector_find(v, compare_int, &search));
+    search = 5;
+    assert_int_equal(-1, vector_find(v, compare_int, &search));
+}
+
+static void erase_key_removes_all_equal_elements(void **state)
+{
+    struct vector *v = *state;
+    int a[] = {1, 2, 3, 3, 3, 4, 8};
+
+    for (size_t i = 0; i < sizeof(a) / sizeof(a[0]); i++)
+        vector_insert_sorted(v, compare_int, &a[i]);
+
+    int key = 3;
+    assert_int_equal(3, vector_erase_key(v, compare_int, &key));
+    assert_int_equal(4, vector_size(v));
+    assert_int_equal(2, *(int *) vector_get(v, 1));
+    assert_int_equal(4, *(int *) vector_get(v, 2));
+
+    key = 5;
+    assert_int_equal(0, vector_erase_key(v, compare_int, &key));
+    assert_int_equal(4, vector_size(v));
+}
+
+static void merge_sorted_bulk_with_resize(void **state)
+{
+    struct vector *v = *state;
+
+    for (int i = 0; i < 20; i++) {
+        int e = 10 * i;
+        vector_insert(v, i, &e);
+    }
+
+    int batch[100];
+    for (int i = 0; i < 100; i++)
+        batch[i] = 2 * i + 1;
+
+    assert_int_equal(0, vector_merge_sorted_bulk(v, compare_int, batch, 100));
+    assert_int_equal(120, vector_size(v));
+    assert_true(vector_capacity(v) >= 120);
+
+    for (size_t i = 1; i < vector_size(v); i++) {
+        assert_true(*(int *) vector_get(v, i - 1) <=
+                    *(int *) vector_get(v, i));
+    }
+}
+
+static void merge_sorted_bulk_into_empty_vector(void **state)
+{
+    struct vector *v = *state;
+    int batch[] = {1, 2, 2, 5};
+
+    assert_int_equal(0, vector_merge_sorted_bulk(v, compare_int, batch, 4));
+    assert_int_equal(4, vector_size(v));
+    for (size_t i = 0; i < 4; i++)
+        assert_int_equal(batch[i], *(int *) vector_get(v, i));
+
+    assert_int_equal(0, vector_merge_sorted_bulk(v, compare_int, NULL, 0));
+    assert_int_equal(4, vector_size(v));
+}
+
+static void append_batch_with_resize(void **state)
+{
+    struct vector *v = *state;
+    int batch[100];
+
+    for (int i = 0; i < 100; i++)
+        batch[i] = 100 - i;
+
+    int e = -1;
+    vector_insert(v, 0, &e);
+
+    assert_int_equal(0, vector_append(v, batch, 100));
+    assert_int_equal(101, vector_size(v));
+    assert_int_equal(-1, *(int *) vector_get(v, 0));
+    for (size_t i = 0; i < 100; i++)
+        assert_int_equal(batch[i], *(int *) vector_get(v, i + 1));
+
+    assert_int_equal(0, vector_append(v, NULL, 0));
+    assert_int_equal(-EINVAL, vector_append(v, NULL, 1));
+    assert_int_equal(-EINVAL, vector_append(NULL, batch, 1));
+}
+
+static void file_path(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/test_vector_%d.bin", (int) getpid());
+}
+
+static void save_and_map_readonly(void **state)
+{
+    struct vector *v = *state;
+    char path[64];
+    file_path(path, sizeof(path));
+
+    for (int i = 0; i < 1000; i++)
+        vector_insert(v, i, &i);
+
+    assert_int_equal(0, vector_save(v, path));
+
+    struct vector *m = vector_map(path, VECTOR_MAP_READONLY);
+    assert_non_null(m);
+    assert_true(vector_is_readonly(m));
+    assert_false(vector_is_readonly(v));
+    assert_int_equal(1000, vector_size(m));
+    assert_int_equal(sizeof(int), vector_element_size(m));
+    for (int i = 0; i < 1000; i++)
+        assert_int_equal(i, *(int *) vector_get(m, i));
+
+    int e = 5;
+    assert_int_equal(-EROFS, vector_insert(m, 0, &e));
+    assert_int_equal(-EROFS, vector_remove(m, 0));
+    errno = 0;
+    vector_set(m, 0, &e);
+    assert_int_equal(EROFS, errno);
+    assert_int_equal(0, *(int *) vector_get(m, 0));
+
+    vector_destroy(m);
+    unlink(path);
+}
+
+static void map_private_is_copy_on_write(void **state)
+{
+    struct vector *v = *state;
+    char path[64];
+    file_path(path, sizeof(path));
+
+    for (int i = 0; i < 10; i++)
+        vector_insert(v, i, &i);
+    assert_int_equal(0, vector_save(v, path));
+
+    struct vector *m = vector_map(path, VECTOR_MAP_PRIVATE);
+    assert_non_null(m);
+
+    int e = 42;
+    vector_set(m, 3, &e);
+    assert_int_equal(42, *(int *) vector_get(m, 3));
+
+    // no space left so the elements have to move to the heap, the mapped
+    // size is the minimum capacity and it grows by the policy from there
+    assert_int_equal(0, vector_insert(m, 10, &e));
+    assert_int_equal(11, vector_size(m));
+    assert_int_equal(15, vector_capacity(m));
+    assert_int_equal(42, *(int *) vector_get(m, 3));
+    assert_int_equal(9, *(int *) vector_get(m, 9));
+    vector_destroy(m);
+
+    // the file stays intact
+    m = vector_map(path, VECTOR_MAP_READONLY);
+    assert_non_null(m);
+    assert_int_equal(10, vector_size(m));
+    assert_int_equal(3, *(int *) vector_get(m, 3));
+    vector_destroy(m);
+
+    unlink(path);
+}
+
+static void map_empty_vector(void **state)
+{
+    struct vector *v = *state;
+    char path[64];
+    file_path(path, sizeof(path));
+
+    assert_int_equal(0, vector_save(v, path));
+
+    struct vector *m = vector_map(path, VECTOR_MAP_PRIVATE);
+    assert_non_null(m);
+    assert_int_equal(0, vector_size(m));
+
+    int e = 7;
+    assert_int_equal(0, vector_insert(m, 0, &e));
+    assert_int_equal(7, *(int *) vector_get(m, 0));
+
+    vector_destroy(m);
+    unlink(path);
+}
+
+static void map_invalid_file_returns_error(__unused void **state)
+{
+    char path[64];
+    file_path(path, sizeof(path));
+
+    FILE *f = fopen(path, "w");
+    fputs("definitely not a vector file, but long enough for a header", f);
+    fclose(f);
+
+    errno = 0;
+    assert_null(vector_map(path, VECTOR_MAP_READONLY));
+    assert_int_equal(EINVAL, errno);
+
+    unlink(path);
+
+    assert_null(vector_map(path, VECTOR_MAP_READONLY));
+    assert_int_equal(ENOENT, errno);
+}
+
+static void map_rejects_invalid_alignment(void **state)
+{
+    struct vector *v = *state;
+    char path[64];
+    file_path(path, sizeof(path));
+
+    // not a power of two, larger than a page and large enough to wrap the
+    // data offset around
+    const uint64_t alignments[] = {3, 6000, 1 << 20, UINT64_MAX / 2 + 1};
+
+    int e = 1;
+    vector_insert(v, 0, &e);
+
+    for (size_t i = 0; i < sizeof(alignments) / sizeof(*alignments); i++) {
+        assert_int_equal(0, vector_save(v, path));
+
+        FILE *f = fopen(path, "r+b");
+        assert_non_null(f);
+        assert_int_equal(0, fseek(f, 32, SEEK_SET));
+        assert_int_equal(1, fwrite(&alignments[i], sizeof(uint64_t), 1, f));
+        fclose(f);
+
+        errno = 0;
+        assert_null(vector_map(path, VECTOR_MAP_READONLY));
+        assert_int_equal(EINVAL, errno);
+    }
+
+    unlink(path);
+}
+
+static void stats_count_resizes_and_moves(void **state)
+{
+    struct vector *v = *state;
+    struct vector_stats stats;
+
+    if (vector_get_stats(v, &stats) == -ENOTSUP)
+        skip();
+
+    vector_reset_global_stats();
+
+    for (int i = 0; i < DEFAULT_CAPACITY + 1; ++i)
+        assert_int_equal(0, vector_insert(v, 0, &i));
+
+    assert_int_equal(0, vector_get_stats(v, &stats));
+    assert_int_equal(1, stats.grows);
+    assert_int_equal(0, stats.shrinks);
+    assert_int_equal(48 * sizeof(int), stats.bytes_reallocated);
+    // inserting at the front shifts 0 + 1 + ... + 32 elements
+    assert_int_equal(32 * 33 / 2 * sizeof(int), stats.bytes_moved);
+    assert_int_equal(48, stats.peak_capacity);
+
+    for (int i = 0; i < DEFAULT_CAPACITY + 1; ++i)
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+
+    assert_int_equal(0, vector_get_stats(v, &stats));
+    assert_int_equal(1, stats.grows);
+    assert_int_equal(1, stats.shrinks);
+    assert_int_equal((48 + 32) * sizeof(int), stats.bytes_reallocated);
+    assert_int_equal(32 * 33 / 2 * sizeof(int), stats.bytes_moved);
+    assert_int_equal(48, stats.peak_capacity);
+
+    struct vector *w = vector_create(100, sizeof(int));
+    assert_non_null(w);
+    assert_int_equal(0, vector_remove(w, 0));
+
+    assert_int_equal(0, vector_get_global_stats(&stats));
+    assert_int_equal(1, stats.grows);
+    assert_int_equal(1, stats.shrinks);
+    assert_int_equal((32 * 33 / 2 + 99) * sizeof(int), stats.bytes_moved);
+    assert_int_equal(128, stats.peak_capacity);
+
+    vector_destroy(w);
+}
+
+static void default_policy_keeps_capacities(void **state)
+{
+    struct vector *v = *state;
+    const size_t grown[] = { 48, 72, 108, 162 };
+    const size_t shrunk[] = { 108, 72, 48, 32 };
+    size_t i = 0;
+
+    for (int e = 0; e < 109; ++e) {
+        size_t capacity = vector_capacity(v);
+        assert_int_equal(0, vector_insert(v, vector_size(v), &e));
+        if (vector_capacity(v) != capacity)
+            assert_int_equal(grown[i++], vector_capacity(v));
+    }
+    assert_int_equal(4, i);
+
+    i = 0;
+    while (vector_size(v) > 0) {
+        size_t capacity = vector_capacity(v);
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+        if (vector_capacity(v) != capacity)
+            assert_int_equal(shrunk[i++], vector_capacity(v));
+    }
+    assert_int_equal(4, i);
+}
+
+static void hysteresis_policy_delays_shrink(void **state)
+{
+    struct vector *v = *state;
+    struct vector_policy policy = VECTOR_POLICY_HYSTERESIS;
+
+    assert_int_equal(0, vector_set_policy(v, &policy));
+
+    for (int e = 0; e < 73; ++e)
+        assert_int_equal(0, vector_insert(v, vector_size(v), &e));
+    assert_int_equal(108, vector_capacity(v));
+
+    // under a half but not under a quarter full
+    while (vector_size(v) > 27)
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+    assert_int_equal(108, vector_capacity(v));
+
+    assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+    assert_int_equal(72, vector_capacity(v));
+}
+
+static void never_shrink_policy(void **state)
+{
+    struct vector *v = *state;
+    struct vector_policy policy = VECTOR_POLICY_DEFAULT;
+    policy.never_shrink = true;
+    policy.growth_num = 2;
+    policy.growth_den = 1;
+
+    assert_int_equal(0, vector_set_policy(v, &policy));
+
+    for (int e = 0; e < 33; ++e)
+        assert_int_equal(0, vector_insert(v, vector_size(v), &e));
+    assert_int_equal(64, vector_capacity(v));
+
+    while (vector_size(v) > 0)
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+    assert_int_equal(64, vector_capacity(v));
+}
+
+static void set_policy_rejects_invalid_factors(void **state)
+{
+    struct vector *v = *state;
+    struct vector_policy policy = VECTOR_POLICY_DEFAULT;
+
+    policy.growth_num = 1;
+    policy.growth_den = 1;
+    assert_int_equal(-EINVAL, vector_set_policy(v, &policy));
+
+    // shrinking to 1/3 when less than a half full would lose elements
+    policy = VECTOR_POLICY_DEFAULT;
+    policy.shrink_num = 1;
+    policy.shrink_den = 3;
+    assert_int_equal(-EINVAL, vector_set_policy(v, &policy));
+
+    policy.never_shrink = true;
+    assert_int_equal(0, vector_set_policy(v, &policy));
+
+    policy = VECTOR_POLICY_DEFAULT;
+    policy.shrink_threshold_num = 0;
+    assert_int_equal(-EINVAL, vector_set_policy(v, &policy));
+    policy.shrink_num = 0;
+    assert_int_equal(-EINVAL, vector_set_policy(v, &policy));
+
+    policy = VECTOR_POLICY_DEFAULT;
+    policy.shrink_num = 0;
+    assert_int_equal(-EINVAL, vector_set_policy(v, &policy));
+
+    assert_int_equal(-EINVAL, vector_set_policy(v, NULL));
+}
+
+static void reserve_and_shrink_to_fit(void **state)
+{
+    struct vector *v = *state;
+
+    assert_int_equal(0, vector_reserve(v, 1000));
+    assert_int_equal(1000, vector_capacity(v));
+    assert_int_equal(0, vector_reserve(v, 10));
+    assert_int_equal(1000, vector_capacity(v));
+
+    for (int e = 0; e < 1000; ++e)
+        assert_int_equal(0, vector_insert(v, vector_size(v), &e));
+    assert_int_equal(1000, vector_capacity(v));
+
+    for (int e = 0; e < 400; ++e)
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+    assert_int_equal(1000, vector_capacity(v));
+
+    assert_int_equal(0, vector_shrink_to_fit(v));
+    assert_int_equal(600, vector_capacity(v));
+    assert_int_equal(599, *(int *) vector_get(v, 599));
+
+    while (vector_size(v) > 0)
+        assert_int_equal(0, vector_remove(v, vector_size(v) - 1));
+    assert_int_equal(0, vector_shrink_to_fit(v));
+    assert_int_equal(1, vector_capacity(v));
+
+    int e = 5;
+    assert_int_equal(0, vector_insert(v, 0, &e));
+    assert_int_equal(0, vector_insert(v, 0, &e));
+    assert_int_equal(DEFAULT_CAPACITY, vector_capacity(v));
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -180,6 +621,41 @@ int main(void)
                                         set_up, tear_down),
         cmocka_unit_test_setup_teardown(add_and_remove_elements_with_3_resizes,
                                         set_up, tear_down),
+        cmocka_unit_test_setup_teardown(insert_sorted_keeps_order,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(insert_sorted_puts_equal_elements_last,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(find_returns_leftmost,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(erase_key_removes_all_equal_elements,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(append_batch_with_resize,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(merge_sorted_bulk_with_resize,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(merge_sorted_bulk_into_empty_vector,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(save_and_map_readonly,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(map_private_is_copy_on_write,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(map_empty_vector,
+                                        set_up, tear_down),
+        cmocka_unit_test(map_invalid_file_returns_error),
+        cmocka_unit_test_setup_teardown(map_rejects_invalid_alignment,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(stats_count_resizes_and_moves,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(default_policy_keeps_capacities,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(hysteresis_policy_delays_shrink,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(never_shrink_policy,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(set_policy_rejects_invalid_factors,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(reserve_and_shrink_to_fit,
+                                        set_up, tear_down),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,401 @@
+/**
+ * @file test_vector_parallel.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include "vector.h"
+#include "vector_parallel.h"
+
+#define __unused __attribute__((unused))
+
+#define ELEMENTS 100003
+
+static int set_up(void **state)
+{
+    *state = vector_pool_create(4);
+    if (*state == NULL)
+        return -1;
+    return 0;
+}
+
+static int tear_down(void **state)
+{
+    vector_pool_destroy(*state);
+    return 0;
+}
+
+static struct vector *create_vector(size_t count)
+{
+    struct vector *v = vector_create(count, sizeof(int64_t));
+    for (size_t i = 0; i < count; i++) {
+        int64_t e = (int64_t) ((i * 7919) % count);
+        vector_set(v, i, &e);
+    }
+    return v;
+}
+
+static void square(void *el, size_t idx, void *arg)
+{
+    (void) arg;
+    *(int64_t *) el = (int64_t) idx * (int64_t) idx;
+}
+
+static void for_each_visits_every_element(void **state)
+{
+    struct vector *v = create_vector(ELEMENTS);
+
+    assert_int_equal(0, vector_parallel_for_each(*state, v, 100, square,
+                                                 NULL));
+    for (size_t i = 0; i < ELEMENTS; i++)
+        assert_int_equal(i * i, *(int64_t *) vector_get(v, i));
+
+    vector_destroy(v);
+}
+
+static void count_visit(void *el, size_t idx, void *arg)
+{
+    unsigned char *visits = el;
+    visits[0] += 1;
+    if (*(size_t *) arg > 1)
+        visits[1] = (unsigned char) idx;
+}
+
+static void for_each_covers_unaligned_chunks(void **state)
+{
+    // odd element sizes whose first cache line boundary is some elements
+    // into the data
+    const size_t sizes[] = {1, 3, 12, 24, 100};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        for (size_t count = 0; count < 300; count += 7) {
+            struct vector *v = vector_create(count, sizes[s]);
+            assert_non_null(v);
+            memset(vector_data(v), 0, count * sizes[s]);
+
+            assert_int_equal(0, vector_parallel_for_each(*state, v, 1,
+                                                         count_visit,
+                                                         (void *) &sizes[s]));
+            for (size_t i = 0; i < count; i++) {
+                unsigned char *visits = vector_get(v, i);
+                assert_int_equal(1, visits[0]);
+                if (sizes[s] > 1)
+                    assert_int_equal((unsigned char) i, visits[1]);
+            }
+
+            vector_destroy(v);
+        }
+    }
+}
+
+static void for_each_without_pool(__unused void **state)
+{
+    struct vector *v = create_vector(1000);
+
+    assert_int_equal(0, vector_parallel_for_each(NULL, v, 0, square, NULL));
+    for (size_t i = 0; i < 1000; i++)
+        assert_int_equal(i * i, *(int64_t *) vector_get(v, i));
+
+    vector_destroy(v);
+}
+
+static void to_int32(const void *in, void *out, void *arg)
+{
+    *(int32_t *) out = (int32_t) (*(int64_t *) in + *(int *) arg);
+}
+
+static void transform_into_other_vector(void **state)
+{
+    struct vector *src = create_vector(ELEMENTS);
+    struct vector *dst = vector_create(ELEMENTS, sizeof(int32_t));
+    int offset = 3;
+
+    assert_int_equal(0, vector_parallel_transform(*state, src, dst, 0,
+                                                  to_int32, &offset));
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        assert_int_equal(*(int64_t *) vector_get(src, i) + 3,
+                         *(int32_t *) vector_get(dst, i));
+    }
+
+    vector_destroy(dst);
+    vector_destroy(src);
+}
+
+static void transform_size_mismatch_returns_error(void **state)
+{
+    struct vector *src = create_vector(10);
+    struct vector *dst = vector_create(11, sizeof(int32_t));
+    int offset = 0;
+
+    assert_int_equal(-EINVAL, vector_parallel_transform(*state, src, dst, 0,
+                                                        to_int32, &offset));
+
+    vector_destroy(dst);
+    vector_destroy(src);
+}
+
+static void sum(void *acc, const void *el, void *arg)
+{
+    (void) arg;
+    *(int64_t *) acc += *(int64_t *) el;
+}
+
+static void add(void *acc, const void *other, void *arg)
+{
+    (void) arg;
+    *(int64_t *) acc += *(int64_t *) other;
+}
+
+static void reduce_sums_all_elements(void **state)
+{
+    struct vector *v = create_vector(ELEMENTS);
+    int64_t result = 0;
+
+    assert_int_equal(0, vector_parallel_reduce(*state, v, 1000, sum, add,
+                                               &result, sizeof(result),
+                                               NULL));
+    assert_int_equal((int64_t) ELEMENTS * (ELEMENTS - 1) / 2, result);
+
+    vector_destroy(v);
+}
+
+static ssize_t compare_int64(const void *x1, const void *x2)
+{
+    int64_t a = *(int64_t *) x1, b = *(int64_t *) x2;
+    return (a > b) - (a < b);
+}
+
+static void sort_orders_elements(void **state)
+{
+    struct vector *v = create_vector(ELEMENTS);
+
+    assert_int_equal(0, vector_parallel_sort(*state, v, 1000, compare_int64));
+    for (size_t i = 0; i < ELEMENTS; i++)
+        assert_int_equal(i, *(int64_t *) vector_get(v, i));
+
+    vector_destroy(v);
+}
+
+// the low bits of every element are the original position
+static ssize_t compare_high(const void *x1, const void *x2)
+{
+    int64_t a = *(int64_t *) x1 >> 20, b = *(int64_t *) x2 >> 20;
+    return (a > b) - (a < b);
+}
+
+static void sort_stable_keeps_order_of_equal(void **state)
+{
+    int64_t *array = malloc(ELEMENTS * sizeof(int64_t));
+    assert_non_null(array);
+    for (size_t i = 0; i < ELEMENTS; i++)
+        array[i] = (int64_t) ((i * 7919) % 13) << 20 | (int64_t) i;
+
+    assert_int_equal(0, vector_parallel_sort_array_stable(*state, array,
+                                                          ELEMENTS,
+                                                          sizeof(int64_t),
+                                                          1000,
+                                                          compare_high));
+    for (size_t i = 1; i < ELEMENTS; i++)
+        assert_true(array[i - 1] < array[i]);
+
+    struct vector *v = create_vector(ELEMENTS);
+    assert_int_equal(0, vector_parallel_sort_stable(*state, v, 0,
+                                                    compare_int64));
+    for (size_t i = 0; i < ELEMENTS; i++)
+        assert_int_equal(i, *(int64_t *) vector_get(v, i));
+
+    vector_destroy(v);
+    free(array);
+}
+
+static void sort_empty_vector(void **state)
+{
+    struct vector *v = vector_create(0, sizeof(int64_t));
+
+    assert_int_equal(0, vector_parallel_sort(*state, v, 0, compare_int64));
+    assert_int_equal(0, vector_size(v));
+
+    vector_destroy(v);
+}
+
+static void search_matches_binary_search(void **state)
+{
+    // every value appears twice, the keys include values not present
+    struct vector *v = vector_create(ELEMENTS, sizeof(int64_t));
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        int64_t e = (int64_t) (i / 2) * 3;
+        vector_set(v, i, &e);
+    }
+
+    struct vector *keys = vector_create(ELEMENTS, sizeof(int64_t));
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        int64_t e = (int64_t) ((i * 7919) % ELEMENTS) * 3 / 2 - 2;
+        vector_set(keys, i, &e);
+    }
+
+    struct vector *results = vector_create(ELEMENTS, sizeof(ssize_t));
+
+    void *pools[] = {*state, NULL};
+    for (size_t p = 0; p < 2; p++) {
+        assert_int_equal(0, vector_parallel_search(pools[p], v, keys,
+                                                   results, 1000,
+                                                   compare_int64));
+        for (size_t i = 0; i < ELEMENTS; i++) {
+            assert_int_equal(binary_search_leftmost(vector_data(v), ELEMENTS,
+                                                    sizeof(int64_t),
+                                                    compare_int64,
+                                                    vector_get(keys, i)),
+                             *(ssize_t *) vector_get(results, i));
+        }
+    }
+
+    vector_destroy(results);
+    vector_destroy(keys);
+    vector_destroy(v);
+}
+
+static void search_invalid_arguments(void **state)
+{
+    struct vector *v = vector_create(0, sizeof(int64_t));
+    struct vector *keys = create_vector(10);
+    struct vector *results = vector_create(10, sizeof(ssize_t));
+    struct vector *short_results = vector_create(9, sizeof(ssize_t));
+
+    assert_int_equal(-EINVAL, vector_parallel_search(*state, v, keys,
+                                                     short_results, 0,
+                                                     compare_int64));
+    assert_int_equal(-EINVAL, vector_parallel_search(*state, v, keys,
+                                                     results, 0, NULL));
+
+    // nothing is found in an empty vector
+    assert_int_equal(0, vector_parallel_search(*state, v, keys, results, 0,
+                                               compare_int64));
+    for (size_t i = 0; i < 10; i++)
+        assert_int_equal(-1, *(ssize_t *) vector_get(results, i));
+
+    vector_destroy(short_results);
+    vector_destroy(results);
+    vector_destroy(keys);
+    vector_destroy(v);
+}
+
+// a read-only mapping of a copy of the vector, the file is removed at once
+static struct vector *map_readonly(struct vector *v)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/test_vector_parallel_%d.bin",
+             (int) getpid());
+
+    assert_int_equal(0, vector_save(v, path));
+    struct vector *m = vector_map(path, VECTOR_MAP_READONLY);
+    unlink(path);
+    assert_non_null(m);
+
+    return m;
+}
+
+static void mutators_reject_readonly_mapping(void **state)
+{
+    struct vector *v = create_vector(1000);
+    struct vector *m = map_readonly(v);
+    struct vector *out = vector_create(1000, sizeof(int32_t));
+
+    assert_int_equal(-EROFS, vector_parallel_for_each(*state, m, 0, square,
+                                                      NULL));
+
+    // a read-only source is fine, a read-only destination isn't
+    int offset = 0;
+    assert_int_equal(0, vector_parallel_transform(*state, m, out, 0,
+                                                  to_int32, &offset));
+    assert_int_equal(-EROFS, vector_parallel_transform(*state, v, m, 0,
+                                                       to_int32, &offset));
+
+    struct vector *results = vector_create(1000, sizeof(ssize_t));
+    struct vector *mapped_results = map_readonly(results);
+    assert_int_equal(0, vector_parallel_search(*state, m, m, results, 0,
+                                               compare_int64));
+    assert_int_equal(-EROFS, vector_parallel_search(*state, v, v,
+                                                    mapped_results, 0,
+                                                    compare_int64));
+
+    assert_int_equal(-EROFS, vector_parallel_sort(*state, m, 0,
+                                                  compare_int64));
+    assert_int_equal(-EROFS, vector_parallel_sort_stable(*state, m, 0,
+                                                         compare_int64));
+    assert_int_equal(-EROFS, vector_parallel_sort(NULL, m, 0, compare_int64));
+
+    for (size_t i = 0; i < 1000; i++)
+        assert_int_equal((i * 7919) % 1000, *(int64_t *) vector_get(m, i));
+
+    vector_destroy(mapped_results);
+    vector_destroy(results);
+    vector_destroy(out);
+    vector_destroy(m);
+    vector_destroy(v);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(for_each_visits_every_element,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(for_each_covers_unaligned_chunks,
+                                        set_up, tear_down),
+        cmocka_unit_test(for_each_without_pool),
+        cmocka_unit_test_setup_teardown(transform_into_other_vector,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(transform_size_mismatch_returns_error,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(reduce_sums_all_elements,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(sort_orders_elements,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(sort_stable_keeps_order_of_equal,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(sort_empty_vector,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(search_matches_binary_search,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(search_invalid_arguments,
+                                        set_up, tear_down),
+        cmocka_unit_test_setup_teardown(mutators_reject_readonly_mapping,
+                                        set_up, tear_down),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
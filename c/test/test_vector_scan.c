@@ -0,0 +1,179 @@
+/**
+ * @file test_vector_scan.c
+ *
+ * Copyright (c) 2020, Jarosław Tomasz Wierzbicki
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <cmocka.h>
+
+#include "vector.h"
+#include "vector_scan.h"
+
+#define __unused __attribute__((unused))
+
+// odd size so that every kernel has to handle a scalar tail
+#define ELEMENTS 1037
+
+static const enum vector_isa isas[] = {
+    VECTOR_ISA_SCALAR, VECTOR_ISA_SSE2, VECTOR_ISA_AVX2,
+};
+
+// values are kept small so that the keys repeat within the vector
+#define CHECK_TYPE(name, T, type) \
+    static void check_##name(void) \
+    { \
+        struct vector *v = vector_create(ELEMENTS, sizeof(T)); \
+        T *data = vector_data(v); \
+        for (size_t i = 0; i < ELEMENTS; i++) \
+            data[i] = (T) ((i * 7919 + 13) % 101) - (T) 50; \
+        data[ELEMENTS - 1] = (T) 77; \
+        \
+        T keys[] = {data[0], data[500], (T) 77, (T) 99}; \
+        \
+        for (size_t a = 0; a < sizeof(isas) / sizeof(isas[0]); a++) { \
+            if (vector_scan_set_isa(isas[a]) != 0) \
+                continue; \
+            for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) { \
+                ssize_t first = -1, count = 0; \
+                for (size_t i = 0; i < ELEMENTS; i++) { \
+                    if (data[i] == keys[k]) { \
+                        first = first < 0 ? (ssize_t) i : first; \
+                        count += 1; \
+                    } \
+                } \
+                assert_int_equal(first, vector_find_eq(v, type, &keys[k])); \
+                assert_int_equal(count, vector_count_eq(v, type, &keys[k])); \
+            } \
+            T min, max; \
+            assert_int_equal(0, vector_minmax(v, type, &min, &max)); \
+            assert_true(min == (T) -50); \
+            assert_true(max == (T) 77); \
+        } \
+        \
+        vector_scan_set_isa(VECTOR_ISA_AUTO); \
+        vector_destroy(v); \
+    }
+
+CHECK_TYPE(int8, int8_t, VECTOR_INT8)
+CHECK_TYPE(int16, int16_t, VECTOR_INT16)
+CHECK_TYPE(int32, int32_t, VECTOR_INT32)
+CHECK_TYPE(int64, int64_t, VECTOR_INT64)
+CHECK_TYPE(float, float, VECTOR_FLOAT)
+CHECK_TYPE(double, double, VECTOR_DOUBLE)
+
+static void signed_types(__unused void **state)
+{
+    check_int8();
+    check_int16();
+    check_int32();
+    check_int64();
+}
+
+static void floating_point_types(__unused void **state)
+{
+    check_float();
+    check_double();
+}
+
+#define CHECK_UNSIGNED_MINMAX(name, T, type) \
+    static void check_minmax_##name(void) \
+    { \
+        struct vector *v = vector_create(ELEMENTS, sizeof(T)); \
+        T *data = vector_data(v); \
+        for (size_t i = 0; i < ELEMENTS; i++) \
+            data[i] = (T) (i * 7919 % 100 + 3); \
+        data[ELEMENTS / 2] = (T) -1; \
+        data[ELEMENTS - 1] = 1; \
+        \
+        for (size_t a = 0; a < sizeof(isas) / sizeof(isas[0]); a++) { \
+            if (vector_scan_set_isa(isas[a]) != 0) \
+                continue; \
+            T min, max; \
+            assert_int_equal(0, vector_minmax(v, type, &min, &max)); \
+            assert_true(min == 1); \
+            assert_true(max == (T) -1); \
+        } \
+        \
+        vector_scan_set_isa(VECTOR_ISA_AUTO); \
+        vector_destroy(v); \
+    }
+
+CHECK_UNSIGNED_MINMAX(uint8, uint8_t, VECTOR_UINT8)
+CHECK_UNSIGNED_MINMAX(uint16, uint16_t, VECTOR_UINT16)
+CHECK_UNSIGNED_MINMAX(uint32, uint32_t, VECTOR_UINT32)
+CHECK_UNSIGNED_MINMAX(uint64, uint64_t, VECTOR_UINT64)
+
+static void unsigned_types_minmax(__unused void **state)
+{
+    check_minmax_uint8();
+    check_minmax_uint16();
+    check_minmax_uint32();
+    check_minmax_uint64();
+}
+
+static void element_size_mismatch_returns_error(__unused void **state)
+{
+    struct vector *v = vector_create(10, sizeof(int32_t));
+    int64_t key = 0;
+
+    assert_int_equal(-EINVAL, vector_find_eq(v, VECTOR_INT64, &key));
+    assert_int_equal(-EINVAL, vector_count_eq(v, VECTOR_INT64, &key));
+    assert_int_equal(-EINVAL, vector_minmax(v, VECTOR_INT64, &key, &key));
+
+    vector_destroy(v);
+}
+
+static void empty_vector(__unused void **state)
+{
+    struct vector *v = vector_create(0, sizeof(int32_t));
+    int32_t key = 0;
+
+    assert_int_equal(-1, vector_find_eq(v, VECTOR_INT32, &key));
+    assert_int_equal(0, vector_count_eq(v, VECTOR_INT32, &key));
+    assert_int_equal(-EINVAL, vector_minmax(v, VECTOR_INT32, &key, &key));
+
+    vector_destroy(v);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(signed_types),
+        cmocka_unit_test(floating_point_types),
+        cmocka_unit_test(unsigned_types_minmax),
+        cmocka_unit_test(element_size_mismatch_returns_error),
+        cmocka_unit_test(empty_vector),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}